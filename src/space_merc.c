@@ -9,6 +9,9 @@ Description: Function definitions for SpaceMerc, a 3D first-person shooter
 *******************************************************************************/
 
 #include "space_merc.h"
+#ifdef VIEW_SLOT_ROUTINES
+#include "view_slot_routines.h"  // Generated (see "wscript").
+#endif
 
 /*******************************************************************************
    Function: set_player_direction
@@ -22,21 +25,31 @@ Description: Sets the player's orientation to a given direction and updates the
 *******************************************************************************/
 void set_player_direction(const int8_t new_direction) {
   g_player->direction = new_direction;
-  switch(new_direction) {
+  gpath_rotate_to(g_compass_path, get_compass_angle(new_direction));
+  layer_mark_dirty(window_get_root_layer(g_graphics_window));
+}
+
+/*******************************************************************************
+   Function: get_compass_angle
+
+Description: Returns the angle by which a compass path must be rotated to point
+             in a given direction.
+
+     Inputs: direction - The direction of interest.
+
+    Outputs: Rotation angle for "gpath_rotate_to".
+*******************************************************************************/
+int32_t get_compass_angle(const int8_t direction) {
+  switch(direction) {
     case NORTH:
-      gpath_rotate_to(g_compass_path, TRIG_MAX_ANGLE / 2);
-      break;
+      return TRIG_MAX_ANGLE / 2;
     case SOUTH:
-      gpath_rotate_to(g_compass_path, 0);
-      break;
+      return 0;
     case EAST:
-      gpath_rotate_to(g_compass_path, TRIG_MAX_ANGLE * 0.75);
-      break;
+      return TRIG_MAX_ANGLE * 0.75;
     default:  // case WEST:
-      gpath_rotate_to(g_compass_path, TRIG_MAX_ANGLE / 4);
-      break;
+      return TRIG_MAX_ANGLE / 4;
   }
-  layer_mark_dirty(window_get_root_layer(g_graphics_window));
 }
 
 /*******************************************************************************
@@ -62,17 +75,22 @@ void move_player(const int8_t direction) {
     }
     g_current_narration = MISSION_CONCLUSION_NARRATION;
     show_narration();
-    persist_delete(MISSION_STORAGE_KEY);
-    persist_write_data(PLAYER_STORAGE_KEY, g_player, sizeof(player_t));
+    delete_record(MISSION_RECORD);
+    delete_record(MISSION_HISTORY_RECORD);
+    delete_record(MISSION_SCRIPT_RECORD);
+    save_record(PLAYER_RECORD, g_player, sizeof(player_t));
   } else if (occupiable(destination)) {
     // Shift the player's position:
     g_player->position = destination;
 
-    // Check for completion of extricate/expropriate missions:
+    // Pick up any human or item (completing extricate/expropriate missions):
     if (get_cell_type(destination) == HUMAN ||
         get_cell_type(destination) == ITEM) {
+      run_mission_script_event(SCRIPT_PICKUP,
+                               get_cell_type(destination),
+                               destination);
       set_cell_type(destination, EMPTY);
-      g_mission->completed = true;
+      save_checkpoint();
     }
     layer_mark_dirty(window_get_root_layer(g_graphics_window));
   }
@@ -99,43 +117,305 @@ void move_npc(npc_t *npc, const int8_t direction) {
 /*******************************************************************************
    Function: determine_npc_behavior
 
-Description: Determines what a given NPC should do.
+Description: Determines what a given NPC should do, based on the squad's shared
+             blackboard (see "update_blackboard"). NPCs attack when they can;
+             otherwise, ranged NPCs take up firing positions to suppress the
+             player while the rest close in, flanking any side already engaged
+             by a squadmate.
 
      Inputs: npc - Pointer to the NPC of interest.
 
     Outputs: None.
 *******************************************************************************/
 void determine_npc_behavior(npc_t *npc) {
-  bool ranged_attack_possible = false;
-  int8_t i,
-         diff_x = npc->position.x - g_player->position.x,
-         diff_y = npc->position.y - g_player->position.y,
-         horizontal_direction,
-         vertical_direction;
-  GPoint cell;
+  int8_t direction, side;
 
-  if (npc->type >= ROBOT && (diff_x == 0 || diff_y == 0)) {
-    i = 0;
-    cell = npc->position;
-    horizontal_direction = diff_x > 0 ? WEST : EAST;
-    vertical_direction = diff_y > 0 ? NORTH : SOUTH;
+  if ((npc->type >= ROBOT && in_line_of_fire(npc->position)) ||
+      touching(npc->position, g_blackboard.player_position)) {
+    g_blackboard.claimed_sides |= 1 << get_side_of_player(npc->position);
+    damage_player(npc->power);
+  } else {
+    direction = get_squad_move_direction(npc);
+    if (direction < 0) {
+      return;  // Holding position.
+    }
+    move_npc(npc, direction);
+
+    // Keep the blackboard current for squadmates yet to act:
+    side = get_side_of_player(npc->position);
+    if (in_line_of_fire(npc->position)) {
+      g_blackboard.los_ranges[side] =
+        abs(npc->position.x - g_blackboard.player_position.x) +
+        abs(npc->position.y - g_blackboard.player_position.y);
+      g_blackboard.claimed_sides |= 1 << side;
+    } else if (touching(npc->position, g_blackboard.player_position)) {
+      g_blackboard.claimed_sides |= 1 << side;
+    }
+  }
+}
+
+/*******************************************************************************
+   Function: update_blackboard
+
+Description: Gathers the perception NPCs share for the current tick: the
+             player's position, how far the player can see (and be shot at)
+             along each row and column, flow fields leading to the player and
+             to those lines of fire, and which sides of the player NPCs
+             already engage.
+
+     Inputs: None.
+
+    Outputs: None.
+*******************************************************************************/
+void update_blackboard(void) {
+  int8_t i, direction, num_firing_positions = 0;
+  GPoint cell, firing_positions[MAX_FIRING_POSITIONS];
+
+  g_blackboard.player_position = g_player->position;
+  compute_distance_field(g_blackboard.distances, &g_player->position, 1);
+  for (direction = 0; direction < NUM_DIRECTIONS; ++direction) {
+    cell = g_player->position;
+    g_blackboard.los_ranges[direction] = 0;
     do {
-      cell = get_cell_farther_away(cell,
-                                   diff_x == 0 ? vertical_direction :
-                                                 horizontal_direction,
-                                   1);
-      if (gpoint_equal(&g_player->position, &cell)) {
-        ranged_attack_possible = true;
-        break;
+      cell = get_cell_farther_away(cell, direction, 1);
+    } while (++g_blackboard.los_ranges[direction] < NPC_ATTACK_RANGE &&
+             occupiable(cell));
+  }
+  g_blackboard.claimed_sides = 0;
+  for (i = 0; i < MAX_NPCS_AT_ONE_TIME; ++i) {
+    if (g_mission->npcs[i].type != NONE &&
+        (touching(g_mission->npcs[i].position, g_player->position) ||
+         (g_mission->npcs[i].type >= ROBOT &&
+          in_line_of_fire(g_mission->npcs[i].position)))) {
+      g_blackboard.claimed_sides |=
+        1 << get_side_of_player(g_mission->npcs[i].position);
+    }
+  }
+
+  // Open lines of fire on sides no squadmate is covering yet:
+  for (direction = 0; direction < NUM_DIRECTIONS; ++direction) {
+    if (g_blackboard.claimed_sides & (1 << direction)) {
+      continue;
+    }
+    cell = g_player->position;
+    for (i = 0; i < g_blackboard.los_ranges[direction]; ++i) {
+      cell = get_cell_farther_away(cell, direction, 1);
+      if (occupiable(cell)) {
+        firing_positions[num_firing_positions++] = cell;
       }
-    }while (occupiable(cell) && ++i < (MAX_VISIBILITY_DEPTH - 2));
+    }
   }
-  if (ranged_attack_possible || touching(npc->position, g_player->position)) {
-    damage_player(npc->power);
-  } else {
-    move_npc(npc, get_pursuit_direction(npc->position,
-                                        g_player->position));
+  compute_distance_field(g_blackboard.firing_distances,
+                         firing_positions,
+                         num_firing_positions);
+}
+
+/*******************************************************************************
+   Function: compute_distance_field
+
+Description: Fills a distance field with the no. of steps from the nearest of
+             a set of origins to every non-solid cell, via breadth-first
+             search. Cells that can't be reached are set to "UNREACHABLE".
+
+     Inputs: distances   - The distance field to be filled.
+             origins     - Coordinates of the cells distances are measured
+                           from.
+             num_origins - No. of origins.
+
+    Outputs: None.
+*******************************************************************************/
+void compute_distance_field(uint8_t distances[][LOCATION_HEIGHT],
+                            const GPoint *origins,
+                            const int8_t num_origins) {
+  uint8_t queue[NUM_CELLS], head = 0, tail = 0;
+  int8_t i, direction;
+  GPoint cell, neighbor;
+
+  memset(distances, UNREACHABLE, NUM_CELLS);
+  for (i = 0; i < num_origins; ++i) {
+    if (!out_of_bounds(origins[i]) &&
+        distances[origins[i].x][origins[i].y] == UNREACHABLE) {
+      distances[origins[i].x][origins[i].y] = 0;
+      queue[tail++] = origins[i].x * LOCATION_HEIGHT + origins[i].y;
+    }
+  }
+  while (head < tail) {
+    cell = GPoint(queue[head] / LOCATION_HEIGHT, queue[head] % LOCATION_HEIGHT);
+    head++;
+    for (direction = 0; direction < NUM_DIRECTIONS; ++direction) {
+      neighbor = get_cell_farther_away(cell, direction, 1);
+      if (get_cell_type(neighbor) < SOLID &&
+          distances[neighbor.x][neighbor.y] == UNREACHABLE) {
+        distances[neighbor.x][neighbor.y] = distances[cell.x][cell.y] + 1;
+        queue[tail++] = neighbor.x * LOCATION_HEIGHT + neighbor.y;
+      }
+    }
+  }
+}
+
+/*******************************************************************************
+   Function: open_exit_path
+
+Description: Updates "g_exit_distances" after a given cell has become passable,
+             lowering the distances of any cells the new opening brings closer
+             to the mission's entrance. Only cells whose distances actually
+             change are visited.
+
+     Inputs: cell - Coordinates of the newly opened cell.
+
+    Outputs: None.
+*******************************************************************************/
+void open_exit_path(const GPoint cell) {
+  uint8_t queue[NUM_CELLS], head = 0, tail = 0, shortest = UNREACHABLE;
+  int8_t direction;
+  GPoint current, neighbor;
+
+  for (direction = 0; direction < NUM_DIRECTIONS; ++direction) {
+    neighbor = get_cell_farther_away(cell, direction, 1);
+    if (!out_of_bounds(neighbor) &&
+        g_exit_distances[neighbor.x][neighbor.y] < shortest) {
+      shortest = g_exit_distances[neighbor.x][neighbor.y];
+    }
   }
+  if (shortest == UNREACHABLE) {
+    return;  // Still cut off from the entrance.
+  }
+  g_exit_distances[cell.x][cell.y] = shortest + 1;
+  queue[tail++] = cell.x * LOCATION_HEIGHT + cell.y;
+  while (head < tail) {
+    current = GPoint(queue[head] / LOCATION_HEIGHT,
+                     queue[head] % LOCATION_HEIGHT);
+    head++;
+    for (direction = 0; direction < NUM_DIRECTIONS; ++direction) {
+      neighbor = get_cell_farther_away(current, direction, 1);
+      if (get_cell_type(neighbor) < SOLID &&
+          g_exit_distances[neighbor.x][neighbor.y] >
+            g_exit_distances[current.x][current.y] + 1) {
+        g_exit_distances[neighbor.x][neighbor.y] =
+          g_exit_distances[current.x][current.y] + 1;
+        queue[tail++] = neighbor.x * LOCATION_HEIGHT + neighbor.y;
+      }
+    }
+  }
+}
+
+/*******************************************************************************
+   Function: get_exit_direction
+
+Description: Determines which way to step from a given cell to get closer to
+             the mission's entrance, according to "g_exit_distances".
+
+     Inputs: cell - Coordinates of the cell of interest.
+
+    Outputs: Direction of the next step toward the entrance, or -1 if there's
+             no such step (at the entrance, or cut off from it).
+*******************************************************************************/
+int8_t get_exit_direction(const GPoint cell) {
+  int8_t direction, exit_direction = -1;
+  uint8_t shortest = g_exit_distances[cell.x][cell.y];
+  GPoint neighbor;
+
+  for (direction = 0; direction < NUM_DIRECTIONS; ++direction) {
+    neighbor = get_cell_farther_away(cell, direction, 1);
+    if (!out_of_bounds(neighbor) &&
+        g_exit_distances[neighbor.x][neighbor.y] < shortest) {
+      shortest = g_exit_distances[neighbor.x][neighbor.y];
+      exit_direction = direction;
+    }
+  }
+
+  return exit_direction;
+}
+
+/*******************************************************************************
+   Function: in_line_of_fire
+
+Description: Determines whether a given cell is in line with the player, within
+             ranged attack range and with nothing in between (according to the
+             blackboard).
+
+     Inputs: cell - Coordinates of the cell of interest.
+
+    Outputs: "True" if an NPC there could shoot the player.
+*******************************************************************************/
+bool in_line_of_fire(const GPoint cell) {
+  const int8_t diff_x = cell.x - g_blackboard.player_position.x,
+               diff_y = cell.y - g_blackboard.player_position.y;
+
+  if ((diff_x == 0) == (diff_y == 0)) {
+    return false;  // Not in line (or the player's own cell).
+  }
+
+  return abs(diff_x + diff_y) <=
+           g_blackboard.los_ranges[get_side_of_player(cell)];
+}
+
+/*******************************************************************************
+   Function: get_side_of_player
+
+Description: Determines which side of the player a given cell is on, judging
+             by whichever axis it's farther away along.
+
+     Inputs: cell - Coordinates of the cell of interest.
+
+    Outputs: Direction of the cell from the player.
+*******************************************************************************/
+int8_t get_side_of_player(const GPoint cell) {
+  const int8_t diff_x = cell.x - g_blackboard.player_position.x,
+               diff_y = cell.y - g_blackboard.player_position.y;
+
+  if (abs(diff_x) > abs(diff_y)) {
+    return diff_x > 0 ? EAST : WEST;
+  }
+
+  return diff_y > 0 ? SOUTH : NORTH;
+}
+
+/*******************************************************************************
+   Function: get_squad_move_direction
+
+Description: Chooses where a given NPC should step, following the blackboard's
+             flow fields: ranged NPCs head for the nearest line of fire on a
+             side not yet covered, the rest toward the player. In the latter
+             case, cells on a side of the player that a squadmate already
+             engages cost "FLANK_PENALTY" extra steps, so the squad spreads
+             out around the player.
+
+     Inputs: npc - Pointer to the NPC of interest.
+
+    Outputs: Direction of the best step, or -1 if the NPC should stay put.
+*******************************************************************************/
+int8_t get_squad_move_direction(const npc_t *npc) {
+  int8_t direction, best_direction = -1;
+  int16_t score, best_score = UNREACHABLE * 2;
+  GPoint cell;
+
+  if (g_blackboard.distances[npc->position.x][npc->position.y] ==
+        UNREACHABLE) {
+    return get_pursuit_direction(npc->position, g_player->position);
+  }
+  for (direction = -1; direction < NUM_DIRECTIONS; ++direction) {
+    cell = direction < 0 ? npc->position :
+                           get_cell_farther_away(npc->position, direction, 1);
+    if (direction >= 0 && !occupiable(cell)) {
+      continue;
+    }
+    if (npc->type >= ROBOT &&
+        g_blackboard.firing_distances[cell.x][cell.y] != UNREACHABLE) {
+      score = g_blackboard.firing_distances[cell.x][cell.y];
+    } else {
+      score = g_blackboard.distances[cell.x][cell.y];
+      if (g_blackboard.claimed_sides & (1 << get_side_of_player(cell))) {
+        score += FLANK_PENALTY;
+      }
+    }
+    if (score < best_score) {
+      best_score = score;
+      best_direction = direction;
+    }
+  }
+
+  return best_direction;
 }
 
 /*******************************************************************************
@@ -174,12 +454,9 @@ void damage_npc(npc_t *npc, const int16_t damage) {
   npc->hp -= damage;
   if (npc->hp <= 0) {
     g_mission->kills++;
-    if ((g_mission->type == ASSASSINATE && npc->type == ALIEN_OFFICER) ||
-        ((g_mission->type == OBLITERATE || g_mission->type == RETALIATE) &&
-         g_mission->kills >= g_mission->total_num_npcs)) {
-      g_mission->completed = true;
-    }
+    run_mission_script_event(SCRIPT_KILL, npc->type, npc->position);
     npc->type = NONE;
+    save_checkpoint();
   }
 }
 
@@ -197,9 +474,11 @@ Description: Damages a given "solid" cell according to a given damage value. If
 *******************************************************************************/
 void damage_cell(GPoint cell, const int16_t damage) {
   if (!out_of_bounds(cell) && get_cell_type(cell) > EMPTY) {
+    record_cell_change(cell);
     g_mission->cells[cell.x][cell.y] -= damage;
     if (get_cell_type(cell) < SOLID) {
       set_cell_type(cell, EMPTY);
+      open_exit_path(cell);
     }
   }
 }
@@ -247,15 +526,53 @@ void adjust_player_current_hp(const int16_t amount) {
   if (g_player->stats[CURRENT_HP] > g_player->stats[MAX_HP]) {
     g_player->stats[CURRENT_HP] = g_player->stats[MAX_HP];
   } else if (g_player->stats[CURRENT_HP] <= 0) {
+    g_game_paused = true;
     show_window(g_main_menu_window);
     g_current_narration = DEATH_NARRATION;
     show_narration();
-    deinit_mission();
-    persist_delete(MISSION_STORAGE_KEY);
-    persist_write_data(PLAYER_STORAGE_KEY, g_player, sizeof(player_t));
+
+    // Unless the main menu can offer a retry from a checkpoint, the mission
+    // is over:
+    if (g_mission_history.num_checkpoints == 0) {
+      abandon_mission();
+    } else {
+      save_record(PLAYER_RECORD, g_player, sizeof(player_t));
+    }
   }
 }
 
+/*******************************************************************************
+   Function: abandon_mission
+
+Description: Ends the current mission without reward (e.g., when the player
+             dies), deleting its saved data.
+
+     Inputs: None.
+
+    Outputs: None.
+*******************************************************************************/
+void abandon_mission(void) {
+  deinit_mission();
+  delete_record(MISSION_RECORD);
+  delete_record(MISSION_HISTORY_RECORD);
+  delete_record(MISSION_SCRIPT_RECORD);
+  save_record(PLAYER_RECORD, g_player, sizeof(player_t));
+}
+
+/*******************************************************************************
+   Function: player_defeated
+
+Description: Determines whether the player has died during the current mission
+             and not yet chosen to retry it from a checkpoint or abandon it.
+
+     Inputs: None.
+
+    Outputs: "True" if the player is awaiting that choice.
+*******************************************************************************/
+bool player_defeated(void) {
+  return g_mission != NULL && g_player->stats[CURRENT_HP] <= 0;
+}
+
 /*******************************************************************************
    Function: adjust_player_current_ammo
 
@@ -302,8 +619,10 @@ void add_new_npc(const int8_t npc_type, const GPoint position) {
    Function: get_npc_spawn_point
 
 Description: Returns a suitable spawn point for a new NPC, outside the player's
-             sphere of visibility. If the algorithm fails to find one, (-1, -1)
-             is returned instead.
+             sphere of visibility. Points between the player and the mission's
+             entrance (i.e., along the player's eventual route out) are
+             preferred. If the algorithm fails to find one, (-1, -1) is
+             returned instead.
 
      Inputs: None.
 
@@ -311,49 +630,69 @@ Description: Returns a suitable spawn point for a new NPC, outside the player's
              algorithm fails to find one.
 *******************************************************************************/
 GPoint get_npc_spawn_point(void) {
-  int8_t i, j, direction;
+  int8_t i, j, direction, pass;
   bool checked_left, checked_right;
   GPoint spawn_point, spawn_point2;
 
-  for (i = 0, direction = rand() % NUM_DIRECTIONS;
-       i < NUM_DIRECTIONS;
-       ++i, direction = (direction + 1 == NUM_DIRECTIONS ? NORTH :
-                                                           direction + 1)) {
-    spawn_point = get_cell_farther_away(g_player->position,
-                                        direction,
-                                        MAX_VISIBILITY_DEPTH);
-    if (out_of_bounds(spawn_point)) {
-      continue;
-    }
-    if (occupiable(spawn_point)) {
-      return spawn_point;
-    }
-    for (j = 1; j < MAX_VISIBILITY_DEPTH - 1; ++j) {
-      checked_left = checked_right = false;
-      do {
-        // Check to the left:
-        if (checked_right || rand() % 2) {
-          spawn_point2 = get_cell_farther_away(spawn_point,
+  for (pass = 0; pass < 2; ++pass) {  // First pass: on the route out only.
+    for (i = 0, direction = rand() % NUM_DIRECTIONS;
+         i < NUM_DIRECTIONS;
+         ++i, direction = (direction + 1 == NUM_DIRECTIONS ? NORTH :
+                                                             direction + 1)) {
+      spawn_point = get_cell_farther_away(g_player->position,
+                                          direction,
+                                          MAX_VISIBILITY_DEPTH);
+      if (out_of_bounds(spawn_point)) {
+        continue;
+      }
+      if (suitable_spawn_point(spawn_point, pass > 0)) {
+        return spawn_point;
+      }
+      for (j = 1; j < MAX_VISIBILITY_DEPTH - 1; ++j) {
+        checked_left = checked_right = false;
+        do {
+          // Check to the left:
+          if (checked_right || rand() % 2) {
+            spawn_point2 = get_cell_farther_away(spawn_point,
                                            get_direction_to_the_left(direction),
                                            j);
-          checked_left = true;
-        // Check to the right:
-        } else if (!checked_right) {
-          spawn_point2 = get_cell_farther_away(spawn_point,
+            checked_left = true;
+          // Check to the right:
+          } else if (!checked_right) {
+            spawn_point2 = get_cell_farther_away(spawn_point,
                                           get_direction_to_the_right(direction),
                                           j);
-          checked_right = true;
-        }
-        if (occupiable(spawn_point2)) {
-          return spawn_point2;
-        }
-      } while (!checked_left || !checked_right);
+            checked_right = true;
+          }
+          if (suitable_spawn_point(spawn_point2, pass > 0)) {
+            return spawn_point2;
+          }
+        } while (!checked_left || !checked_right);
+      }
     }
   }
 
   return GPoint(-1, -1);
 }
 
+/*******************************************************************************
+   Function: suitable_spawn_point
+
+Description: Determines whether an NPC may spawn in a given cell.
+
+     Inputs: cell      - Coordinates of the cell of interest.
+             off_route - If "false", the cell must also be closer to the
+                         mission's entrance than the player is.
+
+    Outputs: "True" if the cell is a suitable spawn point.
+*******************************************************************************/
+bool suitable_spawn_point(const GPoint cell, const bool off_route) {
+  return occupiable(cell) &&
+         (off_route ||
+          g_exit_distances[cell.x][cell.y] <
+            g_exit_distances[g_player->position.x][g_player->position.y]);
+}
+
 /*******************************************************************************
    Function: get_floor_center_point
 
@@ -392,6 +731,91 @@ GPoint get_floor_center_point(const int8_t depth, const int8_t position) {
   return GPoint(x, y);
 }
 
+/*******************************************************************************
+   Function: get_cell_at_view_slot
+
+Description: Returns the coordinates of the cell that appears at a given visual
+             depth and position from the player's point of view. (These may lie
+             out-of-bounds.)
+
+     Inputs: depth    - Front-back visual depth in "g_back_wall_coords".
+             position - Left-right visual position in "g_back_wall_coords".
+
+    Outputs: Coordinates of the cell at the designated view slot.
+*******************************************************************************/
+GPoint get_cell_at_view_slot(const int8_t depth, const int8_t position) {
+  const GPoint cell = get_cell_farther_away(g_player->position,
+                                            g_player->direction,
+                                            depth);
+
+  if (position < STRAIGHT_AHEAD) {
+    return get_cell_farther_away(cell,
+                                 get_direction_to_the_left(g_player->direction),
+                                 STRAIGHT_AHEAD - position);
+  } else if (position > STRAIGHT_AHEAD) {
+    return get_cell_farther_away(cell,
+                                get_direction_to_the_right(g_player->direction),
+                                position - STRAIGHT_AHEAD);
+  }
+
+  return cell;
+}
+
+/*******************************************************************************
+   Function: get_drawing_unit
+
+Description: Returns the reference length used for drawing cell contents at a
+             given visual depth and position (one tenth of the back wall's
+             width, rounded to the nearest pixel).
+
+     Inputs: depth    - Front-back visual depth in "g_back_wall_coords".
+             position - Left-right visual position in "g_back_wall_coords".
+
+    Outputs: The drawing unit, in pixels.
+*******************************************************************************/
+int8_t get_drawing_unit(const int8_t depth, const int8_t position) {
+  const int16_t wall_width =
+    g_back_wall_coords[depth][position][BOTTOM_RIGHT].x -
+    g_back_wall_coords[depth][position][TOP_LEFT].x;
+
+  return wall_width / 10 + (wall_width % 10 >= 5 ? 1 : 0);
+}
+
+/*******************************************************************************
+   Function: get_sprite_bounds
+
+Description: Returns a rectangle enclosing every animation frame of any NPC,
+             HUMAN or ITEM drawn at a given floor center point.
+
+     Inputs: floor_center_point - Floor center point (in screen coordinates)
+                                  of the cell containing the sprite.
+             drawing_unit       - Drawing unit at the cell's depth.
+
+    Outputs: The sprite's bounding rectangle, clipped to the screen.
+*******************************************************************************/
+GRect get_sprite_bounds(const GPoint floor_center_point,
+                        const int8_t drawing_unit) {
+  int16_t left = floor_center_point.x - drawing_unit * 4 - 1,
+          top = floor_center_point.y - drawing_unit * 11,
+          right = floor_center_point.x + drawing_unit * 4 + 2,
+          bottom = floor_center_point.y + drawing_unit / 2 + 2;
+
+  if (left < 0) {
+    left = 0;
+  }
+  if (top < 0) {
+    top = 0;
+  }
+  if (right > SCREEN_WIDTH) {
+    right = SCREEN_WIDTH;
+  }
+  if (bottom > SCREEN_HEIGHT) {
+    bottom = SCREEN_HEIGHT;
+  }
+
+  return GRect(left, top, right - left, bottom - top);
+}
+
 /*******************************************************************************
    Function: get_cell_farther_away
 
@@ -618,6 +1042,117 @@ int8_t get_cell_type(const GPoint cell) {
   return g_mission->cells[cell.x][cell.y];
 }
 
+/*******************************************************************************
+   Function: get_cell_contents_type
+
+Description: Returns the type of whatever should be drawn inside the cell at a
+             given set of coordinates: an NPC type, HUMAN or ITEM.
+
+     Inputs: cell - Coordinates of the cell of interest.
+
+    Outputs: The type of the cell's contents, or EMPTY if there is nothing to
+             draw (including when the cell is solid).
+*******************************************************************************/
+int8_t get_cell_contents_type(const GPoint cell) {
+  const int8_t cell_type = get_cell_type(cell);
+  npc_t *npc;
+
+  if (cell_type == EMPTY) {
+    npc = get_npc_at(cell);
+
+    return npc == NULL ? EMPTY : npc->type;
+  }
+
+  return cell_type < EMPTY ? cell_type : EMPTY;
+}
+
+/*******************************************************************************
+   Function: get_sprite_index
+
+Description: Maps an NPC type, HUMAN or ITEM to its index in
+             "g_num_sprite_frames" and "g_sprite_cache".
+
+     Inputs: content_type - NPC type, HUMAN or ITEM.
+
+    Outputs: The corresponding sprite index.
+*******************************************************************************/
+int8_t get_sprite_index(const int8_t content_type) {
+  if (content_type < EMPTY) {  // HUMAN or ITEM.
+    return NUM_NPC_TYPES + content_type - HUMAN;
+  }
+
+  return content_type;
+}
+
+/*******************************************************************************
+   Function: get_sprite_frame
+
+Description: Determines which animation frame of a given sprite type should be
+             shown right now. All sprites of a type animate in step.
+
+     Inputs: content_type - NPC type, HUMAN or ITEM.
+
+    Outputs: Index of the current animation frame.
+*******************************************************************************/
+int8_t get_sprite_frame(const int8_t content_type) {
+  return (get_time_ms() / SPRITE_FRAME_DURATION) %
+         g_num_sprite_frames[get_sprite_index(content_type)];
+}
+
+/*******************************************************************************
+   Function: sprite_rand
+
+Description: Pseudo-random number generator for sprite color flicker. Unlike
+             "rand()", it is reseeded for every animation frame, so a given
+             frame always looks the same and can be cached.
+
+     Inputs: None.
+
+    Outputs: A pseudo-random value from 0 to 32767.
+*******************************************************************************/
+uint16_t sprite_rand(void) {
+  g_sprite_seed = g_sprite_seed * 1103515245 + 12345;
+
+  return (g_sprite_seed >> 16) & 0x7FFF;
+}
+
+/*******************************************************************************
+   Function: laser_rand
+
+Description: Pseudo-random number generator for NPC laser flicker. It has its
+             own seed, reset with "g_sprite_seed" for every animation frame, so
+             a laser's color doesn't shift the sprite's other random colors.
+
+     Inputs: None.
+
+    Outputs: A pseudo-random value from 0 to 32767.
+*******************************************************************************/
+uint16_t laser_rand(void) {
+  g_laser_seed = g_laser_seed * 1103515245 + 12345;
+
+  return (g_laser_seed >> 16) & 0x7FFF;
+}
+
+/*******************************************************************************
+   Function: get_time_ms
+
+Description: Returns the current time in milliseconds. (Wraps around roughly
+             every seven weeks, which only matters for elapsed-time checks
+             spanning that moment.)
+
+     Inputs: None.
+
+    Outputs: Milliseconds since the epoch, modulo 2^32.
+*******************************************************************************/
+uint32_t get_time_ms(void) {
+  time_t seconds;
+  uint16_t milliseconds;
+
+  time_ms(&seconds, &milliseconds);
+
+  return (uint32_t) seconds * 1000 + milliseconds;
+}
+
 /*******************************************************************************
    Function: set_cell_type
 
@@ -630,6 +1165,7 @@ Description: Sets the cell at a given set of coordinates to a given type.
     Outputs: None.
 *******************************************************************************/
 void set_cell_type(GPoint cell, const int8_t type) {
+  record_cell_change(cell);
   g_mission->cells[cell.x][cell.y] = type;
 }
 
@@ -710,7 +1246,749 @@ bool touching(const GPoint cell, const GPoint cell_2) {
 }
 
 /*******************************************************************************
-   Function: show_narration
+   Function: get_checksum
+
+Description: Computes a 32-bit FNV-1a hash of a block of data.
+
+     Inputs: data - Pointer to the data.
+             size - Size of the data, in bytes.
+
+    Outputs: The data's checksum.
+*******************************************************************************/
+uint32_t get_checksum(const void *data, const uint16_t size) {
+  uint16_t i;
+  uint32_t checksum = 2166136261u;
+
+  for (i = 0; i < size; ++i) {
+    checksum = (checksum ^ ((const uint8_t *) data)[i]) * 16777619u;
+  }
+
+  return checksum;
+}
+
+/*******************************************************************************
+   Function: compress_data
+
+Description: Compresses a block of data into a stream. Each token is either a
+             run of up to "MAX_CODEC_LITERALS" literal bytes (token: count - 1)
+             or a copy of the bytes one or two back, or one or two strides
+             back, which catches flat fills, two-pixel dither patterns and
+             repeated rows or structs alike (token: CODEC_MATCH_FLAG |
+             distance index << CODEC_DISTANCE_SHIFT | length - MIN_CODEC_MATCH,
+             with an extra length byte if all CODEC_LENGTH_MASK bits are set).
+             No working memory is needed beyond the stream's buffer.
+
+     Inputs: data   - Pointer to the data.
+             size   - Size of the data, in bytes.
+             stride - Distance between rows of the data (e.g., a frame
+                      buffer's bytes per row), in bytes.
+             output - Pointer to the stream. Its "total" is the compressed
+                      size once done.
+
+    Outputs: "True" if the whole compressed stream was written.
+*******************************************************************************/
+bool compress_data(const uint8_t *data,
+                   const uint16_t size,
+                   const uint16_t stride,
+                   codec_stream_t *output) {
+  const uint16_t distances[NUM_CODEC_DISTANCES] = {1, 2, stride, stride * 2};
+  int8_t d, best_distance = 0;
+  uint16_t i = 0, length, best_length, num_literals = 0;
+  uint8_t token[2];
+
+  while (true) {
+    // Find the longest match at the current position:
+    best_length = 0;
+    for (d = 0; d < NUM_CODEC_DISTANCES && i < size; ++d) {
+      if (distances[d] > i) {
+        continue;
+      }
+      for (length = 0;
+           length < MAX_CODEC_MATCH && i + length < size &&
+             data[i + length] == data[i + length - distances[d]];
+           ++length);
+      if (length > best_length) {
+        best_length = length;
+        best_distance = d;
+      }
+    }
+
+    // Flush pending literals before a match, when full, or at the end:
+    if (num_literals > 0                    &&
+        (best_length >= MIN_CODEC_MATCH     ||
+         num_literals == MAX_CODEC_LITERALS ||
+         i == size)) {
+      token[0] = num_literals - 1;
+      if (!write_codec_data(output, token, 1) ||
+          !write_codec_data(output, data + i - num_literals, num_literals)) {
+        return false;
+      }
+      num_literals = 0;
+    }
+    if (i == size) {  // Pass on whatever's left in the buffer:
+      return output->transfer == NULL ||
+             output->position == 0    ||
+             output->transfer(output);
+    }
+    if (best_length < MIN_CODEC_MATCH) {
+      num_literals++;
+      i++;
+      continue;
+    }
+
+    // Emit the match:
+    length = best_length - MIN_CODEC_MATCH;
+    token[0] = CODEC_MATCH_FLAG | best_distance << CODEC_DISTANCE_SHIFT |
+               (length < CODEC_LENGTH_MASK ? length : CODEC_LENGTH_MASK);
+    token[1] = length - CODEC_LENGTH_MASK;
+    if (!write_codec_data(output,
+                          token,
+                          length < CODEC_LENGTH_MASK ? 1 : 2)) {
+      return false;
+    }
+    i += best_length;
+  }
+}
+
+/*******************************************************************************
+   Function: decompress_data
+
+Description: Decompresses data compressed by "compress_data" from a stream.
+
+     Inputs: input  - Pointer to the stream.
+             data   - Pointer to where the data should go.
+             size   - Size of the data, in bytes.
+             stride - Distance between rows of the data, as compressed.
+
+    Outputs: "True" if all the data was decompressed (and the stream wasn't
+             found to be corrupt).
+*******************************************************************************/
+bool decompress_data(codec_stream_t *input,
+                     uint8_t *data,
+                     const uint16_t size,
+                     const uint16_t stride) {
+  const uint16_t distances[NUM_CODEC_DISTANCES] = {1, 2, stride, stride * 2};
+  uint16_t i = 0, length, distance;
+  uint8_t token, extra_length;
+
+  while (i < size) {
+    if (input->position < input->end) {  // Saves a call for most tokens.
+      token = input->buffer[input->position++];
+    } else if (!read_codec_data(input, &token, 1)) {
+      return false;
+    }
+    if (token < CODEC_MATCH_FLAG) {
+      length = token + 1;
+      if (length > size - i || !read_codec_data(input, data + i, length)) {
+        return false;
+      }
+      i += length;
+    } else {
+      length = (token & CODEC_LENGTH_MASK) + MIN_CODEC_MATCH;
+      if ((token & CODEC_LENGTH_MASK) == CODEC_LENGTH_MASK) {
+        if (!read_codec_data(input, &extra_length, 1)) {
+          return false;
+        }
+        length += extra_length;
+      }
+      distance = distances[(token & ~CODEC_MATCH_FLAG) >>
+                           CODEC_DISTANCE_SHIFT];
+      if (distance > i || length > size - i) {
+        return false;  // Corrupt.
+      }
+      for (; length > 0; --length, ++i) {
+        data[i] = data[i - distance];
+      }
+    }
+  }
+
+  return true;
+}
+
+/*******************************************************************************
+   Function: write_codec_data
+
+Description: Writes bytes to a stream, having its buffer emptied as it fills.
+
+     Inputs: stream - Pointer to the stream.
+             data   - Pointer to the bytes.
+             size   - No. of bytes.
+
+    Outputs: "True" if the bytes were written (or counted).
+*******************************************************************************/
+bool write_codec_data(codec_stream_t *stream,
+                      const uint8_t *data,
+                      uint16_t size) {
+  uint16_t chunk_size;
+
+  stream->total += size;
+  if (stream->buffer == NULL) {
+    return true;  // Only counting.
+  }
+  while (size > 0) {
+    if (stream->position == stream->buffer_size &&
+        (stream->transfer == NULL || !stream->transfer(stream))) {
+      return false;
+    }
+    chunk_size = stream->buffer_size - stream->position;
+    if (chunk_size > size) {
+      chunk_size = size;
+    }
+    memcpy(stream->buffer + stream->position, data, chunk_size);
+    stream->position += chunk_size;
+    data += chunk_size;
+    size -= chunk_size;
+  }
+
+  return true;
+}
+
+/*******************************************************************************
+   Function: read_codec_data
+
+Description: Reads bytes from a stream, having its buffer refilled as it runs
+             out.
+
+     Inputs: stream - Pointer to the stream.
+             data   - Pointer to where the bytes should go.
+             size   - No. of bytes.
+
+    Outputs: "True" if the bytes were read.
+*******************************************************************************/
+bool read_codec_data(codec_stream_t *stream, uint8_t *data, uint16_t size) {
+  uint16_t chunk_size;
+
+  while (size > 0) {
+    if (stream->position == stream->end &&
+        (stream->transfer == NULL || !stream->transfer(stream))) {
+      return false;
+    }
+    chunk_size = stream->end - stream->position;
+    if (chunk_size > size) {
+      chunk_size = size;
+    }
+    memcpy(data, stream->buffer + stream->position, chunk_size);
+    stream->position += chunk_size;
+    data += chunk_size;
+    size -= chunk_size;
+  }
+
+  return true;
+}
+
+/*******************************************************************************
+   Function: write_record_shard
+
+Description: Empties a record stream's buffer into the next shard of its slot.
+
+     Inputs: stream - Pointer to the stream.
+
+    Outputs: "True" if the shard was written.
+*******************************************************************************/
+bool write_record_shard(codec_stream_t *stream) {
+  if (stream->shard == MAX_SHARDS_PER_RECORD ||
+      persist_write_data(RECORD_SHARD_KEY(stream->record,
+                                          stream->slot,
+                                          stream->shard),
+                         stream->buffer,
+                         stream->position) != stream->position) {
+    return false;
+  }
+  stream->shard++;
+  stream->position = 0;
+
+  return true;
+}
+
+/*******************************************************************************
+   Function: read_record_shard
+
+Description: Refills a record stream's buffer from the next shard of its slot.
+
+     Inputs: stream - Pointer to the stream.
+
+    Outputs: "True" if a non-empty shard was read.
+*******************************************************************************/
+bool read_record_shard(codec_stream_t *stream) {
+  int shard_size;
+
+  if (stream->shard == MAX_SHARDS_PER_RECORD) {
+    return false;
+  }
+  shard_size = persist_read_data(RECORD_SHARD_KEY(stream->record,
+                                                  stream->slot,
+                                                  stream->shard),
+                                 stream->buffer,
+                                 stream->buffer_size);
+  if (shard_size <= 0) {
+    return false;
+  }
+  stream->shard++;
+  stream->position = 0;
+  stream->end = shard_size;
+
+  return true;
+}
+
+/*******************************************************************************
+   Function: read_record_marker
+
+Description: Reads a record's marker. Markers written before records were
+             compressed lack "stored_size", and describe uncompressed records.
+
+     Inputs: record - Record of interest (e.g., PLAYER_RECORD).
+             marker - Pointer to where the marker should go.
+
+    Outputs: "True" if a marker was read.
+*******************************************************************************/
+bool read_record_marker(const int8_t record, record_marker_t *marker) {
+  const int marker_size = persist_read_data(RECORD_MARKER_KEY(record),
+                                            marker,
+                                            sizeof(record_marker_t));
+
+  if (marker_size == offsetof(record_marker_t, stored_size)) {
+    marker->stored_size = marker->size;
+  }
+
+  return marker_size == sizeof(record_marker_t) ||
+         marker_size == offsetof(record_marker_t, stored_size);
+}
+
+/*******************************************************************************
+   Function: get_record_stride
+
+Description: Returns the row stride a record's data is compressed with, chosen
+             to line up whatever repeats within it.
+
+     Inputs: record - Record of interest (e.g., PLAYER_RECORD).
+
+    Outputs: The stride, in bytes.
+*******************************************************************************/
+uint16_t get_record_stride(const int8_t record) {
+  switch (record) {
+    case MISSION_RECORD:
+      return LOCATION_HEIGHT;  // Neighboring columns of cells.
+    case MISSION_HISTORY_RECORD:
+      return sizeof(checkpoint_t);  // Neighboring checkpoints.
+    default:
+      return sizeof(int16_t);  // Stats, stacks and variables.
+  }
+}
+
+/*******************************************************************************
+   Function: load_record
+
+Description: Reads a record from persistent storage. A record is split into
+             shards of up to "RECORD_SHARD_SIZE" bytes, and is only considered
+             saved once its marker (written last) points at a complete set of
+             shards, so a partially written save can never be loaded. The
+             shards are decompressed a shard at a time as they're read.
+
+     Inputs: record - Record of interest (e.g., PLAYER_RECORD).
+             data   - Pointer to where the record's data should go.
+             size   - Expected size of the record, in bytes.
+
+    Outputs: "True" if a complete record of the expected size was loaded.
+*******************************************************************************/
+bool load_record(const int8_t record, void *data, const uint16_t size) {
+  record_marker_t marker;
+  codec_stream_t stream = {
+    .buffer = g_record_buffer,
+    .buffer_size = RECORD_SHARD_SIZE,
+    .transfer = read_record_shard,
+    .record = record,
+  };
+
+  if (!read_record_marker(record, &marker) ||
+      marker.size != size                  ||
+      marker.slot < 0                      ||
+      marker.slot >= NUM_RECORD_SLOTS      ||
+      size > MAX_RECORD_SIZE) {
+    return false;
+  }
+  stream.slot = marker.slot;
+  if (marker.stored_size < size) {
+    if (!decompress_data(&stream, data, size, get_record_stride(record))) {
+      return false;
+    }
+  } else if (!read_codec_data(&stream, data, size)) {
+    return false;
+  }
+
+  return get_checksum(data, size) == marker.checksum;
+}
+
+/*******************************************************************************
+   Function: save_record
+
+Description: Writes a record to persistent storage. The shards go to whichever
+             slot the current marker doesn't point at, and the marker is
+             rewritten last to commit them. If the data hasn't changed since
+             the last save, nothing is written. The data is compressed a shard
+             at a time, unless that wouldn't make it any smaller.
+
+     Inputs: record - Record of interest (e.g., PLAYER_RECORD).
+             data   - Pointer to the record's data.
+             size   - Size of the record, in bytes.
+
+    Outputs: "True" if the record is now saved.
+*******************************************************************************/
+bool save_record(const int8_t record, const void *data, const uint16_t size) {
+  record_marker_t marker;
+  const uint32_t checksum = get_checksum(data, size);
+  const uint16_t stride = get_record_stride(record);
+  codec_stream_t stream = {.buffer = NULL};  // Just measures, to begin with.
+
+  if (size > MAX_RECORD_SIZE) {
+    return false;
+  }
+  if (read_record_marker(record, &marker) &&
+      marker.slot >= 0                      &&
+      marker.slot < NUM_RECORD_SLOTS) {
+    if (marker.size == size && marker.checksum == checksum) {
+      return true;  // Unchanged.
+    }
+    marker.slot = (marker.slot + 1) % NUM_RECORD_SLOTS;
+    marker.generation++;
+  } else {  // No marker, or a corrupt one: start over at the first slot.
+    marker.slot = 0;
+    marker.generation = 0;
+  }
+  compress_data(data, size, stride, &stream);
+  marker.stored_size = stream.total < size ? stream.total : size;
+  stream = (codec_stream_t) {
+    .buffer = g_record_buffer,
+    .buffer_size = RECORD_SHARD_SIZE,
+    .transfer = write_record_shard,
+    .record = record,
+    .slot = marker.slot,
+  };
+  if (marker.stored_size < size) {
+    if (!compress_data(data, size, stride, &stream)) {
+      return false;  // The previously committed save remains intact.
+    }
+  } else if (!write_codec_data(&stream, data, size) ||
+             !write_record_shard(&stream)) {
+    return false;
+  }
+  marker.checksum = checksum;
+  marker.size = size;
+
+  return persist_write_data(RECORD_MARKER_KEY(record),
+                            &marker,
+                            sizeof(record_marker_t)) ==
+           sizeof(record_marker_t);
+}
+
+/*******************************************************************************
+   Function: delete_record
+
+Description: Removes a record from persistent storage. Deleting the marker
+             first invalidates the record at once; its shards are then freed.
+
+     Inputs: record - Record of interest (e.g., MISSION_RECORD).
+
+    Outputs: None.
+*******************************************************************************/
+void delete_record(const int8_t record) {
+  int8_t slot, shard;
+
+  persist_delete(RECORD_MARKER_KEY(record));
+  for (slot = 0; slot < NUM_RECORD_SLOTS; ++slot) {
+    for (shard = 0; shard < MAX_SHARDS_PER_RECORD; ++shard) {
+      if (persist_exists(RECORD_SHARD_KEY(record, slot, shard))) {
+        persist_delete(RECORD_SHARD_KEY(record, slot, shard));
+      }
+    }
+  }
+}
+
+/*******************************************************************************
+   Function: register_cache
+
+Description: Adds a cache to the cache manager, which may evict it when heap
+             space runs low. (The cache must rebuild itself on demand.)
+
+     Inputs: cache    - Cache of interest (e.g., SPRITE_CACHE).
+             evict    - Function that frees everything in the cache.
+             priority - Caches with lower priority values are evicted first.
+
+    Outputs: None.
+*******************************************************************************/
+void register_cache(const int8_t cache,
+                    void (*evict)(void),
+                    const int8_t priority) {
+  g_caches[cache].evict = evict;
+  g_caches[cache].priority = priority;
+  g_caches[cache].size = 0;
+}
+
+/*******************************************************************************
+   Function: update_cache_size
+
+Description: Keeps track of how much heap space a cache holds. Caches must call
+             this whenever they allocate or free memory.
+
+     Inputs: cache  - Cache of interest (e.g., SPRITE_CACHE).
+             change - No. of bytes allocated (positive) or freed (negative).
+
+    Outputs: None.
+*******************************************************************************/
+void update_cache_size(const int8_t cache, const int32_t change) {
+  if (change < 0 && (uint32_t) -change > g_caches[cache].size) {
+    g_caches[cache].size = 0;
+  } else {
+    g_caches[cache].size += change;
+  }
+}
+
+/*******************************************************************************
+   Function: evict_cache
+
+Description: Evicts the lowest-priority non-empty cache whose priority is below
+             a given value.
+
+     Inputs: max_priority - Only caches with lower priority values may be
+                            evicted.
+
+    Outputs: "True" if a cache was evicted.
+*******************************************************************************/
+bool evict_cache(const int8_t max_priority) {
+  int8_t i, victim = -1;
+
+  for (i = 0; i < NUM_CACHES; ++i) {
+    if (g_caches[i].evict != NULL &&
+        g_caches[i].size > 0      &&
+        g_caches[i].priority < max_priority &&
+        (victim < 0 || g_caches[i].priority < g_caches[victim].priority)) {
+      victim = i;
+    }
+  }
+  if (victim < 0) {
+    return false;
+  }
+  g_caches[victim].evict();
+  g_caches[victim].size = 0;
+
+  return true;
+}
+
+/*******************************************************************************
+   Function: reserve_cache_memory
+
+Description: Determines whether a cache may allocate a given amount of memory
+             while leaving "CACHE_HEAP_RESERVE" bytes free, evicting
+             lower-priority caches if necessary. (Nothing is evicted unless
+             evicting would free enough.)
+
+     Inputs: cache - Cache of interest (e.g., SPRITE_CACHE).
+             size  - No. of bytes the cache wants to allocate.
+
+    Outputs: "True" if the cache may go ahead with the allocation.
+*******************************************************************************/
+bool reserve_cache_memory(const int8_t cache, const size_t size) {
+  int8_t i;
+  size_t evictable = 0;
+
+  for (i = 0; i < NUM_CACHES; ++i) {
+    if (g_caches[i].evict != NULL &&
+        g_caches[i].priority < g_caches[cache].priority) {
+      evictable += g_caches[i].size;
+    }
+  }
+  if (heap_bytes_free() + evictable < size + CACHE_HEAP_RESERVE) {
+    return false;
+  }
+  while (heap_bytes_free() < size + CACHE_HEAP_RESERVE) {
+    if (!evict_cache(g_caches[cache].priority)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/*******************************************************************************
+   Function: trim_caches
+
+Description: Evicts caches, lowest priority first, until "CACHE_HEAP_RESERVE"
+             bytes of heap space are free (or no caches remain).
+
+     Inputs: None.
+
+    Outputs: None.
+*******************************************************************************/
+void trim_caches(void) {
+  while (heap_bytes_free() < CACHE_HEAP_RESERVE && evict_cache(MAX_INT8_VALUE));
+}
+
+/*******************************************************************************
+   Function: malloc_with_eviction
+
+Description: Allocates memory, evicting caches (lowest priority first) for as
+             long as the allocation fails.
+
+     Inputs: size - No. of bytes to allocate.
+
+    Outputs: Pointer to the allocated memory, or NULL if there still wasn't
+             enough after evicting every cache.
+*******************************************************************************/
+void *malloc_with_eviction(const size_t size) {
+  void *memory;
+
+  while ((memory = malloc(size)) == NULL && evict_cache(MAX_INT8_VALUE));
+
+  return memory;
+}
+#ifdef HOST_TRACKED_CALLER  // Host tools: credit the caller (see "tools/host").
+#define malloc_with_eviction(size)                                             \
+  HOST_TRACKED_CALLER(malloc_with_eviction(size))
+#endif
+
+/*******************************************************************************
+   Function: get_bitmap_size
+
+Description: Returns the approximate heap space used by a bitmap's pixel data.
+
+     Inputs: bitmap - Pointer to the bitmap of interest.
+
+    Outputs: The bitmap's size, in bytes.
+*******************************************************************************/
+uint32_t get_bitmap_size(const GBitmap *bitmap) {
+  return gbitmap_get_bytes_per_row(bitmap) * gbitmap_get_bounds(bitmap).size.h;
+}
+
+/*******************************************************************************
+   Function: save_checkpoint
+
+Description: Saves the current mission state (apart from the map, whose changes
+             are logged as they happen) as a new checkpoint. If all checkpoint
+             slots are taken, the oldest one after the mission's start is
+             dropped.
+
+     Inputs: None.
+
+    Outputs: None.
+*******************************************************************************/
+void save_checkpoint(void) {
+  if (g_mission_history.num_checkpoints == 0) {
+    return;  // Mission history is unavailable.
+  }
+  if (g_mission_history.num_checkpoints == MAX_CHECKPOINTS) {
+    memmove(&g_mission_history.checkpoints[1],
+            &g_mission_history.checkpoints[2],
+            (MAX_CHECKPOINTS - 2) * sizeof(checkpoint_t));
+    g_mission_history.num_checkpoints--;
+  }
+  capture_checkpoint(
+    &g_mission_history.checkpoints[g_mission_history.num_checkpoints++]);
+}
+
+/*******************************************************************************
+   Function: capture_checkpoint
+
+Description: Copies the current mission state into a given checkpoint and
+             starts a new copy-on-write interval for the map.
+
+     Inputs: checkpoint - Pointer to the checkpoint to be overwritten.
+
+    Outputs: None.
+*******************************************************************************/
+void capture_checkpoint(checkpoint_t *checkpoint) {
+  checkpoint->player_position = g_player->position;
+  checkpoint->player_direction = g_player->direction;
+  checkpoint->player_hp = g_player->stats[CURRENT_HP];
+  checkpoint->player_energy = g_player->stats[CURRENT_ENERGY];
+  checkpoint->kills = g_mission->kills;
+  checkpoint->completed = g_mission->completed;
+  checkpoint->num_cell_deltas = g_mission_history.num_cell_deltas;
+  memcpy(checkpoint->npcs, g_mission->npcs, sizeof(checkpoint->npcs));
+  checkpoint->script_state = g_script_state;
+  memset(g_mission_history.modified_cells,
+         0,
+         sizeof(g_mission_history.modified_cells));
+}
+
+/*******************************************************************************
+   Function: record_cell_change
+
+Description: Must be called before a cell's type is changed. The first time a
+             cell changes after a checkpoint, its original type is appended to
+             the cell delta log (copy-on-write). Should the log fill up, the
+             mission history is discarded.
+
+     Inputs: cell - Coordinates of the cell about to change.
+
+    Outputs: None.
+*******************************************************************************/
+void record_cell_change(const GPoint cell) {
+  const uint8_t index = cell.x * LOCATION_HEIGHT + cell.y;
+
+  if (g_mission_history.num_checkpoints == 0 ||
+      g_mission_history.modified_cells[index / 8] & (1 << (index % 8))) {
+    return;
+  }
+  if (g_mission_history.num_cell_deltas == MAX_CELL_DELTAS) {
+    g_mission_history.num_checkpoints = 0;
+
+    return;
+  }
+  g_mission_history.cell_deltas[g_mission_history.num_cell_deltas++] =
+    (cell_delta_t) {index, get_cell_type(cell)};
+  g_mission_history.modified_cells[index / 8] |= 1 << (index % 8);
+}
+
+/*******************************************************************************
+   Function: rewind_mission
+
+Description: Restores the current mission to a given checkpoint, undoing map
+             changes made since then and discarding any later checkpoints. The
+             player's HP and energy are restored to their values at the time.
+
+     Inputs: checkpoint - Index of the checkpoint of interest (0 restarts the
+                          mission).
+
+    Outputs: "True" if the mission was rewound.
+*******************************************************************************/
+bool rewind_mission(const int8_t checkpoint) {
+  cell_delta_t *cell_delta;
+  const checkpoint_t *saved_state;
+
+  if (g_mission == NULL ||
+      checkpoint < 0    ||
+      checkpoint >= g_mission_history.num_checkpoints) {
+    return false;
+  }
+  saved_state = &g_mission_history.checkpoints[checkpoint];
+
+  // Undo the map changes, most recent first:
+  while (g_mission_history.num_cell_deltas > saved_state->num_cell_deltas) {
+    cell_delta =
+      &g_mission_history.cell_deltas[--g_mission_history.num_cell_deltas];
+    g_mission->cells[cell_delta->index / LOCATION_HEIGHT]
+                    [cell_delta->index % LOCATION_HEIGHT] = cell_delta->type;
+  }
+  memset(g_mission_history.modified_cells,
+         0,
+         sizeof(g_mission_history.modified_cells));
+  g_mission_history.num_checkpoints = checkpoint + 1;
+  compute_distance_field(g_exit_distances, &g_mission->entrance, 1);
+
+  // Restore everything else:
+  memcpy(g_mission->npcs, saved_state->npcs, sizeof(saved_state->npcs));
+  g_mission->kills = saved_state->kills;
+  g_mission->completed = saved_state->completed;
+  g_script_state = saved_state->script_state;
+  g_player->position = saved_state->player_position;
+  set_player_direction(saved_state->player_direction);
+  g_player->stats[CURRENT_HP] = saved_state->player_hp;
+  g_player->stats[CURRENT_ENERGY] = saved_state->player_energy;
+
+  return true;
+}
+
+/*******************************************************************************
+   Function: show_narration
 
 Description: Displays narration text via the narration window according to
              "g_current_narration".
@@ -719,522 +1997,1590 @@ Description: Displays narration text via the narration window according to
 
     Outputs: None.
 *******************************************************************************/
-void show_narration(void) {
-  static char narration_str[NARRATION_STR_LEN + 1];
-  int8_t location = rand() % NUM_LOCATION_TYPES;
+void show_narration(void) {
+  static char narration_str[NARRATION_STR_LEN + 1];
+
+  if (g_current_narration < NUM_MISSION_TYPES) {
+    strcpy(narration_str, "       OBJECTIVE\n");
+    switch (g_current_narration) {
+      case RETALIATE:  // Max. total chars: 78
+        snprintf(narration_str + strlen(narration_str),
+                 NARRATION_STR_LEN - strlen(narration_str) + 1,
+                 "Defend a human %s from %d invading Fim",
+                 g_location_strings[g_mission->location],
+                 (int) g_mission->total_num_npcs);
+        break;
+      case OBLITERATE:  // Max. total chars: 80
+        snprintf(narration_str + strlen(narration_str),
+                 NARRATION_STR_LEN - strlen(narration_str) + 1,
+                 "Eliminate all %d hostiles in this Fim %s",
+                 (int) g_mission->total_num_npcs,
+                 g_location_strings[g_mission->location]);
+        break;
+      case EXPROPRIATE:  // Max. total chars: 71
+        snprintf(narration_str + strlen(narration_str),
+                 NARRATION_STR_LEN - strlen(narration_str) + 1,
+                 "Steal a device from this Fim %s",
+                 g_location_strings[g_mission->location]);
+        break;
+      case EXTRICATE:  // Max. total chars: 80
+        snprintf(narration_str + strlen(narration_str),
+                 NARRATION_STR_LEN - strlen(narration_str) + 1,
+                 "Rescue a human prisoner from this Fim %s",
+                 g_location_strings[g_mission->location]);
+        break;
+      case ASSASSINATE:  // Max. total chars: 78
+        snprintf(narration_str + strlen(narration_str),
+                 NARRATION_STR_LEN - strlen(narration_str) + 1,
+                 "Neutralize the leader of this Fim %s",
+                 g_location_strings[g_mission->location]);
+        break;
+    }
+    snprintf(narration_str + strlen(narration_str),
+             NARRATION_STR_LEN - strlen(narration_str) + 1,
+             " for $%ld.",
+             g_mission->reward);
+  } else if (g_current_narration == MISSION_CONCLUSION_NARRATION) {  // ~77 c.
+    strcpy(narration_str, "          MISSION\n      ");
+    if (g_mission->completed) {
+      strcat(narration_str, "  ");
+    } else {
+      strcat(narration_str, "IN");
+    }
+    snprintf(narration_str + strlen(narration_str),
+             NARRATION_STR_LEN - strlen(narration_str) + 1,
+             "COMPLETE\n\nKills: %d\nRem. Enemies: %d\nReward: $%ld",
+             g_mission->kills,
+             g_mission->total_num_npcs - g_mission->kills,
+             g_mission->completed ? g_mission->reward : 0);
+    deinit_mission();
+  } else {
+    snprintf(narration_str,
+             NARRATION_STR_LEN + 1,
+             g_narration_strings[g_current_narration - NUM_MISSION_TYPES - 1]);
+  }
+  text_layer_set_text(g_narration_text_layer, narration_str);
+  show_window(g_narration_window);
+}
+
+/*******************************************************************************
+   Function: show_window
+
+Description: Displays a given window. (Assumes the window's initialized.)
+
+     Inputs: window - Pointer to the desired window.
+
+    Outputs: None.
+*******************************************************************************/
+void show_window(Window *window) {
+  if (!window_stack_contains_window(window)) {
+    window_stack_push(window, NOT_ANIMATED);
+  } else {
+    while (window_stack_get_top_window() != window) {
+      window_stack_pop(NOT_ANIMATED);
+    }
+  }
+  layer_add_child(window_get_root_layer(window),
+                  status_bar_layer_get_layer(g_status_bar));
+}
+
+/*******************************************************************************
+   Function: main_menu_draw_row_callback
+
+Description: Instructions for drawing each row of the main menu.
+
+     Inputs: ctx        - Pointer to the associated context.
+             cell_layer - Pointer to the layer of the cell to be drawn.
+             cell_index - Pointer to the index struct of the cell to be drawn.
+             data       - Pointer to additional data (not used).
+
+    Outputs: None.
+*******************************************************************************/
+static void main_menu_draw_row_callback(GContext *ctx,
+                                        const Layer *cell_layer,
+                                        MenuIndex *cell_index,
+                                        void *data) {
+  switch (cell_index->row) {
+    case 0:
+      if (player_defeated()) {
+        menu_cell_basic_draw(ctx,
+                             cell_layer,
+                             "Retry Checkpoint",
+                             "Try that again.",
+                             NULL);
+      } else {
+        menu_cell_basic_draw(ctx,
+                             cell_layer,
+                             g_mission == NULL ? "New Mission" :
+                                                 "Continue",
+                             "Grab your gun and go!",
+                             NULL);
+      }
+      break;
+    case 1:
+      if (player_defeated()) {
+        menu_cell_basic_draw(ctx,
+                             cell_layer,
+                             "Abandon Mission",
+                             "Accept defeat.",
+                             NULL);
+      } else if (g_mission != NULL && g_mission_history.num_checkpoints > 0) {
+        menu_cell_basic_draw(ctx,
+                             cell_layer,
+                             "Restart Mission",
+                             "Back to the entrance.",
+                             NULL);
+      } else {
+        menu_cell_basic_draw(ctx,
+                             cell_layer,
+                             "Buy an Upgrade",
+                             g_mission == NULL ? "Improved armor, etc." :
+                                                 "Not during missions!",
+                             NULL);
+      }
+      break;
+    case 2:
+      menu_cell_basic_draw(ctx,
+                           cell_layer,
+                           "Instructions",
+                           "How to play.",
+                           NULL);
+      break;
+    case 3:
+      menu_cell_basic_draw(ctx,
+                           cell_layer,
+                           "About",
+                           "Credits, etc.",
+                           NULL);
+      break;
+    default:
+      menu_cell_basic_draw(ctx,
+                           cell_layer,
+                           g_player->damage_vibes_on ? "Damage Vibes On" :
+                                                       "Damage Vibes Off",
+                           "Vibrate when hit?",
+                           NULL);
+      break;
+  }
+}
+
+/*******************************************************************************
+   Function: main_menu_select_callback
+
+Description: Called when a given cell of the main menu is selected.
+
+     Inputs: menu_layer - Pointer to the menu layer.
+             cell_index - Pointer to the index struct of the selected cell.
+             data       - Pointer to additional data (not used).
+
+    Outputs: None.
+*******************************************************************************/
+void main_menu_select_callback(MenuLayer *menu_layer,
+                               MenuIndex *cell_index,
+                               void *data) {
+  switch (cell_index->row) {
+    case 0:  // New Mission / Continue / Retry Checkpoint
+      if (player_defeated()) {
+        if (rewind_mission(g_mission_history.num_checkpoints - 1)) {
+          show_window(g_graphics_window);
+        } else {  // The mission's history was lost.
+          abandon_mission();
+          menu_layer_reload_data(menu_layer);
+        }
+      } else if (g_mission == NULL) {
+        g_mission = malloc_with_eviction(sizeof(mission_t));
+        if (g_mission != NULL) {
+          init_mission(rand() % NUM_MISSION_TYPES);
+        }
+      } else {
+        show_window(g_graphics_window);
+      }
+      break;
+    case 1:  // Buy an Upgrade / Restart Mission / Abandon Mission
+      if (player_defeated()) {
+        abandon_mission();
+        menu_layer_reload_data(menu_layer);
+      } else if (g_mission == NULL) {
+        menu_layer_set_selected_index(g_upgrade_menu,
+                                      (MenuIndex) {0, 0},
+                                      MenuRowAlignCenter,
+                                      NOT_ANIMATED);
+        show_window(g_upgrade_menu_window);
+      } else if (rewind_mission(0)) {
+        show_window(g_graphics_window);
+      }
+      break;
+    case 2:  // Instructions
+      g_current_narration = INSTRUCTIONS_NARRATION_1;
+      show_narration();
+      break;
+    case 3:  // About
+      g_current_narration = GAME_INFO_NARRATION_1;
+      show_narration();
+      break;
+    default:  // Vibrations On/Off
+      g_player->damage_vibes_on = !g_player->damage_vibes_on;
+      menu_layer_reload_data(menu_layer);
+      break;
+  }
+}
+
+/*******************************************************************************
+   Function: upgrade_menu_draw_header_callback
+
+Description: Instructions for drawing the upgrade menu's header.
+
+     Inputs: ctx           - Pointer to the associated context.
+             cell_layer    - Pointer to the cell layer.
+             section_index - Section number of the header to be drawn.
+             data          - Pointer to additional data (not used).
+
+    Outputs: None.
+*******************************************************************************/
+static void upgrade_menu_draw_header_callback(GContext *ctx,
+                                              const Layer *cell_layer,
+                                              uint16_t section_index,
+                                              void *data) {
+  char header_str[UPGRADE_MENU_HEADER_STR_LEN + 1] = "";
+
+  snprintf(header_str,
+           UPGRADE_MENU_HEADER_STR_LEN + 1,
+           "FUNDS: $%ld",
+           g_player->money);
+  menu_cell_basic_header_draw(ctx, cell_layer, header_str);
+}
+
+/*******************************************************************************
+   Function: upgrade_menu_draw_row_callback
+
+Description: Instructions for drawing a given row of the upgrade menu.
+
+     Inputs: ctx        - Pointer to the associated context.
+             cell_layer - Pointer to the layer of the cell to be drawn.
+             cell_index - Pointer to the index struct of the cell to be drawn.
+             data       - Pointer to additional data (not used).
+
+    Outputs: None.
+*******************************************************************************/
+static void upgrade_menu_draw_row_callback(GContext *ctx,
+                                           const Layer *cell_layer,
+                                           MenuIndex *cell_index,
+                                           void *data) {
+  int16_t new_stat_value;
+  char title_str[UPGRADE_TITLE_STR_LEN + 1] = "",
+       subtitle_str[UPGRADE_SUBTITLE_STR_LEN + 1] = "";
+
+  // Determine the upgrade's title:
+  switch (cell_index->row) {
+    case ARMOR:
+      strcpy(title_str, "Armor");
+      break;
+    case MAX_HP:
+      strcpy(title_str, "Max. Health");
+      break;
+    case POWER:
+      strcpy(title_str, "Laser Power");
+      break;
+    default:  // case MAX_ENERGY:
+      strcpy(title_str, "Max. Energy");
+      break;
+  }
+
+  // Determine the upgrade's subtitle:
+  if (g_player->stats[cell_index->row] >= MAX_SMALL_INT_VALUE) {
+    strcpy(subtitle_str, "9999 (Maxed Out)");
+  } else {
+    new_stat_value = get_upgraded_stat_value(cell_index->row);
+    snprintf(subtitle_str,
+             UPGRADE_SUBTITLE_STR_LEN + 1,
+             "%d->%d $%ld",
+             g_player->stats[cell_index->row],
+             new_stat_value,
+             get_upgrade_cost(new_stat_value));
+  }
+
+  // Finally, draw the upgrade's row in the upgrade menu:
+  menu_cell_basic_draw(ctx, cell_layer, title_str, subtitle_str, NULL);
+}
+
+/*******************************************************************************
+   Function: upgrade_menu_select_callback
+
+Description: Called when a given cell of the upgrade menu is selected.
+
+     Inputs: menu_layer - Pointer to the menu layer.
+             cell_index - Pointer to the index struct of the selected cell.
+             data       - Pointer to additional data (not used).
+
+    Outputs: None.
+*******************************************************************************/
+void upgrade_menu_select_callback(MenuLayer *menu_layer,
+                                  MenuIndex *cell_index,
+                                  void *data) {
+  int16_t new_stat_value;
+
+  if (g_player->stats[cell_index->row] >= MAX_SMALL_INT_VALUE) {
+    return;
+  }
+
+  new_stat_value = get_upgraded_stat_value(cell_index->row);
+  if (adjust_player_money(get_upgrade_cost(new_stat_value) * -1)) {
+    g_player->stats[cell_index->row] = new_stat_value;
+    menu_layer_reload_data(g_upgrade_menu);
+  }
+}
+
+/*******************************************************************************
+   Function: menu_get_header_height_callback
+
+Description: Returns the section height for a given section of a given menu.
+
+     Inputs: menu_layer    - Pointer to the menu of interest.
+             section_index - Section number.
+             data          - Pointer to additional data (not used).
+
+    Outputs: The number of sections in the indicated menu.
+*******************************************************************************/
+static int16_t menu_get_header_height_callback(MenuLayer *menu_layer,
+                                               uint16_t section_index,
+                                               void *data) {
+  return MENU_CELL_BASIC_HEADER_HEIGHT;
+}
+
+/*******************************************************************************
+   Function: menu_get_num_rows_callback
+
+Description: Returns the number of rows in a given menu (or in a given section
+             of a given menu).
+
+     Inputs: menu_layer    - Pointer to the menu of interest.
+             section_index - Section number.
+             data          - Pointer to additional data (not used).
+
+    Outputs: The number of rows in the indicated menu.
+*******************************************************************************/
+static uint16_t menu_get_num_rows_callback(MenuLayer *menu_layer,
+                                           uint16_t section_index,
+                                           void *data) {
+  if (menu_layer == g_main_menu) {
+    return MAIN_MENU_NUM_ROWS;
+  } else {  // menu_layer == g_upgrade_menu
+    return UPGRADE_MENU_NUM_ROWS;
+  }
+}
+
+/*******************************************************************************
+   Function: draw_scene
+
+Description: Draws a (simplistic) 3D scene based on the player's current
+             position, direction, and visibility depth, showing a view
+             rendered ahead of time instead if there is one. (Frames requested
+             by "speculation_timer_callback" render such views.) When only
+             sprites have changed, just the columns they cover are redrawn.
+
+     Inputs: layer - Pointer to the relevant layer.
+             ctx   - Pointer to the relevant graphics context.
+
+    Outputs: None.
+*******************************************************************************/
+void draw_scene(Layer *layer, GContext *ctx) {
+  const uint32_t start_time = get_time_ms();
+#ifdef SPECULATIVE_VIEWS
+  const uint32_t signature = get_scene_signature(g_player->position,
+                                                 g_player->direction);
+  const view_t *view = g_player_animation_mode > 0 ? NULL :
+                                                     get_view(signature);
+  GBitmap *frame_buffer;
+#else
+  const view_t *view = NULL;  // Every frame is rendered afresh.
+#endif
+  bool too_slow;
+
+#ifdef SPECULATIVE_VIEWS
+  // While idle, use the frame to render a view the player may ask for next
+  // (leaving the scene on screen as it was):
+  if (g_speculation_pending) {
+    g_speculation_pending = false;
+    if (signature == g_displayed_signature && !g_input_batch_pending) {
+      if (speculate(ctx, layer_get_bounds(layer))) {
+        schedule_speculation();
+      }
+      return;
+    }
+  }
+
+  // Show the scene from a view rendered ahead of time, if there is one:
+  if (view != NULL &&
+      (frame_buffer = graphics_capture_frame_buffer(ctx)) != NULL) {
+    show_view(frame_buffer, view);
+    graphics_release_frame_buffer(ctx, frame_buffer);
+    g_animated_sprites_visible = false;
+    if (g_static_view != NULL) {
+      g_static_view->on_screen = false;
+    }
+  } else {
+    view = NULL;  // Rendered afresh instead.
+  }
+#endif
+  if (view == NULL) {
+    // Drop to half horizontal resolution during transitions, rapid fire, or
+    // scenes that have proven too slow to draw at full resolution (retrying
+    // full resolution now and then, in case the slow frame was a fluke):
+    too_slow = g_full_res_frame_duration > MAX_FULL_RES_FRAME_DURATION &&
+               start_time < g_full_res_retry_time;
+    g_half_res_mode = g_player_animation_mode > 0      ||
+                      start_time < g_half_res_deadline ||
+                      too_slow;
+
+#ifdef COMPOSITED_SCENES
+    // At full resolution, without weapon fire, build on the static view:
+    if (g_half_res_mode ||
+        g_player_animation_mode > 0 ||
+        !composite_scene(ctx, layer_get_bounds(layer))) {
+      if (g_static_view != NULL) {
+        g_static_view->on_screen = false;
+      }
+      render_scene(ctx, layer_get_bounds(layer));
+    }
+#else
+    render_scene(ctx, layer_get_bounds(layer));
+#endif
+    if (!g_half_res_mode) {
+      g_full_res_frame_duration = get_time_ms() - start_time;
+      g_full_res_retry_time = start_time + FULL_RES_RETRY_INTERVAL;
+    } else if (too_slow && g_half_res_timer == NULL) {
+      g_half_res_timer = app_timer_register(g_full_res_retry_time - start_time,
+                                            half_res_timer_callback,
+                                            NULL);
+    }
+  }
+
+#ifdef SPECULATIVE_VIEWS
+  // Only full-resolution frames without animation may be kept as views:
+  if (view == NULL && (g_half_res_mode || g_animated_sprites_visible)) {
+    g_displayed_signature = NO_SIGNATURE;
+  } else if (signature != g_displayed_signature) {
+    g_displayed_signature = signature;
+    g_speculation_skips = 0;
+  }
+#endif
+
+  // Keep any animated sprites moving:
+  if (g_animated_sprites_visible && g_animation_timer == NULL) {
+    g_animation_timer = app_timer_register(SPRITE_FRAME_DURATION,
+                                           animation_timer_callback,
+                                           NULL);
+  }
+
+  // Now that the latest inputs are on screen, move on to any others:
+  g_input_batch_pending = false;
+  if (g_num_queued_inputs > 0 && g_input_timer == NULL) {
+    g_input_timer = app_timer_register(0, input_timer_callback, NULL);
+  }
+#ifdef SPECULATIVE_VIEWS
+  schedule_speculation();
+#endif
+
+  // Finally, ensure the backlight is on:
+  light_enable_interaction();
+}
+
+/*******************************************************************************
+   Function: render_scene
+
+Description: Renders the scene from the player's current position and
+             direction: walls, cell contents, weapon fire and status meters.
+
+     Inputs: ctx    - Pointer to the relevant graphics context.
+             bounds - Bounds of the graphics window's root layer.
+
+    Outputs: None.
+*******************************************************************************/
+void render_scene(GContext *ctx, const GRect bounds) {
+  g_animated_sprites_visible = false;
+  get_wall_tables();
+
+  // First, draw the background, floor, and ceiling:
+  graphics_context_set_fill_color(ctx, GColorBlack);
+  graphics_fill_rect(ctx, bounds, NO_CORNER_RADIUS, GCornerNone);
+  draw_floor_and_ceiling(ctx);
+
+  // Now draw walls and cell contents:
+  draw_view_slots(ctx);
+
+  if (g_half_res_mode) {
+    double_frame_columns(ctx);
+  }
+
+  // Draw applicable weapon fire:
+  if (g_player_animation_mode > 0) {
+    draw_player_laser_beam(ctx);
+  }
+
+  // Finally, draw the status meters and compass:
+  draw_bottom_status_bar(ctx);
+}
+
+/*******************************************************************************
+   Function: draw_view_slots
+
+Description: Makes a pass, farthest first, over the view slots whose cells are
+             visible from the player's current position and direction,
+             drawing each cell's walls and/or contents as the current scene
+             pass ("g_scene_pass") calls for.
+
+     Inputs: ctx - Pointer to the relevant graphics context.
+
+    Outputs: None.
+*******************************************************************************/
+void draw_view_slots(GContext *ctx) {
+  int8_t i, depth;
+  GPoint cell, cell_2;
+
+  g_view_slot_order = 0;
+  g_num_scene_sprites = 0;
+  for (depth = MAX_VISIBILITY_DEPTH - 2; depth >= 0; --depth) {
+    // Straight ahead at the current depth:
+    cell = get_cell_farther_away(g_player->position,
+                                 g_player->direction,
+                                 depth);
+    if (out_of_bounds(cell)) {
+      continue;
+    }
+    if (get_cell_type(cell) < SOLID) {
+      draw_view_slot(ctx, cell, depth, STRAIGHT_AHEAD);
+    }
+
+    // To the left and right at the same depth:
+    for (i = depth + 1; i > 0; --i) {
+      cell_2 = get_cell_farther_away(cell,
+                                 get_direction_to_the_left(g_player->direction),
+                                 i);
+      if (get_cell_type(cell_2) < SOLID) {
+        draw_view_slot(ctx, cell_2, depth, STRAIGHT_AHEAD - i);
+      }
+      cell_2 = get_cell_farther_away(cell,
+                                get_direction_to_the_right(g_player->direction),
+                                i);
+      if (get_cell_type(cell_2) < SOLID) {
+        draw_view_slot(ctx, cell_2, depth, STRAIGHT_AHEAD + i);
+      }
+    }
+  }
+}
+
+/*******************************************************************************
+   Function: draw_view_slot
+
+Description: Draws the walls and/or contents of the cell at a given view slot,
+             as the current scene pass calls for, numbering the slot in
+             drawing order ("g_view_slot_order"). Builds with
+             "VIEW_SLOT_ROUTINES" defined hand this to the slot's own routine
+             from "g_view_slot_routines", which does the same with the slot's
+             coordinates folded into constants.
+
+     Inputs: ctx      - Pointer to the relevant graphics context.
+             cell     - Coordinates of the cell of interest.
+             depth    - Front-back visual depth of the cell of interest in
+                        "g_back_wall_coords".
+             position - Left-right visual position of the cell of interest in
+                        "g_back_wall_coords".
+
+    Outputs: None.
+*******************************************************************************/
+void draw_view_slot(GContext *ctx,
+                    const GPoint cell,
+                    const int8_t depth,
+                    const int8_t position) {
+#ifdef VIEW_SLOT_ROUTINES
+  g_view_slot_routines[depth][position](ctx, cell);
+#else
+  GPoint floor_center_point;
+
+  g_view_slot_order++;
+  if (g_scene_pass != SPRITE_LIST_PASS) {
+    draw_cell_walls(ctx, cell, depth, position);
+  }
+  floor_center_point = get_floor_center_point(depth, position);
+  floor_center_point.y += STATUS_BAR_HEIGHT;
+  draw_cell_contents(ctx,
+                     cell,
+                     depth,
+                     position,
+                     floor_center_point,
+                     get_drawing_unit(depth, position));
+#endif
+}
+
+/*******************************************************************************
+   Function: draw_bottom_status_bar
+
+Description: Draws the health and energy meters and the compass below the
+             graphics frame.
+
+     Inputs: ctx - Pointer to the relevant graphics context.
+
+    Outputs: None.
+*******************************************************************************/
+void draw_bottom_status_bar(GContext *ctx) {
+  int8_t exit_direction;
+
+  // Health meter:
+  draw_status_meter(ctx,
+                    GPoint (STATUS_METER_PADDING,
+                            GRAPHICS_FRAME_HEIGHT + STATUS_METER_PADDING +
+                              STATUS_BAR_HEIGHT),
+                    (float) g_player->stats[CURRENT_HP] /
+                      g_player->stats[MAX_HP]);
+
+  // Energy (ammo) meter:
+  draw_status_meter(ctx,
+                    GPoint (SCREEN_CENTER_POINT_X + STATUS_METER_PADDING +
+                              COMPASS_RADIUS + 1,
+                            GRAPHICS_FRAME_HEIGHT + STATUS_METER_PADDING +
+                              STATUS_BAR_HEIGHT),
+                    (float) g_player->stats[CURRENT_ENERGY] /
+                      g_player->stats[MAX_ENERGY]);
+
+  // Compass:
+#ifdef PBL_COLOR
+  graphics_context_set_fill_color(ctx, GColorLightGray);
+  graphics_context_set_stroke_color(ctx, GColorDarkGreen);
+#endif
+  graphics_fill_circle(ctx,
+                       GPoint(SCREEN_CENTER_POINT_X,
+                              GRAPHICS_FRAME_HEIGHT + STATUS_BAR_HEIGHT / 2 +
+                                STATUS_BAR_HEIGHT),
+                       COMPASS_RADIUS);
+  graphics_context_set_fill_color(ctx, GColorBlack);
+  gpath_draw_outline(ctx, g_compass_path);
+  gpath_draw_filled(ctx, g_compass_path);
+
+  // Once the objective's complete, also point the way out:
+  if (g_mission->completed) {
+    exit_direction = get_exit_direction(g_player->position);
+    if (exit_direction >= 0) {
+      gpath_rotate_to(g_exit_guidance_path, get_compass_angle(exit_direction));
+#ifdef PBL_COLOR
+      graphics_context_set_fill_color(ctx, GColorRed);
+#else
+      graphics_context_set_fill_color(ctx, GColorWhite);
+#endif
+      gpath_draw_filled(ctx, g_exit_guidance_path);
+    }
+  }
+}
+
+#ifdef COMPOSITED_SCENES
+/*******************************************************************************
+   Function: composite_scene
+
+Description: Draws the scene's sprites over its static view (everything but
+             the sprites), rendering that view first unless it's already kept.
+             While the static view's on screen, only the columns covered by
+             sprites that have moved, changed or gone (and by any sprites
+             overlapping those) are restored and redrawn, so the cost of a
+             frame in which only NPCs have moved scales with their area rather
+             than the screen's. Each sprite redrawn is then cut back, by
+             restoring the static view, wherever a nearer wall covers it.
+
+     Inputs: ctx    - Pointer to the relevant graphics context.
+             bounds - Bounds of the graphics window's root layer.
+
+    Outputs: "True" if the scene was drawn, "false" if there wasn't enough
+             memory to keep its static view (in which case it must be drawn
+             by "render_scene").
+*******************************************************************************/
+bool composite_scene(GContext *ctx, const GRect bounds) {
+  int8_t i, j, num_previous_sprites;
+  int16_t x, left, right;
+  bool dirty_columns[GRAPHICS_FRAME_WIDTH], dirty_spread;
+  const scene_sprite_t *sprite;
+  GBitmap *frame_buffer;
+
+  // Render the static view, or list the sprites that belong over it:
+  g_animated_sprites_visible = false;
+  get_wall_tables();
+  if (g_static_view == NULL ||
+      g_static_view->signature != get_static_signature()) {
+    if (!render_static_view(ctx, bounds)) {
+      return false;
+    }
+  } else {
+    g_scene_pass = SPRITE_LIST_PASS;
+    draw_view_slots(ctx);
+    g_scene_pass = FULL_SCENE_PASS;
+  }
+
+  // Find the columns to be redrawn: all of them if anything else has been
+  // drawn over the static view, otherwise those of any sprite that has moved,
+  // changed or gone, or that reaches the bottom status bar (which is redrawn
+  // regardless):
+  memset(dirty_columns, !g_static_view->on_screen, sizeof(dirty_columns));
+  num_previous_sprites = g_static_view->on_screen ?
+                           g_static_view->num_sprites : 0;
+  for (i = 0; i < num_previous_sprites; ++i) {
+    for (j = 0;
+         j < g_num_scene_sprites &&
+           !scene_sprites_match(&g_static_view->sprites[i],
+                                &g_static_view->scene_sprites[j]);
+         ++j);
+    if (j == g_num_scene_sprites) {
+      mark_dirty_columns(dirty_columns, g_static_view->sprites[i].bounds);
+    }
+  }
+  for (i = 0; i < g_num_scene_sprites; ++i) {
+    sprite = &g_static_view->scene_sprites[i];
+    for (j = 0;
+         j < num_previous_sprites &&
+           !scene_sprites_match(&g_static_view->sprites[j], sprite);
+         ++j);
+    if (j == num_previous_sprites ||
+        sprite->bounds.origin.y + sprite->bounds.size.h >
+          BOTTOM_STATUS_BAR_TOP) {
+      mark_dirty_columns(dirty_columns, sprite->bounds);
+    }
+  }
+
+  // Any sprite overlapping those columns must be redrawn in full, which may
+  // take in further sprites:
+  do {
+    dirty_spread = false;
+    for (i = 0; i < g_num_scene_sprites; ++i) {
+      sprite = &g_static_view->scene_sprites[i];
+      if (overlaps_dirty_columns(dirty_columns, sprite->bounds) &&
+          mark_dirty_columns(dirty_columns, sprite->bounds)) {
+        dirty_spread = true;
+      }
+    }
+  } while (dirty_spread);
+
+  // Restore the static view in those columns and below the graphics frame:
+  if ((frame_buffer = graphics_capture_frame_buffer(ctx)) == NULL) {
+    return false;
+  }
+  for (left = 0; left < GRAPHICS_FRAME_WIDTH; left = right + 1) {
+    for (; left < GRAPHICS_FRAME_WIDTH && !dirty_columns[left]; ++left);
+    for (right = left;
+         right + 1 < GRAPHICS_FRAME_WIDTH && dirty_columns[right + 1];
+         ++right);
+    if (left < GRAPHICS_FRAME_WIDTH) {
+      restore_static_columns(frame_buffer,
+                             left,
+                             right,
+                             STATUS_BAR_HEIGHT,
+                             BOTTOM_STATUS_BAR_TOP - 1);
+    }
+  }
+  restore_static_columns(frame_buffer,
+                         0,
+                         GRAPHICS_FRAME_WIDTH - 1,
+                         BOTTOM_STATUS_BAR_TOP,
+                         SCREEN_HEIGHT - 1);
+  graphics_release_frame_buffer(ctx, frame_buffer);
+
+  // Redraw the sprites in those columns, farthest first, each cut back where
+  // a wall drawn after it (i.e., a nearer one) covers it:
+  for (i = 0; i < g_num_scene_sprites; ++i) {
+    sprite = &g_static_view->scene_sprites[i];
+    if (!overlaps_dirty_columns(dirty_columns, sprite->bounds)) {
+      continue;
+    }
+    draw_sprite_frame(ctx,
+                      sprite->content_type,
+                      sprite->depth,
+                      sprite->position,
+                      sprite->floor_center_point,
+                      sprite->frame);
+    frame_buffer = NULL;
+    right = sprite->bounds.origin.x + sprite->bounds.size.w - 1;
+    if (right >= GRAPHICS_FRAME_WIDTH) {
+      right = GRAPHICS_FRAME_WIDTH - 1;
+    }
+    for (x = sprite->bounds.origin.x < 0 ? 0 : sprite->bounds.origin.x;
+         x <= right;
+         ++x) {
+      if (g_static_view->wall_orders[x] <= sprite->order) {
+        continue;
+      }
+      for (left = x;
+           x < right && g_static_view->wall_orders[x + 1] > sprite->order;
+           ++x);
+      if (frame_buffer == NULL &&
+          (frame_buffer = graphics_capture_frame_buffer(ctx)) == NULL) {
+        return false;
+      }
+      restore_static_columns(frame_buffer,
+                             left,
+                             x,
+                             sprite->bounds.origin.y,
+                             sprite->bounds.origin.y +
+                               sprite->bounds.size.h - 1);
+    }
+    if (frame_buffer != NULL) {
+      graphics_release_frame_buffer(ctx, frame_buffer);
+    }
+  }
+
+  // Finally, draw the status meters and compass, and note what's on screen:
+  draw_bottom_status_bar(ctx);
+  memcpy(g_static_view->sprites,
+         g_static_view->scene_sprites,
+         g_num_scene_sprites * sizeof(scene_sprite_t));
+  g_static_view->num_sprites = g_num_scene_sprites;
+  g_static_view->on_screen = true;
+
+  return true;
+}
+
+/*******************************************************************************
+   Function: render_static_view
+
+Description: Renders the scene without its sprites and keeps the result as the
+             static view, along with the drawing order of the nearest wall in
+             each column and a list of the sprites.
+
+     Inputs: ctx    - Pointer to the relevant graphics context.
+             bounds - Bounds of the graphics window's root layer.
+
+    Outputs: "True" if the static view was kept (in which case it's also on
+             screen, without sprites).
+*******************************************************************************/
+bool render_static_view(GContext *ctx, const GRect bounds) {
+  uint16_t bytes_per_row, size;
+  GBitmap *frame_buffer;
+
+  // Make room for the view, if there isn't any yet:
+  if (g_static_view == NULL) {
+    if ((frame_buffer = graphics_capture_frame_buffer(ctx)) == NULL) {
+      return false;
+    }
+    size = (SCREEN_HEIGHT - STATUS_BAR_HEIGHT) *
+           gbitmap_get_bytes_per_row(frame_buffer);
+    graphics_release_frame_buffer(ctx, frame_buffer);
+    if (!reserve_cache_memory(STATIC_VIEW_CACHE,
+                              sizeof(static_view_t) + size) ||
+        (g_static_view = malloc(sizeof(static_view_t) + size)) == NULL) {
+      return false;
+    }
+    g_static_view->size = size;
+    update_cache_size(STATIC_VIEW_CACHE, sizeof(static_view_t) + size);
+  }
+  g_static_view->signature = NO_SIGNATURE;  // Until it's complete.
+  g_static_view->on_screen = false;
+
+  // Draw the background, floor, ceiling and walls:
+  memset(g_static_view->wall_orders, 0, sizeof(g_static_view->wall_orders));
+  graphics_context_set_fill_color(ctx, GColorBlack);
+  graphics_fill_rect(ctx, bounds, NO_CORNER_RADIUS, GCornerNone);
+  draw_floor_and_ceiling(ctx);
+  g_scene_pass = STATIC_SCENE_PASS;
+  draw_view_slots(ctx);
+  g_scene_pass = FULL_SCENE_PASS;
+
+  // Keep the result:
+  if ((frame_buffer = graphics_capture_frame_buffer(ctx)) == NULL) {
+    return false;
+  }
+  bytes_per_row = gbitmap_get_bytes_per_row(frame_buffer);
+  memcpy(g_static_view->data,
+         gbitmap_get_data(frame_buffer) + STATUS_BAR_HEIGHT * bytes_per_row,
+         g_static_view->size);
+  graphics_release_frame_buffer(ctx, frame_buffer);
+  g_static_view->signature = get_static_signature();
+  g_static_view->num_sprites = 0;
+  g_static_view->on_screen = true;
+
+  return true;
+}
+
+/*******************************************************************************
+   Function: get_static_signature
+
+Description: Identifies the scene as it would look, sprites aside, from the
+             player's current position and direction.
+
+     Inputs: None.
+
+    Outputs: The static scene's signature (never NO_SIGNATURE).
+*******************************************************************************/
+uint32_t get_static_signature(void) {
+  static_scene_key_t key;
+  uint32_t signature;
+
+  key.position = g_player->position;
+  key.entrance = g_mission->entrance;
+  key.direction = g_player->direction;
+  key.entrance_direction = g_mission->entrance_direction;
+#ifdef PBL_COLOR
+  key.floor_color_scheme = g_mission->floor_color_scheme;
+  key.wall_color_scheme = g_mission->wall_color_scheme;
+#endif
+  key.location = g_mission->location;
+  key.cells_checksum = get_checksum(g_mission->cells,
+                                    sizeof(g_mission->cells));
+  signature = get_checksum(&key, sizeof(static_scene_key_t));
+
+  return signature == NO_SIGNATURE ? signature + 1 : signature;
+}
+
+/*******************************************************************************
+   Function: mark_dirty_columns
+
+Description: Marks the graphics frame's columns spanned by a given rectangle
+             as needing to be redrawn.
+
+     Inputs: dirty_columns - Array of flags, one per column.
+             bounds        - The rectangle (may extend off screen).
+
+    Outputs: "True" if any column wasn't marked already.
+*******************************************************************************/
+bool mark_dirty_columns(bool *dirty_columns, const GRect bounds) {
+  int16_t x = bounds.origin.x < 0 ? 0 : bounds.origin.x;
+  bool marked = false;
+
+  for (; x < bounds.origin.x + bounds.size.w && x < GRAPHICS_FRAME_WIDTH; ++x) {
+    if (!dirty_columns[x]) {
+      dirty_columns[x] = marked = true;
+    }
+  }
+
+  return marked;
+}
+
+/*******************************************************************************
+   Function: overlaps_dirty_columns
+
+Description: Determines whether a given rectangle spans any of the graphics
+             frame's columns that need to be redrawn.
+
+     Inputs: dirty_columns - Array of flags, one per column.
+             bounds        - The rectangle (may extend off screen).
+
+    Outputs: "True" if the rectangle spans a marked column.
+*******************************************************************************/
+bool overlaps_dirty_columns(const bool *dirty_columns, const GRect bounds) {
+  int16_t x = bounds.origin.x < 0 ? 0 : bounds.origin.x;
+
+  for (; x < bounds.origin.x + bounds.size.w && x < GRAPHICS_FRAME_WIDTH; ++x) {
+    if (dirty_columns[x]) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/*******************************************************************************
+   Function: scene_sprites_match
+
+Description: Determines whether two scene sprites look the same and are drawn
+             at the same view slot.
+
+     Inputs: sprite_1 - Pointer to the first scene sprite.
+             sprite_2 - Pointer to the second scene sprite.
+
+    Outputs: "True" if they match.
+*******************************************************************************/
+bool scene_sprites_match(const scene_sprite_t *sprite_1,
+                         const scene_sprite_t *sprite_2) {
+  return sprite_1->content_type == sprite_2->content_type &&
+         sprite_1->depth == sprite_2->depth               &&
+         sprite_1->position == sprite_2->position         &&
+         sprite_1->frame == sprite_2->frame;
+}
+
+/*******************************************************************************
+   Function: restore_static_columns
+
+Description: Copies a block of the static view back into the frame buffer.
+
+     Inputs: frame_buffer - Pointer to the captured frame buffer.
+             left         - First screen column of the block.
+             right        - Last screen column of the block.
+             top          - First screen row of the block (clipped to the
+                            static view).
+             bottom       - Last screen row of the block (likewise).
+
+    Outputs: None.
+*******************************************************************************/
+void restore_static_columns(GBitmap *frame_buffer,
+                            const int16_t left,
+                            const int16_t right,
+                            int16_t top,
+                            int16_t bottom) {
+  const uint16_t bytes_per_row = gbitmap_get_bytes_per_row(frame_buffer);
+  const uint8_t *static_row;
+  uint8_t *row;
+  int16_t y;
+
+  if (top < STATUS_BAR_HEIGHT) {
+    top = STATUS_BAR_HEIGHT;
+  }
+  if (bottom >= SCREEN_HEIGHT) {
+    bottom = SCREEN_HEIGHT - 1;
+  }
+  for (y = top; y <= bottom; ++y) {
+    row = gbitmap_get_data(frame_buffer) + y * bytes_per_row;
+    static_row = g_static_view->data + (y - STATUS_BAR_HEIGHT) * bytes_per_row;
+    memcpy(row + left, static_row + left, right - left + 1);
+  }
+}
+#endif
 
-  if (g_current_narration < NUM_MISSION_TYPES) {
-    strcpy(narration_str, "       OBJECTIVE\n");
-    switch (g_current_narration) {
-      case RETALIATE:  // Max. total chars: 78
-        snprintf(narration_str + strlen(narration_str),
-                 NARRATION_STR_LEN - strlen(narration_str) + 1,
-                 "Defend a human %s from %d invading Fim",
-                 g_location_strings[location],
-                 (int) g_mission->total_num_npcs);
-        break;
-      case OBLITERATE:  // Max. total chars: 80
-        snprintf(narration_str + strlen(narration_str),
-                 NARRATION_STR_LEN - strlen(narration_str) + 1,
-                 "Eliminate all %d hostiles in this Fim %s",
-                 (int) g_mission->total_num_npcs,
-                 g_location_strings[location]);
-        break;
-      case EXPROPRIATE:  // Max. total chars: 71
-        snprintf(narration_str + strlen(narration_str),
-                 NARRATION_STR_LEN - strlen(narration_str) + 1,
-                 "Steal a device from this Fim %s",
-                 g_location_strings[location]);
-        break;
-      case EXTRICATE:  // Max. total chars: 80
-        snprintf(narration_str + strlen(narration_str),
-                 NARRATION_STR_LEN - strlen(narration_str) + 1,
-                 "Rescue a human prisoner from this Fim %s",
-                 g_location_strings[location]);
-        break;
-      case ASSASSINATE:  // Max. total chars: 78
-        snprintf(narration_str + strlen(narration_str),
-                 NARRATION_STR_LEN - strlen(narration_str) + 1,
-                 "Neutralize the leader of this Fim %s",
-                 g_location_strings[location]);
-        break;
+/*******************************************************************************
+   Function: draw_player_laser_beam
+
+Description: Draws the player's laser beam onto the screen.
+
+     Inputs: ctx - Pointer to the relevant graphics context.
+
+    Outputs: None.
+*******************************************************************************/
+void draw_player_laser_beam(GContext *ctx) {
+  int8_t i;
+
+#ifdef PBL_COLOR
+  graphics_context_set_stroke_color(ctx, RANDOM_BRIGHT_COLOR);
+#else
+  graphics_context_set_stroke_color(ctx, GColorWhite);
+#endif
+  graphics_draw_line(ctx,
+                     GPoint(SCREEN_CENTER_POINT_X,
+                            GRAPHICS_FRAME_HEIGHT + STATUS_BAR_HEIGHT),
+                     GPoint(SCREEN_CENTER_POINT.x,
+                            SCREEN_CENTER_POINT_Y + STATUS_BAR_HEIGHT));
+  for (i = 0; i <= g_laser_base_width / 2; ++i) {
+#ifdef PBL_COLOR
+    graphics_context_set_stroke_color(ctx, RANDOM_BRIGHT_COLOR);
+#else
+    if (i == g_laser_base_width / 2) {
+      graphics_context_set_stroke_color(ctx, GColorBlack);
     }
-    snprintf(narration_str + strlen(narration_str),
-             NARRATION_STR_LEN - strlen(narration_str) + 1,
-             " for $%ld.",
-             g_mission->reward);
-  } else if (g_current_narration == MISSION_CONCLUSION_NARRATION) {  // ~77 c.
-    strcpy(narration_str, "          MISSION\n      ");
-    if (g_mission->completed) {
-      strcat(narration_str, "  ");
-    } else {
-      strcat(narration_str, "IN");
+#endif
+    graphics_draw_line(ctx,
+                       GPoint(SCREEN_CENTER_POINT_X - i,
+                              GRAPHICS_FRAME_HEIGHT + STATUS_BAR_HEIGHT),
+                       GPoint(SCREEN_CENTER_POINT_X - i / 3,
+                              SCREEN_CENTER_POINT_Y + STATUS_BAR_HEIGHT));
+    graphics_draw_line(ctx,
+                       GPoint(SCREEN_CENTER_POINT_X + i,
+                              GRAPHICS_FRAME_HEIGHT + STATUS_BAR_HEIGHT),
+                       GPoint(SCREEN_CENTER_POINT_X + i / 3,
+                              SCREEN_CENTER_POINT_Y + STATUS_BAR_HEIGHT));
+  }
+}
+
+/*******************************************************************************
+   Function: draw_floor_and_ceiling
+
+Description: Draws the floor and ceiling.
+
+     Inputs: ctx - Pointer to the relevant graphics context.
+
+    Outputs: None.
+*******************************************************************************/
+void draw_floor_and_ceiling(GContext *ctx) {
+  uint8_t x, y, max_y, shading_offset;
+  const uint8_t column_width = g_half_res_mode ? 2 : 1;
+
+  max_y = g_back_wall_coords[MAX_VISIBILITY_DEPTH - 2][0][TOP_LEFT].y;
+#ifdef PBL_BW
+  graphics_context_set_stroke_color(ctx, GColorWhite);
+#endif
+  for (y = 0; y < max_y; ++y) {
+    // Determine horizontal distance between points:
+    shading_offset = 1 + y / MAX_VISIBILITY_DEPTH;
+    if (y % MAX_VISIBILITY_DEPTH >= MAX_VISIBILITY_DEPTH / 2 +
+                                    MAX_VISIBILITY_DEPTH % 2) {
+      shading_offset++;
+    }
+#ifdef PBL_COLOR
+    graphics_context_set_stroke_color(ctx,
+      g_background_colors[g_mission->floor_color_scheme]
+                         [shading_offset > NUM_BACKGROUND_COLORS_PER_SCHEME ?
+                            NUM_BACKGROUND_COLORS_PER_SCHEME - 1            :
+                            shading_offset - 1]);
+#endif
+    for (x = y % 2 ? 0 : (shading_offset / 2) + (shading_offset % 2);
+         x < GRAPHICS_FRAME_WIDTH / column_width;
+         x += shading_offset) {
+      // Draw one point on the ceiling and another on the floor:
+      graphics_draw_pixel(ctx, GPoint(x * column_width,
+                                      y + STATUS_BAR_HEIGHT));
+      graphics_draw_pixel(ctx, GPoint(x * column_width,
+                                      GRAPHICS_FRAME_HEIGHT - y +
+                                        STATUS_BAR_HEIGHT));
     }
-    snprintf(narration_str + strlen(narration_str),
-             NARRATION_STR_LEN - strlen(narration_str) + 1,
-             "COMPLETE\n\nKills: %d\nRem. Enemies: %d\nReward: $%ld",
-             g_mission->kills,
-             g_mission->total_num_npcs - g_mission->kills,
-             g_mission->completed ? g_mission->reward : 0);
-    deinit_mission();
-  } else {
-    snprintf(narration_str,
-             NARRATION_STR_LEN + 1,
-             g_narration_strings[g_current_narration - NUM_MISSION_TYPES - 1]);
   }
-  text_layer_set_text(g_narration_text_layer, narration_str);
-  show_window(g_narration_window);
 }
 
 /*******************************************************************************
-   Function: show_window
+   Function: double_frame_columns
 
-Description: Displays a given window. (Assumes the window's initialized.)
+Description: Completes a half-resolution scene by copying each even column of
+             the graphics frame into the odd column to its right.
 
-     Inputs: window - Pointer to the desired window.
+     Inputs: ctx - Pointer to the relevant graphics context.
 
     Outputs: None.
 *******************************************************************************/
-void show_window(Window *window) {
-  if (!window_stack_contains_window(window)) {
-    window_stack_push(window, NOT_ANIMATED);
-  } else {
-    while (window_stack_get_top_window() != window) {
-      window_stack_pop(NOT_ANIMATED);
+void double_frame_columns(GContext *ctx) {
+  int16_t x, y;
+  uint8_t *row;
+  GBitmap *frame_buffer = graphics_capture_frame_buffer(ctx);
+
+  if (frame_buffer == NULL) {
+    return;
+  }
+  for (y = STATUS_BAR_HEIGHT;
+       y <= GRAPHICS_FRAME_HEIGHT + STATUS_BAR_HEIGHT;
+       ++y) {
+    row = gbitmap_get_data(frame_buffer) +
+      y * gbitmap_get_bytes_per_row(frame_buffer);
+#ifdef PBL_COLOR
+    for (x = 0; x < GRAPHICS_FRAME_WIDTH; x += 2) {
+      row[x + 1] = row[x];
     }
+#else
+    // Eight pixels per byte, leftmost in the least significant bit:
+    for (x = 0; x < GRAPHICS_FRAME_WIDTH / 8; ++x) {
+      row[x] = (row[x] & 0x55) | ((row[x] & 0x55) << 1);
+    }
+#endif
   }
-  layer_add_child(window_get_root_layer(window),
-                  status_bar_layer_get_layer(g_status_bar));
+  graphics_release_frame_buffer(ctx, frame_buffer);
 }
 
 /*******************************************************************************
-   Function: main_menu_draw_row_callback
+   Function: start_half_res_transition
 
-Description: Instructions for drawing each row of the main menu.
+Description: Renders the scene at half horizontal resolution for a short while
+             (e.g., while the player is moving), then redraws it at full
+             resolution.
 
-     Inputs: ctx        - Pointer to the associated context.
-             cell_layer - Pointer to the layer of the cell to be drawn.
-             cell_index - Pointer to the index struct of the cell to be drawn.
-             data       - Pointer to additional data (not used).
+     Inputs: None.
 
     Outputs: None.
 *******************************************************************************/
-static void main_menu_draw_row_callback(GContext *ctx,
-                                        const Layer *cell_layer,
-                                        MenuIndex *cell_index,
-                                        void *data) {
-  switch (cell_index->row) {
-    case 0:
-      menu_cell_basic_draw(ctx,
-                           cell_layer,
-                           g_mission == NULL ? "New Mission" :
-                                               "Continue",
-                           "Grab your gun and go!",
-                           NULL);
-      break;
-    case 1:
-      menu_cell_basic_draw(ctx,
-                           cell_layer,
-                           "Buy an Upgrade",
-                           g_mission == NULL ? "Improved armor, etc." :
-                                               "Not during missions!",
-                           NULL);
-      break;
-    case 2:
-      menu_cell_basic_draw(ctx,
-                           cell_layer,
-                           "Instructions",
-                           "How to play.",
-                           NULL);
-      break;
-    case 3:
-      menu_cell_basic_draw(ctx,
-                           cell_layer,
-                           "About",
-                           "Credits, etc.",
-                           NULL);
-      break;
-    default:
-      menu_cell_basic_draw(ctx,
-                           cell_layer,
-                           g_player->damage_vibes_on ? "Damage Vibes On" :
-                                                       "Damage Vibes Off",
-                           "Vibrate when hit?",
-                           NULL);
-      break;
+void start_half_res_transition(void) {
+  g_half_res_deadline = get_time_ms() + HALF_RES_TRANSITION_DURATION;
+  g_full_res_frame_duration = 0;  // The new scene hasn't been timed yet.
+  if (g_half_res_timer == NULL) {
+    g_half_res_timer = app_timer_register(HALF_RES_TRANSITION_DURATION,
+                                          half_res_timer_callback,
+                                          NULL);
+  } else {
+    app_timer_reschedule(g_half_res_timer, HALF_RES_TRANSITION_DURATION);
   }
 }
 
+#ifdef SPECULATIVE_VIEWS
 /*******************************************************************************
-   Function: main_menu_select_callback
+   Function: get_scene_signature
 
-Description: Called when a given cell of the main menu is selected.
+Description: Identifies the scene as it would look from a given position and
+             direction, given the current state of the player and mission.
+             Scenes with the same signature look the same, animation aside.
 
-     Inputs: menu_layer - Pointer to the menu layer.
-             cell_index - Pointer to the index struct of the selected cell.
-             data       - Pointer to additional data (not used).
+     Inputs: position  - The player's actual or hypothetical position.
+             direction - The player's actual or hypothetical direction.
 
-    Outputs: None.
+    Outputs: The scene's signature (never NO_SIGNATURE).
 *******************************************************************************/
-void main_menu_select_callback(MenuLayer *menu_layer,
-                               MenuIndex *cell_index,
-                               void *data) {
-  switch (cell_index->row) {
-    case 0:  // New Mission / Continue
-      if (g_mission == NULL) {
-        g_mission = malloc(sizeof(mission_t));
-        init_mission(rand() % NUM_MISSION_TYPES);
-      } else {
-        show_window(g_graphics_window);
-      }
-      break;
-    case 1:  // Buy an Upgrade
-      if (g_mission == NULL) {
-        menu_layer_set_selected_index(g_upgrade_menu,
-                                      (MenuIndex) {0, 0},
-                                      MenuRowAlignCenter,
-                                      NOT_ANIMATED);
-        show_window(g_upgrade_menu_window);
-      }
-      break;
-    case 2:  // Instructions
-      g_current_narration = INSTRUCTIONS_NARRATION_1;
-      show_narration();
-      break;
-    case 3:  // About
-      g_current_narration = GAME_INFO_NARRATION_1;
-      show_narration();
-      break;
-    default:  // Vibrations On/Off
-      g_player->damage_vibes_on = !g_player->damage_vibes_on;
-      menu_layer_reload_data(menu_layer);
-      break;
-  }
+uint32_t get_scene_signature(const GPoint position, const int8_t direction) {
+  scene_key_t key;
+  uint32_t signature;
+
+  key.position = position;
+  key.direction = direction;
+  memcpy(key.stats, g_player->stats, sizeof(key.stats));
+  key.mission_checksum = get_checksum(g_mission, sizeof(mission_t));
+  signature = get_checksum(&key, sizeof(scene_key_t));
+
+  return signature == NO_SIGNATURE ? signature + 1 : signature;
 }
 
 /*******************************************************************************
-   Function: upgrade_menu_draw_header_callback
+   Function: get_speculative_signature
 
-Description: Instructions for drawing the upgrade menu's header.
+Description: Identifies the scene as it would look after one of the
+             speculative inputs.
 
-     Inputs: ctx           - Pointer to the associated context.
-             cell_layer    - Pointer to the cell layer.
-             section_index - Section number of the header to be drawn.
-             data          - Pointer to additional data (not used).
+     Inputs: index - Index of the input in "SPECULATIVE_INPUTS".
 
-    Outputs: None.
+    Outputs: The scene's signature, or NO_SIGNATURE if the input's outcome
+             can't be predicted (e.g., a step into a wall).
 *******************************************************************************/
-static void upgrade_menu_draw_header_callback(GContext *ctx,
-                                              const Layer *cell_layer,
-                                              uint16_t section_index,
-                                              void *data) {
-  char header_str[UPGRADE_MENU_HEADER_STR_LEN + 1] = "";
+uint32_t get_speculative_signature(const int8_t index) {
+  GPoint position;
+  int8_t direction;
 
-  snprintf(header_str,
-           UPGRADE_MENU_HEADER_STR_LEN + 1,
-           "FUNDS: $%ld",
-           g_player->money);
-  menu_cell_basic_header_draw(ctx, cell_layer, header_str);
+  if (!get_speculative_pose(index, &position, &direction)) {
+    return NO_SIGNATURE;
+  }
+
+  return get_scene_signature(position, direction);
 }
 
 /*******************************************************************************
-   Function: upgrade_menu_draw_row_callback
+   Function: get_speculative_pose
 
-Description: Instructions for drawing a given row of the upgrade menu.
+Description: Determines where the player would be, and which way the player
+             would face, after one of the speculative inputs.
 
-     Inputs: ctx        - Pointer to the associated context.
-             cell_layer - Pointer to the layer of the cell to be drawn.
-             cell_index - Pointer to the index struct of the cell to be drawn.
-             data       - Pointer to additional data (not used).
+     Inputs: index     - Index of the input in "SPECULATIVE_INPUTS".
+             position  - Pointer to the resulting position.
+             direction - Pointer to the resulting direction.
 
-    Outputs: None.
+    Outputs: "True" if the input would simply move or turn the player. (Steps
+             that are blocked, or that would pick something up, return
+             "false".)
 *******************************************************************************/
-static void upgrade_menu_draw_row_callback(GContext *ctx,
-                                           const Layer *cell_layer,
-                                           MenuIndex *cell_index,
-                                           void *data) {
-  int16_t new_stat_value;
-  char title_str[UPGRADE_TITLE_STR_LEN + 1] = "",
-       subtitle_str[UPGRADE_SUBTITLE_STR_LEN + 1] = "";
+bool get_speculative_pose(const int8_t index,
+                          GPoint *position,
+                          int8_t *direction) {
+  *position = g_player->position;
+  *direction = g_player->direction;
+  switch (SPECULATIVE_INPUTS[index]) {
+    case INPUT_FORWARD:
+      *position = get_cell_farther_away(g_player->position,
+                                        g_player->direction,
+                                        1);
+      return get_cell_type(*position) == EMPTY && occupiable(*position);
+    case INPUT_TURN_LEFT:
+      *direction = get_direction_to_the_left(g_player->direction);
+      return true;
+    default:  // case INPUT_TURN_RIGHT:
+      *direction = get_direction_to_the_right(g_player->direction);
+      return true;
+  }
+}
 
-  // Determine the upgrade's title:
-  switch (cell_index->row) {
-    case ARMOR:
-      strcpy(title_str, "Armor");
-      break;
-    case MAX_HP:
-      strcpy(title_str, "Max. Health");
-      break;
-    case POWER:
-      strcpy(title_str, "Laser Power");
-      break;
-    default:  // case MAX_ENERGY:
-      strcpy(title_str, "Max. Energy");
-      break;
+/*******************************************************************************
+   Function: get_speculation_budget
+
+Description: Determines how many of the speculative inputs (most likely first)
+             should have views rendered ahead of time, given the battery level
+             and how much heap space is free.
+
+     Inputs: None.
+
+    Outputs: No. of speculative inputs to render views for.
+*******************************************************************************/
+int8_t get_speculation_budget(void) {
+  const BatteryChargeState battery = battery_state_service_peek();
+  int8_t i, num_views = 0, budget = NUM_SPECULATIVE_INPUTS;
+  int32_t view_size = VIEW_SIZE_ESTIMATE, heap_available;
+
+  // Go easy on a draining battery:
+  if (!battery.is_plugged) {
+    if (battery.charge_percent < MIN_SPECULATION_CHARGE) {
+      return 0;
+    }
+    if (battery.charge_percent < LOW_SPECULATION_CHARGE) {
+      budget = 1;
+    }
   }
 
-  // Determine the upgrade's subtitle:
-  if (g_player->stats[cell_index->row] >= MAX_SMALL_INT_VALUE) {
-    strcpy(subtitle_str, "9999 (Maxed Out)");
-  } else {
-    new_stat_value = get_upgraded_stat_value(cell_index->row);
-    snprintf(subtitle_str,
-             UPGRADE_SUBTITLE_STR_LEN + 1,
-             "%d->%d $%ld",
-             g_player->stats[cell_index->row],
-             new_stat_value,
-             get_upgrade_cost(new_stat_value));
+  // Keep only as many views (including the one on screen) as the heap can
+  // spare, going by the size of any already kept:
+  for (i = 0; i < MAX_VIEWS; ++i) {
+    if (g_views[i].data != NULL) {
+      num_views++;
+    }
+  }
+  if (num_views > 0) {
+    view_size = g_caches[VIEW_CACHE].size / num_views;
+  }
+  heap_available = (int32_t) heap_bytes_free() + g_caches[VIEW_CACHE].size -
+                   CACHE_HEAP_RESERVE;
+  if (heap_available / view_size - 1 < budget) {
+    budget = heap_available / view_size - 1;
   }
 
-  // Finally, draw the upgrade's row in the upgrade menu:
-  menu_cell_basic_draw(ctx, cell_layer, title_str, subtitle_str, NULL);
+  return budget < 0 ? 0 : budget;
 }
 
 /*******************************************************************************
-   Function: upgrade_menu_select_callback
+   Function: schedule_speculation
 
-Description: Called when a given cell of the upgrade menu is selected.
+Description: Frees views that can no longer be shown, then, if any view within
+             the speculation budget is still missing, sets a timer to render
+             it once the player has been idle for a while.
 
-     Inputs: menu_layer - Pointer to the menu layer.
-             cell_index - Pointer to the index struct of the selected cell.
-             data       - Pointer to additional data (not used).
+     Inputs: None.
 
     Outputs: None.
 *******************************************************************************/
-void upgrade_menu_select_callback(MenuLayer *menu_layer,
-                                  MenuIndex *cell_index,
-                                  void *data) {
-  int16_t new_stat_value;
+void schedule_speculation(void) {
+  const int8_t budget = get_speculation_budget();
+  int8_t i;
+  uint32_t signature;
 
-  if (g_player->stats[cell_index->row] >= MAX_SMALL_INT_VALUE) {
+  prune_views(budget);
+  if (g_displayed_signature == NO_SIGNATURE || g_num_queued_inputs > 0) {
     return;
   }
+  for (i = 0; i < budget; ++i) {
+    signature = get_speculative_signature(i);
+    if (signature != NO_SIGNATURE          &&
+        !(g_speculation_skips & (1 << i)) &&
+        get_view(signature) == NULL) {
+      if (g_speculation_timer == NULL) {
+        g_speculation_timer = app_timer_register(SPECULATION_DELAY,
+                                                 speculation_timer_callback,
+                                                 NULL);
+      } else {
+        app_timer_reschedule(g_speculation_timer, SPECULATION_DELAY);
+      }
 
-  new_stat_value = get_upgraded_stat_value(cell_index->row);
-  if (adjust_player_money(get_upgrade_cost(new_stat_value) * -1)) {
-    g_player->stats[cell_index->row] = new_stat_value;
-    menu_layer_reload_data(g_upgrade_menu);
+      return;
+    }
   }
 }
 
 /*******************************************************************************
-   Function: menu_get_header_height_callback
+   Function: cancel_speculation
 
-Description: Returns the section height for a given section of a given menu.
+Description: Stops rendering views ahead of time until the scene is next drawn
+             (e.g., because the graphics window is no longer on screen), and
+             forgets what the frame buffer holds.
 
-     Inputs: menu_layer    - Pointer to the menu of interest.
-             section_index - Section number.
-             data          - Pointer to additional data (not used).
+     Inputs: None.
 
-    Outputs: The number of sections in the indicated menu.
+    Outputs: None.
 *******************************************************************************/
-static int16_t menu_get_header_height_callback(MenuLayer *menu_layer,
-                                               uint16_t section_index,
-                                               void *data) {
-  return MENU_CELL_BASIC_HEADER_HEIGHT;
+void cancel_speculation(void) {
+  if (g_speculation_timer != NULL) {
+    app_timer_cancel(g_speculation_timer);
+    g_speculation_timer = NULL;
+  }
+  g_speculation_pending = false;
+  g_displayed_signature = NO_SIGNATURE;
 }
 
 /*******************************************************************************
-   Function: menu_get_num_rows_callback
+   Function: speculate
 
-Description: Returns the number of rows in a given menu (or in a given section
-             of a given menu).
+Description: Renders the view for the likeliest speculative input that hasn't
+             got one yet and keeps it, compressed, then restores the scene on
+             screen. (The frame buffer still holds the displayed scene, as the
+             graphics window has no background color.)
 
-     Inputs: menu_layer    - Pointer to the menu of interest.
-             section_index - Section number.
-             data          - Pointer to additional data (not used).
+     Inputs: ctx    - Pointer to the relevant graphics context.
+             bounds - Bounds of the graphics window's root layer.
 
-    Outputs: The number of rows in the indicated menu.
+    Outputs: "True" if a view was rendered (whether or not it could be kept).
 *******************************************************************************/
-static uint16_t menu_get_num_rows_callback(MenuLayer *menu_layer,
-                                           uint16_t section_index,
-                                           void *data) {
-  if (menu_layer == g_main_menu) {
-    return MAIN_MENU_NUM_ROWS;
-  } else {  // menu_layer == g_upgrade_menu
-    return UPGRADE_MENU_NUM_ROWS;
+bool speculate(GContext *ctx, const GRect bounds) {
+  const GPoint position = g_player->position;
+  const int8_t direction = g_player->direction,
+               budget = get_speculation_budget();
+  const bool animated_sprites_visible = g_animated_sprites_visible,
+             half_res_mode = g_half_res_mode;
+  int8_t i, speculative_direction;
+  uint32_t signature = NO_SIGNATURE;
+  GPoint speculative_position;
+  GBitmap *frame_buffer;
+  const view_t *displayed_view;
+
+  for (i = 0; i < budget; ++i) {
+    if (!(g_speculation_skips & (1 << i)) &&
+        get_speculative_pose(i,
+                             &speculative_position,
+                             &speculative_direction)) {
+      signature = get_scene_signature(speculative_position,
+                                      speculative_direction);
+      if (get_view(signature) == NULL) {
+        break;
+      }
+    }
+  }
+  if (i == budget) {
+    return false;
   }
+
+  // Keep the displayed scene, so it can be restored:
+  if ((frame_buffer = graphics_capture_frame_buffer(ctx)) == NULL) {
+    return false;
+  }
+  displayed_view = get_view(g_displayed_signature);
+  if (displayed_view == NULL) {
+    displayed_view = store_view(frame_buffer, g_displayed_signature);
+  }
+  graphics_release_frame_buffer(ctx, frame_buffer);
+  if (displayed_view == NULL) {
+    return false;
+  }
+
+  // Render the scene as it would look after the input:
+  g_player->position = speculative_position;
+  g_player->direction = speculative_direction;
+  gpath_rotate_to(g_compass_path, get_compass_angle(speculative_direction));
+  g_half_res_mode = false;
+  render_scene(ctx, bounds);
+  g_player->position = position;
+  g_player->direction = direction;
+  gpath_rotate_to(g_compass_path, get_compass_angle(direction));
+  g_half_res_mode = half_res_mode;
+
+  // Keep the view (unless it's animated), then put the displayed scene back.
+  // (Loading sprites may have evicted the views, in which case the scene must
+  // be drawn again.)
+  frame_buffer = graphics_capture_frame_buffer(ctx);
+  displayed_view = get_view(g_displayed_signature);
+  if (frame_buffer == NULL || displayed_view == NULL) {
+    if (frame_buffer != NULL) {
+      graphics_release_frame_buffer(ctx, frame_buffer);
+    }
+    g_displayed_signature = NO_SIGNATURE;
+    if (g_static_view != NULL) {
+      g_static_view->on_screen = false;
+    }
+    layer_mark_dirty(window_get_root_layer(g_graphics_window));
+
+    return false;
+  }
+  if (g_animated_sprites_visible ||
+      store_view(frame_buffer, signature) == NULL) {
+    g_speculation_skips |= 1 << i;
+  }
+  show_view(frame_buffer, displayed_view);
+  graphics_release_frame_buffer(ctx, frame_buffer);
+  g_animated_sprites_visible = animated_sprites_visible;
+
+  return true;
 }
 
 /*******************************************************************************
-   Function: draw_scene
+   Function: get_view
 
-Description: Draws a (simplistic) 3D scene based on the player's current
-             position, direction, and visibility depth.
+Description: Finds the kept view of a given scene.
 
-     Inputs: layer - Pointer to the relevant layer.
-             ctx   - Pointer to the relevant graphics context.
+     Inputs: signature - The scene's signature.
 
-    Outputs: None.
+    Outputs: Pointer to the view, or NULL if there isn't one.
 *******************************************************************************/
-void draw_scene(Layer *layer, GContext *ctx) {
-  int8_t i, depth;
-  GPoint cell, cell_2;
-
-  // First, draw the background, floor, and ceiling:
-  graphics_context_set_fill_color(ctx, GColorBlack);
-  graphics_fill_rect(ctx,
-                     layer_get_bounds(layer),
-                     NO_CORNER_RADIUS,
-                     GCornerNone);
-  draw_floor_and_ceiling(ctx);
-
-  // Now draw walls and cell contents:
-  for (depth = MAX_VISIBILITY_DEPTH - 2; depth >= 0; --depth) {
-    // Straight ahead at the current depth:
-    cell = get_cell_farther_away(g_player->position,
-                                 g_player->direction,
-                                 depth);
-    if (out_of_bounds(cell)) {
-      continue;
-    }
-    if (get_cell_type(cell) < SOLID) {
-      draw_cell_walls(ctx, cell, depth, STRAIGHT_AHEAD);
-      draw_cell_contents(ctx, cell, depth, STRAIGHT_AHEAD);
-    }
+view_t *get_view(const uint32_t signature) {
+  int8_t i;
 
-    // To the left and right at the same depth:
-    for (i = depth + 1; i > 0; --i) {
-      cell_2 = get_cell_farther_away(cell,
-                                 get_direction_to_the_left(g_player->direction),
-                                 i);
-      if (get_cell_type(cell_2) < SOLID) {
-        draw_cell_walls(ctx, cell_2, depth, STRAIGHT_AHEAD - i);
-        draw_cell_contents(ctx, cell_2, depth, STRAIGHT_AHEAD - i);
-      }
-      cell_2 = get_cell_farther_away(cell,
-                                get_direction_to_the_right(g_player->direction),
-                                i);
-      if (get_cell_type(cell_2) < SOLID) {
-        draw_cell_walls(ctx, cell_2, depth, STRAIGHT_AHEAD + i);
-        draw_cell_contents(ctx, cell_2, depth, STRAIGHT_AHEAD + i);
-      }
+  for (i = 0; i < MAX_VIEWS; ++i) {
+    if (g_views[i].data != NULL && g_views[i].signature == signature) {
+      return &g_views[i];
     }
   }
 
-  // Draw applicable weapon fire:
-  if (g_player_animation_mode > 0) {
-    draw_player_laser_beam(ctx);
+  return NULL;
+}
+
+/*******************************************************************************
+   Function: store_view
+
+Description: Compresses the frame buffer (below the status bar) into an unused
+             view.
+
+     Inputs: frame_buffer - Pointer to the captured frame buffer.
+             signature    - Signature of the scene it shows.
+
+    Outputs: Pointer to the view, or NULL if none was unused or the heap
+             couldn't spare the space.
+*******************************************************************************/
+view_t *store_view(GBitmap *frame_buffer, const uint32_t signature) {
+  const uint16_t bytes_per_row = gbitmap_get_bytes_per_row(frame_buffer),
+                 frame_size = (SCREEN_HEIGHT - STATUS_BAR_HEIGHT) *
+                              bytes_per_row;
+  const uint8_t *frame = gbitmap_get_data(frame_buffer) +
+                         STATUS_BAR_HEIGHT * bytes_per_row;
+  int8_t i;
+  uint16_t size;
+  codec_stream_t stream = {.buffer = NULL};  // Just measures, to begin with.
+
+  for (i = 0; i < MAX_VIEWS && g_views[i].data != NULL; ++i);
+  if (i == MAX_VIEWS) {
+    return NULL;
+  }
+  compress_data(frame, frame_size, bytes_per_row, &stream);
+  size = stream.total;
+  if (!reserve_cache_memory(VIEW_CACHE, size) ||
+      (g_views[i].data = malloc(size)) == NULL) {
+    return NULL;
   }
+  stream = (codec_stream_t) {.buffer = g_views[i].data, .buffer_size = size};
+  compress_data(frame, frame_size, bytes_per_row, &stream);
+  g_views[i].size = size;
+  g_views[i].signature = signature;
+  update_cache_size(VIEW_CACHE, size);
 
-  // Draw health meter:
-  draw_status_meter(ctx,
-                    GPoint (STATUS_METER_PADDING,
-                            GRAPHICS_FRAME_HEIGHT + STATUS_METER_PADDING +
-                              STATUS_BAR_HEIGHT),
-                    (float) g_player->stats[CURRENT_HP] /
-                      g_player->stats[MAX_HP]);
+  return &g_views[i];
+}
 
-  // Draw energy (ammo) meter:
-  draw_status_meter(ctx,
-                    GPoint (SCREEN_CENTER_POINT_X + STATUS_METER_PADDING +
-                              COMPASS_RADIUS + 1,
-                            GRAPHICS_FRAME_HEIGHT + STATUS_METER_PADDING +
-                              STATUS_BAR_HEIGHT),
-                    (float) g_player->stats[CURRENT_ENERGY] /
-                      g_player->stats[MAX_ENERGY]);
+/*******************************************************************************
+   Function: show_view
 
-  // Draw compass:
-#ifdef PBL_COLOR
-  graphics_context_set_fill_color(ctx, GColorLightGray);
-  graphics_context_set_stroke_color(ctx, GColorDarkGreen);
-#endif
-  graphics_fill_circle(ctx,
-                       GPoint(SCREEN_CENTER_POINT_X,
-                              GRAPHICS_FRAME_HEIGHT + STATUS_BAR_HEIGHT / 2 +
-                                STATUS_BAR_HEIGHT),
-                       COMPASS_RADIUS);
-  graphics_context_set_fill_color(ctx, GColorBlack);
-  gpath_draw_outline(ctx, g_compass_path);
-  gpath_draw_filled(ctx, g_compass_path);
+Description: Decompresses a view into the frame buffer (below the status bar).
 
-  // Finally, ensure the backlight is on:
-  light_enable_interaction();
+     Inputs: frame_buffer - Pointer to the captured frame buffer.
+             view         - Pointer to the view to be shown.
+
+    Outputs: None.
+*******************************************************************************/
+void show_view(GBitmap *frame_buffer, const view_t *view) {
+  const uint16_t bytes_per_row = gbitmap_get_bytes_per_row(frame_buffer);
+  codec_stream_t stream = {
+    .buffer = view->data,
+    .buffer_size = view->size,
+    .end = view->size,
+  };
+
+  decompress_data(&stream,
+                  gbitmap_get_data(frame_buffer) +
+                    STATUS_BAR_HEIGHT * bytes_per_row,
+                  (SCREEN_HEIGHT - STATUS_BAR_HEIGHT) * bytes_per_row,
+                  bytes_per_row);
 }
 
 /*******************************************************************************
-   Function: draw_player_laser_beam
+   Function: prune_views
 
-Description: Draws the player's laser beam onto the screen.
+Description: Frees every view other than those of the current scene and of the
+             speculative inputs within a given budget.
 
-     Inputs: ctx - Pointer to the relevant graphics context.
+     Inputs: budget - No. of speculative inputs whose views are wanted.
 
     Outputs: None.
 *******************************************************************************/
-void draw_player_laser_beam(GContext *ctx) {
-  int8_t i;
+void prune_views(const int8_t budget) {
+  int8_t i, j;
+  uint32_t wanted[MAX_VIEWS];
 
-#ifdef PBL_COLOR
-  graphics_context_set_stroke_color(ctx, RANDOM_BRIGHT_COLOR);
-#else
-  graphics_context_set_stroke_color(ctx, GColorWhite);
-#endif
-  graphics_draw_line(ctx,
-                     GPoint(SCREEN_CENTER_POINT_X,
-                            GRAPHICS_FRAME_HEIGHT + STATUS_BAR_HEIGHT),
-                     GPoint(SCREEN_CENTER_POINT.x,
-                            SCREEN_CENTER_POINT_Y + STATUS_BAR_HEIGHT));
-  for (i = 0; i <= g_laser_base_width / 2; ++i) {
-#ifdef PBL_COLOR
-    graphics_context_set_stroke_color(ctx, RANDOM_BRIGHT_COLOR);
-#else
-    if (i == g_laser_base_width / 2) {
-      graphics_context_set_stroke_color(ctx, GColorBlack);
+  wanted[0] = get_scene_signature(g_player->position, g_player->direction);
+  for (i = 0; i < NUM_SPECULATIVE_INPUTS; ++i) {
+    wanted[i + 1] = i < budget ? get_speculative_signature(i) : NO_SIGNATURE;
+  }
+  for (i = 0; i < MAX_VIEWS; ++i) {
+    for (j = 0; j < MAX_VIEWS && wanted[j] != g_views[i].signature; ++j);
+    if (g_views[i].data != NULL && j == MAX_VIEWS) {
+      free_view(&g_views[i]);
     }
-#endif
-    graphics_draw_line(ctx,
-                       GPoint(SCREEN_CENTER_POINT_X - i,
-                              GRAPHICS_FRAME_HEIGHT + STATUS_BAR_HEIGHT),
-                       GPoint(SCREEN_CENTER_POINT_X - i / 3,
-                              SCREEN_CENTER_POINT_Y + STATUS_BAR_HEIGHT));
-    graphics_draw_line(ctx,
-                       GPoint(SCREEN_CENTER_POINT_X + i,
-                              GRAPHICS_FRAME_HEIGHT + STATUS_BAR_HEIGHT),
-                       GPoint(SCREEN_CENTER_POINT_X + i / 3,
-                              SCREEN_CENTER_POINT_Y + STATUS_BAR_HEIGHT));
   }
 }
 
 /*******************************************************************************
-   Function: draw_floor_and_ceiling
+   Function: free_view
 
-Description: Draws the floor and ceiling.
+Description: Frees a view's data, leaving the view unused.
 
-     Inputs: ctx - Pointer to the relevant graphics context.
+     Inputs: view - Pointer to the view.
 
     Outputs: None.
 *******************************************************************************/
-void draw_floor_and_ceiling(GContext *ctx) {
-  uint8_t x, y, max_y, shading_offset;
-
-  max_y = g_back_wall_coords[MAX_VISIBILITY_DEPTH - 2][0][TOP_LEFT].y;
-#ifdef PBL_BW
-  graphics_context_set_stroke_color(ctx, GColorWhite);
-#endif
-  for (y = 0; y < max_y; ++y) {
-    // Determine horizontal distance between points:
-    shading_offset = 1 + y / MAX_VISIBILITY_DEPTH;
-    if (y % MAX_VISIBILITY_DEPTH >= MAX_VISIBILITY_DEPTH / 2 +
-                                    MAX_VISIBILITY_DEPTH % 2) {
-      shading_offset++;
-    }
-#ifdef PBL_COLOR
-    graphics_context_set_stroke_color(ctx,
-      g_background_colors[g_mission->floor_color_scheme]
-                         [shading_offset > NUM_BACKGROUND_COLORS_PER_SCHEME ?
-                            NUM_BACKGROUND_COLORS_PER_SCHEME - 1            :
-                            shading_offset - 1]);
-#endif
-    for (x = y % 2 ? 0 : (shading_offset / 2) + (shading_offset % 2);
-         x < GRAPHICS_FRAME_WIDTH;
-         x += shading_offset) {
-      // Draw one point on the ceiling and another on the floor:
-      graphics_draw_pixel(ctx, GPoint(x, y + STATUS_BAR_HEIGHT));
-      graphics_draw_pixel(ctx, GPoint(x, GRAPHICS_FRAME_HEIGHT - y +
-                                           STATUS_BAR_HEIGHT));
-    }
-  }
+void free_view(view_t *view) {
+  free(view->data);
+  view->data = NULL;
+  update_cache_size(VIEW_CACHE, -view->size);
 }
+#endif
 
 /*******************************************************************************
    Function: draw_cell_walls
@@ -1272,12 +3618,14 @@ void draw_cell_walls(GContext *ctx,
   back_wall_drawn = left_wall_drawn = right_wall_drawn = false;
   cell_2 = get_cell_farther_away(cell, g_player->direction, 1);
   if (get_cell_type(cell_2) >= SOLID) {
-    draw_shaded_quad(ctx,
-                     GPoint(left, top + STATUS_BAR_HEIGHT),
-                     GPoint(left, bottom + STATUS_BAR_HEIGHT),
-                     GPoint(right, top + STATUS_BAR_HEIGHT),
-                     GPoint(right, bottom + STATUS_BAR_HEIGHT),
-                     GPoint(left, top + STATUS_BAR_HEIGHT));
+    if (!draw_wall_face(ctx, depth, position, BACK_WALL)) {
+      draw_shaded_quad(ctx,
+                       GPoint(left, top + STATUS_BAR_HEIGHT),
+                       GPoint(left, bottom + STATUS_BAR_HEIGHT),
+                       GPoint(right, top + STATUS_BAR_HEIGHT),
+                       GPoint(right, bottom + STATUS_BAR_HEIGHT),
+                       GPoint(left, top + STATUS_BAR_HEIGHT));
+    }
     graphics_context_set_stroke_color(ctx, GColorBlack);
     graphics_draw_line(ctx,
                        GPoint(left, top + STATUS_BAR_HEIGHT),
@@ -1294,7 +3642,8 @@ void draw_cell_walls(GContext *ctx,
     }
 
     // Entrance/exit:
-    if (exit_present && g_player->direction == g_mission->entrance_direction) {
+    if (exit_present && g_player->direction == g_mission->entrance_direction &&
+        !draw_wall_door(ctx, depth, position, BACK_WALL)) {
       graphics_context_set_fill_color(ctx, GColorBlack);
       exit_offset_x = (right - left) / 3;
       graphics_fill_rect(ctx,
@@ -1306,6 +3655,7 @@ void draw_cell_walls(GContext *ctx,
                          GCornerNone);
     }
 
+    record_wall_columns(left, right);
     back_wall_drawn = true;
   }
 
@@ -1323,12 +3673,14 @@ void draw_cell_walls(GContext *ctx,
                                  get_direction_to_the_left(g_player->direction),
                                  1);
     if (get_cell_type(cell_2) >= SOLID) {
-      draw_shaded_quad(ctx,
-                       GPoint(left, top - y_offset + STATUS_BAR_HEIGHT),
-                       GPoint(left, bottom + y_offset + STATUS_BAR_HEIGHT),
-                       GPoint(right, top + STATUS_BAR_HEIGHT),
-                       GPoint(right, bottom + STATUS_BAR_HEIGHT),
-                       GPoint(left, top - y_offset + STATUS_BAR_HEIGHT));
+      if (!draw_wall_face(ctx, depth, position, LEFT_WALL)) {
+        draw_shaded_quad(ctx,
+                         GPoint(left, top - y_offset + STATUS_BAR_HEIGHT),
+                         GPoint(left, bottom + y_offset + STATUS_BAR_HEIGHT),
+                         GPoint(right, top + STATUS_BAR_HEIGHT),
+                         GPoint(right, bottom + STATUS_BAR_HEIGHT),
+                         GPoint(left, top - y_offset + STATUS_BAR_HEIGHT));
+      }
       graphics_context_set_stroke_color(ctx, GColorBlack);
       graphics_draw_line(ctx,
                          GPoint(left, top - y_offset + STATUS_BAR_HEIGHT),
@@ -1339,7 +3691,8 @@ void draw_cell_walls(GContext *ctx,
 
       // Entrance/exit:
       if (exit_present && get_direction_to_the_left(g_player->direction) ==
-                          g_mission->entrance_direction) {
+                          g_mission->entrance_direction &&
+          !draw_wall_door(ctx, depth, position, LEFT_WALL)) {
         exit_offset_x = (right - left) / 3;
         fill_quad(ctx,
                   GPoint(depth == 0 ? 0 : left + exit_offset_x,
@@ -1355,6 +3708,7 @@ void draw_cell_walls(GContext *ctx,
                   GColorBlack);
       }
 
+      record_wall_columns(left, right);
       left_wall_drawn = true;
     }
   }
@@ -1371,12 +3725,14 @@ void draw_cell_walls(GContext *ctx,
                                 get_direction_to_the_right(g_player->direction),
                                 1);
     if (get_cell_type(cell_2) >= SOLID) {
-      draw_shaded_quad(ctx,
-                       GPoint(left, top + STATUS_BAR_HEIGHT),
-                       GPoint(left, bottom + STATUS_BAR_HEIGHT),
-                       GPoint(right, top - y_offset + STATUS_BAR_HEIGHT),
-                       GPoint(right, bottom + y_offset + STATUS_BAR_HEIGHT),
-                       GPoint(left, top + STATUS_BAR_HEIGHT));
+      if (!draw_wall_face(ctx, depth, position, RIGHT_WALL)) {
+        draw_shaded_quad(ctx,
+                         GPoint(left, top + STATUS_BAR_HEIGHT),
+                         GPoint(left, bottom + STATUS_BAR_HEIGHT),
+                         GPoint(right, top - y_offset + STATUS_BAR_HEIGHT),
+                         GPoint(right, bottom + y_offset + STATUS_BAR_HEIGHT),
+                         GPoint(left, top + STATUS_BAR_HEIGHT));
+      }
       graphics_context_set_stroke_color(ctx, GColorBlack);
       graphics_draw_line(ctx,
                          GPoint(left, top + STATUS_BAR_HEIGHT),
@@ -1387,7 +3743,8 @@ void draw_cell_walls(GContext *ctx,
 
       // Entrance/exit:
       if (exit_present && get_direction_to_the_right(g_player->direction) ==
-                          g_mission->entrance_direction) {
+                          g_mission->entrance_direction &&
+          !draw_wall_door(ctx, depth, position, RIGHT_WALL)) {
         exit_offset_x = (right - left) / 3;
         fill_quad(ctx,
                   GPoint(left + exit_offset_x,
@@ -1404,6 +3761,7 @@ void draw_cell_walls(GContext *ctx,
                   GColorBlack);
       }
 
+      record_wall_columns(left, right);
       right_wall_drawn = true;
     }
   }
@@ -1446,45 +3804,154 @@ void draw_cell_walls(GContext *ctx,
 }
 
 /*******************************************************************************
-   Function: draw_cell_contents
+   Function: record_wall_columns
 
-Description: Draws an NPC or any other contents present in a given cell.
+Description: While the static view is being rendered, notes that the view slot
+             being drawn has a wall spanning given screen columns (so sprites
+             drawn earlier are hidden there).
 
-     Inputs: ctx      - Pointer to the relevant graphics context.
-             cell     - Coordinates of the cell of interest.
-             depth    - Front-back visual depth of the cell of interest in
-                        "g_back_wall_coords".
-             position - Left-right visual position of the cell of interest in
-                        "g_back_wall_coords".
+     Inputs: left  - First screen column of the wall (may be off screen).
+             right - Last screen column of the wall (likewise).
+
+    Outputs: None.
+*******************************************************************************/
+void record_wall_columns(const int16_t left, const int16_t right) {
+#ifdef COMPOSITED_SCENES
+  int16_t x;
+
+  if (g_scene_pass != STATIC_SCENE_PASS) {
+    return;
+  }
+  for (x = left < 0 ? 0 : left; x <= right && x < GRAPHICS_FRAME_WIDTH; ++x) {
+    g_static_view->wall_orders[x] = g_view_slot_order;
+  }
+#endif
+}
+
+/*******************************************************************************
+   Function: draw_cell_contents
+
+Description: Draws an NPC or any other contents present in a given cell, or,
+             unless the current scene pass is a full one, lists them in the
+             static view to be drawn later (see "composite_scene").
+
+     Inputs: ctx                - Pointer to the relevant graphics
+                                  context.
+             cell               - Coordinates of the cell of interest.
+             depth              - Front-back visual depth of the cell of
+                                  interest in "g_back_wall_coords".
+             position           - Left-right visual position of the cell of
+                                  interest in "g_back_wall_coords".
+             floor_center_point - The cell's floor center point, in screen
+                                  coordinates.
+             drawing_unit       - Drawing unit at the cell's view slot.
 
     Outputs: None.
 *******************************************************************************/
 void draw_cell_contents(GContext *ctx,
                         const GPoint cell,
                         const int8_t depth,
-                        const int8_t position) {
-  int8_t drawing_unit,  // Reference variable for drawing contents at depth.
-         content_type = get_cell_type(cell);
-  GPoint floor_center_point, top_left_point;
+                        const int8_t position,
+                        const GPoint floor_center_point,
+                        const int8_t drawing_unit) {
+  const int8_t content_type = get_cell_contents_type(cell);
 
   if (content_type == EMPTY) {
-    if (get_npc_at(cell) == NULL) {
-      return;
-    }
-    content_type = get_npc_at(cell)->type;
+    return;
   }
+  if (g_num_sprite_frames[get_sprite_index(content_type)] > 1) {
+    g_animated_sprites_visible = true;
+  }
+#ifdef COMPOSITED_SCENES
+  if (g_scene_pass != FULL_SCENE_PASS) {
+    g_static_view->scene_sprites[g_num_scene_sprites++] = (scene_sprite_t) {
+      .content_type = content_type,
+      .depth = depth,
+      .position = position,
+      .frame = get_sprite_frame(content_type),
+      .order = g_view_slot_order,
+      .floor_center_point = floor_center_point,
+      .bounds = get_sprite_bounds(floor_center_point, drawing_unit),
+    };
+
+    return;
+  }
+#endif
+  draw_sprite_frame(ctx,
+                    content_type,
+                    depth,
+                    position,
+                    floor_center_point,
+                    get_sprite_frame(content_type));
+}
+
+/*******************************************************************************
+   Function: draw_sprite_frame
+
+Description: Draws an animation frame of an NPC, HUMAN or ITEM at a given
+             visual depth and position, using the sprite cache's copy of the
+             frame if there is one.
+
+     Inputs: ctx                - Pointer to the relevant graphics
+                                  context.
+             content_type       - NPC type, HUMAN or ITEM.
+             depth              - Front-back visual depth in
+                                  "g_back_wall_coords".
+             position           - Left-right visual position in
+                                  "g_back_wall_coords".
+             floor_center_point - Floor center point of the view slot, in
+                                  screen coordinates.
+             frame              - Index of the animation frame to be drawn.
+
+    Outputs: None.
+*******************************************************************************/
+void draw_sprite_frame(GContext *ctx,
+                       const int8_t content_type,
+                       const int8_t depth,
+                       const int8_t position,
+                       const GPoint floor_center_point,
+                       const int8_t frame) {
+  const int8_t sprite_index = get_sprite_index(content_type);
+
+  if (g_sprite_cache[sprite_index][depth] == NULL &&
+      !load_sprite_frames(content_type, depth)) {
+    draw_sprite(ctx, content_type, depth, position, frame);
+  } else {
+    draw_cached_sprite(ctx,
+                       &g_sprite_cache[sprite_index][depth]->frames[frame],
+                       floor_center_point);
+  }
+}
+
+/*******************************************************************************
+   Function: draw_sprite
+
+Description: Draws an NPC, HUMAN or ITEM at a given visual depth and position
+             with graphics primitives, posed according to a given animation
+             frame.
+
+     Inputs: ctx          - Pointer to the relevant graphics context.
+             content_type - NPC type, HUMAN or ITEM.
+             depth        - Front-back visual depth in "g_back_wall_coords".
+             position     - Left-right visual position in "g_back_wall_coords".
+             frame        - Index of the animation frame to be drawn.
+
+    Outputs: None.
+*******************************************************************************/
+void draw_sprite(GContext *ctx,
+                 const int8_t content_type,
+                 const int8_t depth,
+                 const int8_t position,
+                 const int8_t frame) {
+  const int8_t drawing_unit = get_drawing_unit(depth, position);
+  int8_t animation_offset;
+  GPoint floor_center_point, top_left_point;
+
   floor_center_point = get_floor_center_point(depth, position);
   top_left_point = g_back_wall_coords[depth][position][TOP_LEFT];
   floor_center_point.y += STATUS_BAR_HEIGHT;
   top_left_point.y += STATUS_BAR_HEIGHT;
-
-  // Determine the drawing unit:
-  drawing_unit = (g_back_wall_coords[depth][position][BOTTOM_RIGHT].x -
-                  top_left_point.x) / 10;
-  if ((g_back_wall_coords[depth][position][BOTTOM_RIGHT].x -
-       top_left_point.x) % 10 >= 5) {
-    drawing_unit++;
-  }
+  g_sprite_seed = g_laser_seed = frame + 1;  // Flicker is fixed per frame.
 
   // Draw a shadow on the ground:
   graphics_context_set_fill_color(ctx, GColorBlack);
@@ -1630,7 +4097,7 @@ void draw_cell_contents(GContext *ctx,
                                     (drawing_unit * 2 + drawing_unit / 2),
                                   floor_center_point.y -
                                     (drawing_unit * 5 + drawing_unit / 2)),
-                           drawing_unit / 2 + drawing_unit / 4);
+                           drawing_unit / 2 + (frame ? 0 : drawing_unit / 4));
 #ifdef PBL_COLOR
       graphics_context_set_fill_color(ctx, GColorMintGreen);  // For the head.
 #else
@@ -1679,7 +4146,7 @@ void draw_cell_contents(GContext *ctx,
                                   (drawing_unit * 2 + drawing_unit / 2),
                                 floor_center_point.y -
                                   (drawing_unit * 5 + drawing_unit / 2)),
-                         drawing_unit / 2 + drawing_unit / 4);
+                         drawing_unit / 2 + (frame ? 0 : drawing_unit / 4));
   } else if (content_type == HUMAN) {
     // Legs:
 #ifdef PBL_COLOR
@@ -1941,27 +4408,30 @@ void draw_cell_contents(GContext *ctx,
                          GPoint(floor_center_point.x - drawing_unit * 3,
                                 floor_center_point.y -
                                   (drawing_unit * 4 + drawing_unit / 2)),
-                         drawing_unit / 2);
+                         drawing_unit / 2 - (frame ? drawing_unit / 4 : 0));
     graphics_fill_circle(ctx,
                          GPoint(floor_center_point.x + drawing_unit * 3,
                                 floor_center_point.y -
                                   (drawing_unit * 4 + drawing_unit / 2)),
-                         drawing_unit / 2);
+                         drawing_unit / 2 - (frame ? 0 : drawing_unit / 4));
   } else if (content_type == BEAST) {
-    // Legs:
+    // Legs (lifting each in turn to stride):
+    animation_offset = drawing_unit / 2 + 1;
 #ifdef PBL_COLOR
     graphics_context_set_fill_color(ctx, GColorImperialPurple);
 #endif
     graphics_fill_rect(ctx,
                        GRect(floor_center_point.x - drawing_unit * 3,
-                             floor_center_point.y - drawing_unit * 4 - 1,
+                             floor_center_point.y - drawing_unit * 4 - 1 -
+                               (frame ? 0 : animation_offset),
                              drawing_unit * 2,
                              drawing_unit * 4 + 1),
                        NO_CORNER_RADIUS,
                        GCornerNone);
     graphics_fill_rect(ctx,
                        GRect(floor_center_point.x + drawing_unit + 1,
-                             floor_center_point.y - drawing_unit * 4 - 1,
+                             floor_center_point.y - drawing_unit * 4 - 1 -
+                               (frame ? animation_offset : 0),
                              drawing_unit * 2,
                              drawing_unit * 4 + 1),
                        NO_CORNER_RADIUS,
@@ -2004,7 +4474,7 @@ void draw_cell_contents(GContext *ctx,
                                (drawing_unit + drawing_unit / 2),
                              floor_center_point.y - drawing_unit * 5,
                              drawing_unit,
-                             drawing_unit + drawing_unit / 2 + (time(0) % 2 ?
+                             drawing_unit + drawing_unit / 2 + (frame ?
                                0 : drawing_unit / 2)),
                        drawing_unit / 2,
                        GCornersAll);
@@ -2012,7 +4482,7 @@ void draw_cell_contents(GContext *ctx,
                        GRect(floor_center_point.x - drawing_unit / 2,
                              floor_center_point.y - drawing_unit * 5,
                              drawing_unit,
-                             drawing_unit + drawing_unit / 2 + (time(0) % 2 ?
+                             drawing_unit + drawing_unit / 2 + (frame ?
                                0 : drawing_unit / 2)),
                        drawing_unit / 2,
                        GCornersAll);
@@ -2020,54 +4490,68 @@ void draw_cell_contents(GContext *ctx,
                        GRect(floor_center_point.x + drawing_unit / 2,
                              floor_center_point.y - drawing_unit * 5,
                              drawing_unit,
-                             drawing_unit + drawing_unit / 2 + (time(0) % 2 ?
+                             drawing_unit + drawing_unit / 2 + (frame ?
                                0 : drawing_unit / 2)),
                        drawing_unit / 2,
                        GCornersAll);
   } else if (content_type == OOZE) {
+    // Wobble: squash the head down in frame 1, stretch it up in frame 2.
+    animation_offset = frame ? drawing_unit / 4 + 1 : 0;
+    if (frame == 2) {
+      animation_offset *= -1;
+    }
+
     // Body:
     graphics_fill_circle(ctx,
                          GPoint(floor_center_point.x,
                                 floor_center_point.y - drawing_unit * 2),
-                         drawing_unit * 2);
+                         drawing_unit * 2 - (frame == 2 ? 1 : 0));
 
     // Head:
     graphics_fill_circle(ctx,
                          GPoint(floor_center_point.x,
-                                floor_center_point.y - drawing_unit * 6),
-                         drawing_unit * 4);
+                                floor_center_point.y - drawing_unit * 6 +
+                                  animation_offset),
+                         drawing_unit * 4 - (frame == 1 ? animation_offset :
+                                                          0));
 
     // Eyes:
 #ifdef PBL_COLOR
-    graphics_context_set_fill_color(ctx, RANDOM_BRIGHT_COLOR);
+    graphics_context_set_fill_color(ctx, RANDOM_BRIGHT_SPRITE_COLOR);
 #else
     graphics_context_set_fill_color(ctx, GColorWhite);
 #endif
     graphics_fill_rect(ctx,
                        GRect(floor_center_point.x - drawing_unit * 3,
-                             floor_center_point.y - drawing_unit * 7,
+                             floor_center_point.y - drawing_unit * 7 +
+                               animation_offset,
                              drawing_unit * 2,
                              drawing_unit),
                        drawing_unit / 2,
                        GCornersAll);
     graphics_fill_rect(ctx,
                        GRect(floor_center_point.x + drawing_unit,
-                             floor_center_point.y - drawing_unit * 7,
+                             floor_center_point.y - drawing_unit * 7 +
+                               animation_offset,
                              drawing_unit * 2,
                              drawing_unit),
                        drawing_unit / 2,
                        GCornersAll);
   } else if (content_type == FLOATING_MONSTROSITY) {
+    // Bob up and down, with the shading pattern shimmering on odd frames:
+    animation_offset = frame % 2 ? drawing_unit / 4 :
+                                   (frame / 2) * (drawing_unit / 2);
     draw_floating_monstrosity(ctx,
                               GPoint(floor_center_point.x,
-                                     floor_center_point.y - drawing_unit * 6),
+                                     floor_center_point.y - drawing_unit * 6 -
+                                       animation_offset),
                               drawing_unit * 4,
-                              depth == 0 ?
+                              (frame % 2) + (depth == 0 ?
                         1 + (top_left_point.y / 2) / MAX_VISIBILITY_DEPTH
                                          :
                         1 + ((top_left_point.y -
                           g_back_wall_coords[depth - 1][position][TOP_LEFT].y) /
-                          2) / MAX_VISIBILITY_DEPTH);
+                          2) / MAX_VISIBILITY_DEPTH));
   } else {  // content_type == ITEM
 #ifdef PBL_COLOR
     graphics_context_set_fill_color(ctx, GColorLightGray);
@@ -2078,8 +4562,8 @@ void draw_cell_contents(GContext *ctx,
                              drawing_unit * 6),
                        drawing_unit / 2,
                        GCornersTop);
-    graphics_context_set_fill_color(ctx, rand() % 2 ? GColorDarkCandyAppleRed :
-                                                      GColorRed);
+    graphics_context_set_fill_color(ctx, sprite_rand() % 2 ?
+                                           GColorDarkCandyAppleRed : GColorRed);
     graphics_fill_rect(ctx,
                        GRect(floor_center_point.x + drawing_unit / 2,
                              floor_center_point.y - drawing_unit * 5,
@@ -2087,8 +4571,8 @@ void draw_cell_contents(GContext *ctx,
                              drawing_unit),
                        NO_CORNER_RADIUS,
                        GCornerNone);
-    graphics_context_set_fill_color(ctx, rand() % 2 ? GColorDarkCandyAppleRed :
-                                                      GColorRed);
+    graphics_context_set_fill_color(ctx, sprite_rand() % 2 ?
+                                           GColorDarkCandyAppleRed : GColorRed);
     graphics_fill_rect(ctx,
                        GRect(floor_center_point.x + drawing_unit / 2,
                              floor_center_point.y - drawing_unit * 4 + 1,
@@ -2096,8 +4580,8 @@ void draw_cell_contents(GContext *ctx,
                              drawing_unit),
                        NO_CORNER_RADIUS,
                        GCornerNone);
-    graphics_context_set_fill_color(ctx, rand() % 2 ? GColorDarkCandyAppleRed :
-                                                      GColorRed);
+    graphics_context_set_fill_color(ctx, sprite_rand() % 2 ?
+                                           GColorDarkCandyAppleRed : GColorRed);
     graphics_fill_rect(ctx,
                        GRect(floor_center_point.x + drawing_unit,
                              floor_center_point.y - drawing_unit * 5,
@@ -2105,8 +4589,8 @@ void draw_cell_contents(GContext *ctx,
                              drawing_unit),
                        NO_CORNER_RADIUS,
                        GCornerNone);
-    graphics_context_set_fill_color(ctx, rand() % 2 ? GColorDarkCandyAppleRed :
-                                                      GColorRed);
+    graphics_context_set_fill_color(ctx, sprite_rand() % 2 ?
+                                           GColorDarkCandyAppleRed : GColorRed);
     graphics_fill_rect(ctx,
                        GRect(floor_center_point.x + drawing_unit,
                              floor_center_point.y - drawing_unit * 4 + 1,
@@ -2127,6 +4611,122 @@ void draw_cell_contents(GContext *ctx,
   }
 }
 
+/*******************************************************************************
+   Function: draw_cached_sprite
+
+Description: Blits a pre-rasterized sprite frame onto the screen, leaving its
+             transparent pixels untouched.
+
+     Inputs: ctx                - Pointer to the relevant graphics context.
+             sprite             - Pointer to the cached sprite frame.
+             floor_center_point - Floor center point (in screen coordinates)
+                                  of the cell containing the sprite.
+
+    Outputs: None.
+*******************************************************************************/
+void draw_cached_sprite(GContext *ctx,
+                        const sprite_t *sprite,
+                        const GPoint floor_center_point) {
+  const GRect bounds = gbitmap_get_bounds(sprite->image);
+  const GRect destination = GRect(floor_center_point.x + sprite->offset.x,
+                                  floor_center_point.y + sprite->offset.y,
+                                  bounds.size.w,
+                                  bounds.size.h);
+
+#ifdef PBL_COLOR
+  graphics_context_set_compositing_mode(ctx, GCompOpSet);
+  graphics_draw_bitmap_in_rect(ctx, sprite->image, destination);
+#else
+  graphics_context_set_compositing_mode(ctx, GCompOpClear);
+  graphics_draw_bitmap_in_rect(ctx, sprite->mask, destination);
+  graphics_context_set_compositing_mode(ctx, GCompOpOr);
+  graphics_draw_bitmap_in_rect(ctx, sprite->image, destination);
+#endif
+  graphics_context_set_compositing_mode(ctx, GCompOpAssign);
+}
+
+/*******************************************************************************
+   Function: load_sprite_frames
+
+Description: Loads the build-time sprite strip for a given sprite type and
+             visual depth, then carves it into the sprite cache's animation
+             frames (and, on black-and-white platforms, their masks).
+
+     Inputs: content_type - NPC type, HUMAN or ITEM.
+             depth        - Front-back visual depth in "g_back_wall_coords".
+
+    Outputs: "True" if the frames were loaded, "false" if there wasn't enough
+             memory (in which case the sprite will be drawn directly).
+*******************************************************************************/
+bool load_sprite_frames(const int8_t content_type, const int8_t depth) {
+  int8_t frame;
+  GPoint floor_center_point = get_floor_center_point(depth, STRAIGHT_AHEAD);
+  const int8_t sprite_index = get_sprite_index(content_type),
+               num_frames = g_num_sprite_frames[sprite_index];
+  GRect bounds;
+  sprite_strip_t *strip;
+  sprite_t *sprite;
+
+  floor_center_point.y += STATUS_BAR_HEIGHT;
+  bounds = get_sprite_bounds(floor_center_point,
+                             get_drawing_unit(depth, STRAIGHT_AHEAD));
+
+  // Leave a healthy margin of heap space for everything else (the decoded
+  // strip's exact size isn't known until it's loaded, so assume the worst):
+#ifdef PBL_COLOR
+  if (!reserve_cache_memory(SPRITE_CACHE,
+                            sizeof(sprite_strip_t) +
+                              num_frames * bounds.size.w * bounds.size.h)) {
+#else
+  if (!reserve_cache_memory(SPRITE_CACHE,
+                            sizeof(sprite_strip_t) +
+                              num_frames * 2 * ((bounds.size.w + 31) / 32) *
+                                4 * bounds.size.h)) {
+#endif
+    return false;
+  }
+  if ((strip = calloc(1, sizeof(sprite_strip_t))) == NULL) {
+    return false;
+  }
+  strip->bitmap = gbitmap_create_with_resource(RESOURCE_ID_SPRITE_STRIP_0 +
+    sprite_index * (MAX_VISIBILITY_DEPTH - 1) + depth);
+  if (strip->bitmap == NULL) {
+    free(strip);
+
+    return false;
+  }
+  g_sprite_cache[sprite_index][depth] = strip;
+  update_cache_size(SPRITE_CACHE,
+                    sizeof(sprite_strip_t) + get_bitmap_size(strip->bitmap));
+
+  // Frames are stacked top to bottom, followed on black-and-white platforms by
+  // their masks in the same order:
+  for (frame = 0; frame < num_frames; ++frame) {
+    sprite = &strip->frames[frame];
+    sprite->image = gbitmap_create_as_sub_bitmap(strip->bitmap,
+      GRect(0, frame * bounds.size.h, bounds.size.w, bounds.size.h));
+#ifdef PBL_BW
+    sprite->mask = gbitmap_create_as_sub_bitmap(strip->bitmap,
+      GRect(0,
+            (num_frames + frame) * bounds.size.h,
+            bounds.size.w,
+            bounds.size.h));
+    if (sprite->mask == NULL) {
+      destroy_sprite(sprite);
+    }
+#endif
+    if (sprite->image == NULL) {
+      unload_sprite_frames(sprite_index, depth);
+
+      return false;
+    }
+    sprite->offset = GPoint(bounds.origin.x - floor_center_point.x,
+                            bounds.origin.y - floor_center_point.y);
+  }
+
+  return true;
+}
+
 /*******************************************************************************
    Function: draw_floating_monstrosity
 
@@ -2165,7 +4765,7 @@ void draw_floating_monstrosity(GContext *ctx,
       x_offset = cos_lookup(theta) * i / TRIG_MAX_RATIO;
       y_offset = sin_lookup(theta) * i / TRIG_MAX_RATIO;
 #ifdef PBL_COLOR
-      graphics_context_set_stroke_color(ctx, RANDOM_COLOR);
+      graphics_context_set_stroke_color(ctx, RANDOM_SPRITE_COLOR);
 #endif
       graphics_draw_pixel(ctx,
                           GPoint(center.x - x_offset, center.y - y_offset));
@@ -2207,8 +4807,12 @@ void draw_shaded_quad(GContext *ctx,
   float dy_over_dx = (float) (upper_right.y - upper_left.y) /
                              (upper_right.x - upper_left.x);
   GColor primary_color = GColorWhite;
+  const int16_t column_width = g_half_res_mode ? 2 : 1;
 
-  for (i = upper_left.x; i <= upper_right.x && i < GRAPHICS_FRAME_WIDTH; ++i) {
+  // At half resolution, only even columns are drawn (odd ones get doubled):
+  for (i = upper_left.x + (g_half_res_mode ? upper_left.x & 1 : 0);
+       i <= upper_right.x && i < GRAPHICS_FRAME_WIDTH;
+       i += column_width) {
     // Determine vertical distance between points:
     shading_offset = 1 + ((shading_ref.y + (i - upper_left.x) * dy_over_dx) /
                           MAX_VISIBILITY_DEPTH);
@@ -2235,7 +4839,8 @@ void draw_shaded_quad(GContext *ctx,
          j < lower_left.y - (i - upper_left.x) * dy_over_dx;
          ++j) {
       if ((j + (int16_t) ((i - upper_left.x) * dy_over_dx) +
-          (i % 2 == 0 ? 0 : half_shading_offset)) % shading_offset == 0) {
+          ((i / column_width) % 2 == 0 ? 0 : half_shading_offset)) %
+          shading_offset == 0) {
         graphics_context_set_stroke_color(ctx, primary_color);
       } else {
         graphics_context_set_stroke_color(ctx, GColorBlack);
@@ -2245,6 +4850,176 @@ void draw_shaded_quad(GContext *ctx,
   }
 }
 
+/*******************************************************************************
+   Function: draw_wall_face
+
+Description: Draws a wall face from its pre-rendered columns (see
+             "init_wall_columns") straight into the frame buffer, with the
+             current location's texture, if it has one, or else shaded as
+             "draw_shaded_quad" would shade it. Either way, each pixel costs a
+             table read or a counter check, and a store.
+
+     Inputs: ctx      - Pointer to the relevant graphics context.
+             depth    - Front-back visual depth in "g_back_wall_coords".
+             position - Left-right visual position in "g_back_wall_coords".
+             face     - BACK_WALL, LEFT_WALL or RIGHT_WALL.
+
+    Outputs: "True" if the wall was drawn; otherwise, it should be drawn with
+             "draw_shaded_quad".
+*******************************************************************************/
+bool draw_wall_face(GContext *ctx,
+                    const int8_t depth,
+                    const int8_t position,
+                    const int8_t face) {
+  const int8_t texture = g_location_wall_textures[g_mission->location];
+  const wall_tables_t *tables = g_wall_tables;
+  const wall_span_t *span;
+  const wall_column_t *column;
+  const uint16_t *texels = NULL;
+  int16_t x, y, i, bottom, shading_offset, rows_to_shade;
+  uint16_t v, v_step, texel_mask;
+  uint8_t *pixel;
+  uint16_t bytes_per_row;
+  bool lit;
+  GBitmap *frame_buffer;
+#ifdef PBL_COLOR
+  uint8_t color;
+#else
+  uint8_t pixel_mask;
+#endif
+
+  if (tables == NULL) {
+    return false;
+  }
+  span = &tables->spans[depth][position][face];
+  if (span->num_columns == 0 ||
+      (frame_buffer = graphics_capture_frame_buffer(ctx)) == NULL) {
+    return false;
+  }
+  if (texture != NO_WALL_TEXTURE) {
+    texels = g_wall_textures[texture];
+  }
+  bytes_per_row = gbitmap_get_bytes_per_row(frame_buffer);
+  for (i = span->left < 0 ? -span->left : 0; i < span->num_columns; ++i) {
+    x = span->left + i;
+    if (x >= GRAPHICS_FRAME_WIDTH) {
+      break;
+    }
+    if (g_half_res_mode && x % 2) {
+      continue;  // Odd columns get doubled.
+    }
+    column = &tables->columns[span->first_column + i];
+    bottom = GRAPHICS_FRAME_HEIGHT - column->top;
+    pixel = gbitmap_get_data(frame_buffer) +
+            (column->top + STATUS_BAR_HEIGHT) * bytes_per_row;
+#ifdef PBL_COLOR
+    pixel += x;
+    color = g_background_colors[g_mission->wall_color_scheme]
+                               [tables->shades[column->top]].argb;
+#else
+    // Eight pixels per byte, leftmost in the least significant bit:
+    pixel += x / 8;
+    pixel_mask = 1 << (x % 8);
+#endif
+    v = 0;
+    v_step = tables->texture_steps[column->top];
+    texel_mask = 1 << column->u;
+
+    // Untextured, it's lit every "shading_offset" rows, with odd columns half
+    // a period behind:
+    shading_offset = tables->shading_offsets[column->top];
+    rows_to_shade = column->top + STATUS_BAR_HEIGHT + column->shading_phase;
+    if ((x / (g_half_res_mode ? 2 : 1)) % 2) {
+      rows_to_shade += shading_offset / 2 + shading_offset % 2;
+    }
+    rows_to_shade = (shading_offset - rows_to_shade % shading_offset) %
+                    shading_offset;
+    for (y = column->top; y < bottom; ++y, pixel += bytes_per_row) {
+      if (texels != NULL) {
+        lit = texels[v >> TEXTURE_COORD_SHIFT] & texel_mask;
+        v += v_step;
+      } else if ((lit = rows_to_shade == 0)) {
+        rows_to_shade = shading_offset - 1;
+      } else {
+        rows_to_shade--;
+      }
+#ifdef PBL_COLOR
+      *pixel = lit ? color : GColorBlack.argb;
+#else
+      if (lit) {
+        *pixel |= pixel_mask;
+      } else {
+        *pixel &= ~pixel_mask;
+      }
+#endif
+    }
+  }
+  graphics_release_frame_buffer(ctx, frame_buffer);
+
+  return true;
+}
+
+/*******************************************************************************
+   Function: draw_wall_door
+
+Description: Draws the exit door on a wall face from its pre-rendered columns
+             (see "init_wall_door") straight into the frame buffer.
+
+     Inputs: ctx      - Pointer to the relevant graphics context.
+             depth    - Front-back visual depth in "g_back_wall_coords".
+             position - Left-right visual position in "g_back_wall_coords".
+             face     - BACK_WALL, LEFT_WALL or RIGHT_WALL.
+
+    Outputs: "True" if the door was drawn; otherwise, it should be drawn with
+             "fill_quad".
+*******************************************************************************/
+bool draw_wall_door(GContext *ctx,
+                    const int8_t depth,
+                    const int8_t position,
+                    const int8_t face) {
+  const wall_tables_t *tables = g_wall_tables;
+  const wall_span_t *span;
+  const wall_column_t *column;
+  int16_t x, y, i;
+  uint8_t *pixel;
+  uint16_t bytes_per_row;
+  GBitmap *frame_buffer;
+
+  if (tables == NULL) {
+    return false;
+  }
+  span = &tables->spans[depth][position][face];
+  if (span->num_columns == 0 ||
+      (frame_buffer = graphics_capture_frame_buffer(ctx)) == NULL) {
+    return false;
+  }
+  bytes_per_row = gbitmap_get_bytes_per_row(frame_buffer);
+  for (i = span->left < 0 ? -span->left : 0; i < span->num_columns; ++i) {
+    x = span->left + i;
+    column = &tables->columns[span->first_column + i];
+    if (x >= GRAPHICS_FRAME_WIDTH) {
+      break;
+    }
+    if (column->door_top == NO_DOOR || (g_half_res_mode && x % 2)) {
+      continue;
+    }
+    pixel = gbitmap_get_data(frame_buffer) +
+            (column->door_top + STATUS_BAR_HEIGHT) * bytes_per_row;
+    for (y = column->door_top;
+         y <= column->door_bottom;
+         ++y, pixel += bytes_per_row) {
+#ifdef PBL_COLOR
+      pixel[x] = GColorBlack.argb;
+#else
+      pixel[x / 8] &= ~(1 << (x % 8));
+#endif
+    }
+  }
+  graphics_release_frame_buffer(ctx, frame_buffer);
+
+  return true;
+}
+
 /*******************************************************************************
    Function: fill_quad
 
@@ -2372,6 +5147,77 @@ static void player_timer_callback(void *data) {
   layer_mark_dirty(window_get_root_layer(g_graphics_window));
 }
 
+/*******************************************************************************
+   Function: animation_timer_callback
+
+Description: Called when it's time to show the next frame of any animated
+             sprites in view.
+
+     Inputs: data - Pointer to additional data (not used).
+
+    Outputs: None.
+*******************************************************************************/
+static void animation_timer_callback(void *data) {
+  g_animation_timer = NULL;
+  if (!g_game_paused) {
+    layer_mark_dirty(window_get_root_layer(g_graphics_window));
+  }
+}
+
+/*******************************************************************************
+   Function: half_res_timer_callback
+
+Description: Called when a half-resolution transition ends, or when a scene
+             too slow for full resolution is due for another try, so the
+             scene can be redrawn at full resolution.
+
+     Inputs: data - Pointer to additional data (not used).
+
+    Outputs: None.
+*******************************************************************************/
+static void half_res_timer_callback(void *data) {
+  g_half_res_timer = NULL;
+  layer_mark_dirty(window_get_root_layer(g_graphics_window));
+}
+
+/*******************************************************************************
+   Function: input_timer_callback
+
+Description: Called when the next batch of queued inputs is due.
+
+     Inputs: data - Pointer to additional data (not used).
+
+    Outputs: None.
+*******************************************************************************/
+static void input_timer_callback(void *data) {
+  g_input_timer = NULL;
+  if (g_game_paused) {
+    g_num_queued_inputs = 0;
+  } else {
+    process_inputs();
+  }
+}
+
+#ifdef SPECULATIVE_VIEWS
+/*******************************************************************************
+   Function: speculation_timer_callback
+
+Description: Called once the player has been idle for a while, so the next
+             frame can be used to render a view ahead of time.
+
+     Inputs: data - Pointer to additional data (not used).
+
+    Outputs: None.
+*******************************************************************************/
+static void speculation_timer_callback(void *data) {
+  g_speculation_timer = NULL;
+  if (!g_game_paused && g_num_queued_inputs == 0) {
+    g_speculation_pending = true;
+    layer_mark_dirty(window_get_root_layer(g_graphics_window));
+  }
+}
+#endif
+
 /*******************************************************************************
    Function: main_menu_window_appear
 
@@ -2398,6 +5244,8 @@ Description: Called when the graphics window appears.
 static void graphics_window_appear(Window *window) {
   g_game_paused = false;
   g_player_animation_mode = 0;
+  g_num_queued_inputs = 0;
+  g_input_batch_pending = false;
 }
 
 /*******************************************************************************
@@ -2411,6 +5259,153 @@ Description: Called when the graphics window disappears.
 *******************************************************************************/
 static void graphics_window_disappear(Window *window) {
   g_game_paused = true;
+#ifdef SPECULATIVE_VIEWS
+  cancel_speculation();
+#endif
+  if (g_static_view != NULL) {
+    g_static_view->on_screen = false;  // Other windows will draw over it.
+  }
+}
+
+/*******************************************************************************
+   Function: queue_input
+
+Description: Adds a player input to the input queue, to be processed with the
+             next batch (see "process_inputs"). A turn cancels a queued turn
+             in the opposite direction, and a shot is dropped if another one's
+             still waiting, as is any input once the queue is full.
+
+     Inputs: input - The type of input.
+
+    Outputs: None.
+*******************************************************************************/
+void queue_input(const int8_t input) {
+  int8_t i;
+
+  if (g_game_paused) {
+    return;
+  }
+  if (g_num_queued_inputs > 0 &&
+      ((input == INPUT_TURN_LEFT &&
+        g_input_queue[g_num_queued_inputs - 1] == INPUT_TURN_RIGHT) ||
+       (input == INPUT_TURN_RIGHT &&
+        g_input_queue[g_num_queued_inputs - 1] == INPUT_TURN_LEFT))) {
+    g_num_queued_inputs--;
+
+    return;
+  }
+  for (i = 0; i < g_num_queued_inputs; ++i) {
+    if (input == INPUT_FIRE && g_input_queue[i] == INPUT_FIRE) {
+      return;
+    }
+  }
+  if (g_num_queued_inputs < MAX_QUEUED_INPUTS) {
+    g_input_queue[g_num_queued_inputs++] = input;
+  }
+
+  // Process inputs as soon as the previous batch is on screen:
+  if (!g_input_batch_pending && g_input_timer == NULL) {
+    g_input_timer = app_timer_register(0, input_timer_callback, NULL);
+  }
+}
+
+/*******************************************************************************
+   Function: process_inputs
+
+Description: Processes the next batch of queued inputs, in the order received:
+             at most one step or turn plus at most one shot, so a frame can
+             show both moving and firing but never skips over a step. Any
+             further inputs wait for the frame after this batch is drawn.
+
+     Inputs: None.
+
+    Outputs: None.
+*******************************************************************************/
+void process_inputs(void) {
+  int8_t i;
+  bool moved = false, fired = false;
+
+  for (i = 0; i < g_num_queued_inputs; ++i) {
+    if (g_input_queue[i] == INPUT_FIRE) {
+      if (fired) {
+        break;
+      }
+      fired = true;
+      fire_player_laser();
+    } else {
+      if (moved) {
+        break;
+      }
+      moved = true;
+      start_half_res_transition();
+      switch (g_input_queue[i]) {
+        case INPUT_FORWARD:
+          move_player(g_player->direction);
+          break;
+        case INPUT_BACKWARD:
+          move_player(get_opposite_direction(g_player->direction));
+          break;
+        case INPUT_TURN_LEFT:
+          set_player_direction(
+            get_direction_to_the_left(g_player->direction));
+          break;
+        default:  // case INPUT_TURN_RIGHT:
+          set_player_direction(
+            get_direction_to_the_right(g_player->direction));
+          break;
+      }
+    }
+
+    // If that input ended the mission, the rest are moot:
+    if (g_mission == NULL || g_game_paused) {
+      g_num_queued_inputs = 0;
+
+      return;
+    }
+  }
+  g_num_queued_inputs -= i;
+  memmove(g_input_queue, g_input_queue + i, g_num_queued_inputs);
+  g_input_batch_pending = true;
+  layer_mark_dirty(window_get_root_layer(g_graphics_window));
+}
+
+/*******************************************************************************
+   Function: fire_player_laser
+
+Description: Fires the player's laser gun (if there's enough energy), damaging
+             the first NPC or solid cell in the player's line of fire.
+
+     Inputs: None.
+
+    Outputs: None.
+*******************************************************************************/
+void fire_player_laser(void) {
+  GPoint cell;
+  npc_t *npc;
+
+  if (g_player->stats[CURRENT_ENERGY] < ENERGY_LOSS_PER_SHOT) {
+    return;
+  }
+
+  // Deplete the player's ammo and set up the player's laser animation:
+  adjust_player_current_ammo(ENERGY_LOSS_PER_SHOT * -1);
+  g_player_animation_mode = NUM_PLAYER_ANIMATIONS;
+  g_laser_base_width = MAX_LASER_BASE_WIDTH;
+  g_player_timer = app_timer_register(PLAYER_TIMER_DURATION,
+                                      player_timer_callback,
+                                      NULL);
+
+  // Check for a damaged NPC or cell:
+  cell = get_cell_farther_away(g_player->position, g_player->direction, 1);
+  while (get_cell_type(cell) < SOLID) {
+    npc = get_npc_at(cell);
+    if (npc != NULL) {
+      damage_npc(npc, g_player->stats[POWER]);
+      return;
+    }
+    cell = get_cell_farther_away(cell, g_player->direction, 1);
+  }
+  damage_cell(cell, g_player->stats[POWER]);
 }
 
 /*******************************************************************************
@@ -2426,9 +5421,7 @@ Description: The graphics window's single repeating click handler for the "up"
 *******************************************************************************/
 void graphics_up_single_repeating_click(ClickRecognizerRef recognizer,
                                         void *context) {
-  if (!g_game_paused) {
-    move_player(g_player->direction);
-  }
+  queue_input(INPUT_FORWARD);
 }
 
 /*******************************************************************************
@@ -2443,9 +5436,7 @@ Description: The graphics window's multi-click handler for the "up" button.
     Outputs: None.
 *******************************************************************************/
 void graphics_up_multi_click(ClickRecognizerRef recognizer, void *context) {
-  if (!g_game_paused) {
-    set_player_direction(get_direction_to_the_left(g_player->direction));
-  }
+  queue_input(INPUT_TURN_LEFT);
 }
 
 /*******************************************************************************
@@ -2461,9 +5452,7 @@ Description: The graphics window's single repeating click handler for the "down"
 *******************************************************************************/
 void graphics_down_single_repeating_click(ClickRecognizerRef recognizer,
                                           void *context) {
-  if (!g_game_paused) {
-    move_player(get_opposite_direction(g_player->direction));
-  }
+  queue_input(INPUT_BACKWARD);
 }
 
 /*******************************************************************************
@@ -2478,9 +5467,7 @@ Description: The graphics window's multi-click handler for the "down" button.
     Outputs: None.
 *******************************************************************************/
 void graphics_down_multi_click(ClickRecognizerRef recognizer, void *context) {
-  if (!g_game_paused) {
-    set_player_direction(get_direction_to_the_right(g_player->direction));
-  }
+  queue_input(INPUT_TURN_RIGHT);
 }
 
 /*******************************************************************************
@@ -2496,33 +5483,7 @@ Description: The graphics window's single repeating click handler for the
 *******************************************************************************/
 void graphics_select_single_repeating_click(ClickRecognizerRef recognizer,
                                             void *context) {
-  GPoint cell;
-  npc_t *npc;
-
-  if (!g_game_paused &&
-      g_player->stats[CURRENT_ENERGY] >= ENERGY_LOSS_PER_SHOT) {
-    // Deplete the player's ammo and set up the player's laser animation:
-    adjust_player_current_ammo(ENERGY_LOSS_PER_SHOT * -1);
-    g_player_animation_mode = NUM_PLAYER_ANIMATIONS;
-    g_laser_base_width = MAX_LASER_BASE_WIDTH;
-    g_player_timer = app_timer_register(PLAYER_TIMER_DURATION,
-                                        player_timer_callback,
-                                        NULL);
-
-    // Check for a damaged NPC or cell:
-    cell = get_cell_farther_away(g_player->position, g_player->direction, 1);
-    while (get_cell_type(cell) < SOLID) {
-      npc = get_npc_at(cell);
-      if (npc != NULL) {
-        damage_npc(npc, g_player->stats[POWER]);
-        return;
-      }
-      cell = get_cell_farther_away(cell, g_player->direction, 1);
-    }
-    damage_cell(cell, g_player->stats[POWER]);
-
-    layer_mark_dirty(window_get_root_layer(g_graphics_window));
-  }
+  queue_input(INPUT_FIRE);
 }
 
 /*******************************************************************************
@@ -2623,26 +5584,25 @@ Description: Handles changes to the game world every second while in active
     Outputs: None.
 *******************************************************************************/
 static void tick_handler(struct tm *tick_time, TimeUnits units_changed) {
-  int8_t i, current_num_npcs = 0;
+  int8_t i;
 
   if (!g_game_paused) {
-    // Handle NPC behavior:
+    // Handle NPC behavior, sharing one set of perception data:
+    update_blackboard();
     for (i = 0; i < MAX_NPCS_AT_ONE_TIME; ++i) {
       if (g_mission->npcs[i].type != NONE) {
         determine_npc_behavior(&g_mission->npcs[i]);
-        if (g_player->stats[CURRENT_HP] <= 0) {
+        if (g_game_paused) {  // The player died.
           return;
         }
-        current_num_npcs++;
       }
     }
 
-    // Determine whether a new NPC should be generated:
-    if (current_num_npcs < MAX_NPCS_AT_ONE_TIME &&
-        g_mission->kills + current_num_npcs < g_mission->total_num_npcs &&
-        rand() % 5 == 0) {
-      add_new_npc(RANDOM_NPC_TYPE, get_npc_spawn_point());
-    }
+    // Run the mission script (reinforcements, timed events, etc.):
+    run_script_thread(&g_script_state.main_thread, 0, GPoint(-1, -1));
+
+    // Free up cached data if the heap is running low:
+    trim_caches();
 
     // Handle player stat recovery:
     adjust_player_current_hp(HP_RECOVERY_RATE);
@@ -2665,6 +5625,12 @@ Description: Handles SpaceMerc going out of, or coming back into, focus (e.g.,
 void app_focus_handler(const bool in_focus) {
   if (!in_focus) {
     g_game_paused = true;
+#ifdef SPECULATIVE_VIEWS
+    cancel_speculation();
+#endif
+    if (g_static_view != NULL) {
+      g_static_view->on_screen = false;  // Other windows will draw over it.
+    }
   } else {
     if (window_stack_get_top_window() == g_graphics_window) {
       g_game_paused = false;
@@ -2810,6 +5776,281 @@ void init_wall_coords(void) {
   }
 }
 
+/*******************************************************************************
+   Function: get_wall_tables
+
+Description: Returns the pre-rendered wall columns, building them (see
+             "init_wall_columns") if the cache manager has room for them.
+             Building may evict other caches, so it's done before drawing a
+             scene starts, not while walls are drawn.
+
+     Inputs: None.
+
+    Outputs: Pointer to the wall tables, or NULL if there wasn't room (in which
+             case walls should be drawn with "draw_shaded_quad" and
+             "fill_quad").
+*******************************************************************************/
+wall_tables_t *get_wall_tables(void) {
+  if (g_wall_tables == NULL &&
+      reserve_cache_memory(WALL_CACHE, sizeof(wall_tables_t)) &&
+      (g_wall_tables = malloc(sizeof(wall_tables_t))) != NULL) {
+    update_cache_size(WALL_CACHE, sizeof(wall_tables_t));
+    init_wall_columns();
+  }
+
+  return g_wall_tables;
+}
+
+/*******************************************************************************
+   Function: init_wall_columns
+
+Description: Pre-renders into "g_wall_tables" every wall face the player could
+             see, at every depth and position in "g_back_wall_coords", as
+             screen columns: each with the texture column it samples, the
+             phase of its shading pattern and the rows any exit door covers,
+             as "draw_cell_walls" would draw them. Each column height's
+             texture step and shading period are precomputed, too. Side walls
+             get perspective-correct texture columns, since the divisions all
+             happen here rather than while drawing.
+
+     Inputs: None.
+
+    Outputs: None.
+*******************************************************************************/
+void init_wall_columns(void) {
+  int8_t depth, position;
+  int16_t i, left, right, top, bottom, y_offset, exit_offset_x, exit_offset_y;
+  uint16_t num_columns = 0, back_wall_columns;
+  uint8_t shading_offset;
+  wall_span_t *span;
+
+  // Texture step and shading by the column's top row (see "draw_shaded_quad"):
+  for (top = 0; top < MAX_WALL_TOP; ++top) {
+    g_wall_tables->texture_steps[top] =
+      (WALL_TEXTURE_SIZE << TEXTURE_COORD_SHIFT) /
+      (GRAPHICS_FRAME_HEIGHT - 2 * top);
+    shading_offset = 1 + (top + STATUS_BAR_HEIGHT) / MAX_VISIBILITY_DEPTH;
+    if ((top + STATUS_BAR_HEIGHT) % MAX_VISIBILITY_DEPTH >=
+        MAX_VISIBILITY_DEPTH / 2 + MAX_VISIBILITY_DEPTH % 2) {
+      shading_offset++;
+    }
+    g_wall_tables->shading_offsets[top] = shading_offset;
+#ifdef PBL_COLOR
+    if (shading_offset - 3 > NUM_BACKGROUND_COLORS_PER_SCHEME) {
+      g_wall_tables->shades[top] = NUM_BACKGROUND_COLORS_PER_SCHEME - 1;
+    } else if (shading_offset > 4) {
+      g_wall_tables->shades[top] = shading_offset - 4;
+    } else {
+      g_wall_tables->shades[top] = 0;
+    }
+#endif
+  }
+
+  for (depth = 0; depth < MAX_VISIBILITY_DEPTH - 1; ++depth) {
+    // Back walls at a given depth differ only in position, so share columns:
+    left = g_back_wall_coords[depth][STRAIGHT_AHEAD][TOP_LEFT].x;
+    right = g_back_wall_coords[depth][STRAIGHT_AHEAD][BOTTOM_RIGHT].x;
+    top = g_back_wall_coords[depth][STRAIGHT_AHEAD][TOP_LEFT].y;
+    bottom = g_back_wall_coords[depth][STRAIGHT_AHEAD][BOTTOM_RIGHT].y;
+    exit_offset_x = (right - left) / 3;
+    exit_offset_y = (right - left) / 4;
+    back_wall_columns = num_columns;
+    for (i = left; i <= right && num_columns < MAX_WALL_COLUMNS; ++i) {
+      g_wall_tables->columns[num_columns] = (wall_column_t) {
+        .top = top,
+        .u = (i - left) * WALL_TEXTURE_SIZE / (right - left + 1),
+        .shading_phase = 0,
+        .door_top = NO_DOOR,
+      };
+      num_columns++;
+    }
+    for (position = 0; position < (STRAIGHT_AHEAD * 2) + 1; ++position) {
+      g_wall_tables->spans[depth][position][BACK_WALL] = (wall_span_t) {
+        .left = g_back_wall_coords[depth][position][TOP_LEFT].x,
+        .first_column = back_wall_columns,
+        .num_columns = num_columns - back_wall_columns,
+      };
+    }
+    init_wall_door(&g_wall_tables->spans[depth][STRAIGHT_AHEAD][BACK_WALL],
+                   GPoint(left + exit_offset_x,
+                          top + exit_offset_y + STATUS_BAR_HEIGHT),
+                   GPoint(left + exit_offset_x,
+                          bottom - 1 + STATUS_BAR_HEIGHT),
+                   GPoint(left + exit_offset_x * 2 - 1,
+                          top + exit_offset_y + STATUS_BAR_HEIGHT));
+
+    // Side walls, as laid out by "draw_cell_walls" (which draws only those
+    // facing the player):
+    for (position = 0; position < (STRAIGHT_AHEAD * 2) + 1; ++position) {
+      exit_offset_y = (g_back_wall_coords[depth][position][BOTTOM_RIGHT].x -
+                       g_back_wall_coords[depth][position][TOP_LEFT].x) / 4;
+      g_wall_tables->spans[depth][position][LEFT_WALL].num_columns = 0;
+      g_wall_tables->spans[depth][position][RIGHT_WALL].num_columns = 0;
+      if (depth == 0) {
+        y_offset = top;
+      } else {
+        y_offset = top - g_back_wall_coords[depth - 1][position][TOP_LEFT].y;
+      }
+      if (position <= STRAIGHT_AHEAD) {
+        span = &g_wall_tables->spans[depth][position][LEFT_WALL];
+        left = depth == 0 ? 0 :
+                 g_back_wall_coords[depth - 1][position][TOP_LEFT].x;
+        right = g_back_wall_coords[depth][position][TOP_LEFT].x;
+        exit_offset_x = (right - left) / 3;
+        init_side_wall_span(span,
+                            left,
+                            right,
+                            top - y_offset,
+                            top,
+                            &num_columns);
+        init_wall_door(span,
+                       GPoint(depth == 0 ? 0 : left + exit_offset_x,
+                              top - (depth == 0 ? y_offset - 4: y_offset / 3) +
+                                exit_offset_y + STATUS_BAR_HEIGHT),
+                       GPoint(depth == 0 ? 0 : left + exit_offset_x,
+                              bottom + (depth == 0 ? y_offset : y_offset / 3) +
+                                STATUS_BAR_HEIGHT),
+                       GPoint(right - exit_offset_x,
+                              top + exit_offset_y + STATUS_BAR_HEIGHT));
+      }
+      if (position >= STRAIGHT_AHEAD) {
+        span = &g_wall_tables->spans[depth][position][RIGHT_WALL];
+        left = g_back_wall_coords[depth][position][BOTTOM_RIGHT].x;
+        right = depth == 0 ? GRAPHICS_FRAME_WIDTH - 1 :
+                  g_back_wall_coords[depth - 1][position][BOTTOM_RIGHT].x;
+        exit_offset_x = (right - left) / 3;
+        init_side_wall_span(span,
+                            left,
+                            right,
+                            top,
+                            top - y_offset,
+                            &num_columns);
+        init_wall_door(span,
+                       GPoint(left + exit_offset_x,
+                              top + exit_offset_y + STATUS_BAR_HEIGHT),
+                       GPoint(left + exit_offset_x,
+                              bottom + 4 + STATUS_BAR_HEIGHT),
+                       GPoint(depth == 0 ? GRAPHICS_FRAME_WIDTH :
+                                           right - exit_offset_x,
+                              top - (depth == 0 ? y_offset - 5 :
+                                                  y_offset / 3) +
+                                exit_offset_y + STATUS_BAR_HEIGHT));
+      }
+    }
+  }
+}
+
+/*******************************************************************************
+   Function: init_side_wall_span
+
+Description: Pre-renders the on-screen columns of a side wall face. Texture
+             columns are spaced by inverse height (i.e., by distance), running
+             from the face's near edge to its far edge.
+
+     Inputs: span        - Pointer to the face's span.
+             left        - Screen column of the face's left edge.
+             right       - Screen column of the face's right edge.
+             left_top    - Top row of the left edge.
+             right_top   - Top row of the right edge.
+             num_columns - Pointer to the no. of wall columns so far
+                           (updated).
+
+    Outputs: "True" if every on-screen column fit in "g_wall_tables".
+*******************************************************************************/
+bool init_side_wall_span(wall_span_t *span,
+                         const int16_t left,
+                         const int16_t right,
+                         const int16_t left_top,
+                         const int16_t right_top,
+                         uint16_t *num_columns) {
+  int16_t i, top;
+  const float dy_over_dx = right > left ?
+                             (float) (right_top - left_top) / (right - left) :
+                             0,
+              near_height = GRAPHICS_FRAME_HEIGHT - 2 * (left_top < right_top ?
+                                                           left_top :
+                                                           right_top),
+              far_height = GRAPHICS_FRAME_HEIGHT - 2 * (left_top < right_top ?
+                                                          right_top :
+                                                          left_top);
+  float distance;
+
+  span->left = left < 0 ? 0 : left;
+  span->first_column = *num_columns;
+  span->num_columns = 0;
+  for (i = span->left;
+       i <= right && i < GRAPHICS_FRAME_WIDTH;
+       ++i, ++span->num_columns) {
+    if (*num_columns == MAX_WALL_COLUMNS) {
+      span->num_columns = 0;
+
+      return false;
+    }
+
+    // Rounded as "draw_shaded_quad" rounds it, relative to the status bar:
+    top = (int16_t) (left_top + STATUS_BAR_HEIGHT + (i - left) * dy_over_dx) -
+          STATUS_BAR_HEIGHT;
+    distance = near_height == far_height ?
+                 (float) (i - left) / (right - left + 1) :
+                 (1.0 / (GRAPHICS_FRAME_HEIGHT - 2 * top) - 1.0 / near_height) /
+                   (1.0 / far_height - 1.0 / near_height);
+    g_wall_tables->columns[(*num_columns)++] = (wall_column_t) {
+      .top = top,
+      .u = distance <= 0 ? 0 :
+           distance >= 1 ? WALL_TEXTURE_SIZE - 1 :
+                           (uint8_t) (distance * WALL_TEXTURE_SIZE),
+      .shading_phase = (i - left) * dy_over_dx,
+      .door_top = NO_DOOR,
+    };
+  }
+
+  return true;
+}
+
+/*******************************************************************************
+   Function: init_wall_door
+
+Description: Pre-renders the exit door on a wall face's columns, covering the
+             rows "fill_quad" would (given the same corners).
+
+     Inputs: span        - Pointer to the face's span.
+             upper_left  - Coordinates of the door's upper-left point.
+             lower_left  - Coordinates of the door's lower-left point.
+             upper_right - Coordinates of the door's upper-right point.
+
+    Outputs: None.
+*******************************************************************************/
+void init_wall_door(const wall_span_t *span,
+                    const GPoint upper_left,
+                    const GPoint lower_left,
+                    const GPoint upper_right) {
+  int16_t i, door_top, door_bottom, swap;
+  const float dy_over_width = upper_right.x > upper_left.x ?
+                                (float) (upper_right.y - upper_left.y) /
+                                  (upper_right.x - upper_left.x) :
+                                0;
+  wall_column_t *column;
+
+  for (i = upper_left.x > span->left ? upper_left.x : span->left;
+       i <= upper_right.x && i < span->left + span->num_columns;
+       ++i) {
+    column = &g_wall_tables->columns[span->first_column + i - span->left];
+    door_top = (int16_t) (upper_left.y + (i - upper_left.x) * dy_over_width) -
+               STATUS_BAR_HEIGHT;
+    door_bottom = (int16_t) (lower_left.y -
+                             (i - upper_left.x) * dy_over_width) -
+                  STATUS_BAR_HEIGHT;
+    if (door_top > door_bottom) {
+      swap = door_top;
+      door_top = door_bottom;
+      door_bottom = swap;
+    }
+    column->door_top = door_top < 0 ? 0 : door_top;
+    column->door_bottom = door_bottom < GRAPHICS_FRAME_HEIGHT ?
+                            door_bottom : GRAPHICS_FRAME_HEIGHT - 1;
+  }
+}
+
 /*******************************************************************************
    Function: init_mission
 
@@ -2823,18 +6064,22 @@ Description: Initializes the global mission struct according to a given mission
 void init_mission(const int8_t type) {
   int8_t i;
 
+  g_mission_history.num_checkpoints = 0;  // No logging during generation.
 #ifdef PBL_COLOR
   g_mission->floor_color_scheme = rand() % NUM_BACKGROUND_COLOR_SCHEMES;
   g_mission->wall_color_scheme = rand() % NUM_BACKGROUND_COLOR_SCHEMES;
 #endif
   g_mission->type = type;
+  g_mission->location = rand() % NUM_LOCATION_TYPES;
   g_mission->completed = false;
   g_mission->total_num_npcs = 5 * (rand() % 4 + 1);  // 5-20
-  g_mission->reward = 600 * g_mission->total_num_npcs;  // $3-12,000
+  g_mission->reward = 0;  // Set by the mission script.
   g_mission->kills = 0;
   for (i = 0; i < MAX_NPCS_AT_ONE_TIME; ++i) {
     g_mission->npcs[i].type = NONE;
   }
+  load_mission_script(type);
+  init_script_state();
   init_mission_location();
 
   // Move and orient the player and restore his/her HP and ammo:
@@ -2842,6 +6087,7 @@ void init_mission(const int8_t type) {
   g_player->position = g_mission->entrance;
   g_player->stats[CURRENT_HP] = g_player->stats[MAX_HP];
   g_player->stats[CURRENT_ENERGY] = g_player->stats[MAX_ENERGY];
+  init_mission_history();
 
   // Finally, present mission information:
   g_current_narration = type;
@@ -2921,15 +6167,311 @@ void init_mission_location(void) {
     }
   }
   set_cell_type(builder_position, EMPTY);
+  compute_distance_field(g_exit_distances, &g_mission->entrance, 1);
+
+  // Finally, let the mission script add special NPCs, set the reward, etc.:
+  run_mission_script_event(SCRIPT_START, 0, end_point);
+}
+
+/*******************************************************************************
+   Function: init_mission_history
+
+Description: Clears the mission history and saves the current (starting) state
+             of the mission as its first checkpoint.
+
+     Inputs: None.
+
+    Outputs: None.
+*******************************************************************************/
+void init_mission_history(void) {
+  g_mission_history.num_cell_deltas = 0;
+  capture_checkpoint(&g_mission_history.checkpoints[0]);
+  g_mission_history.num_checkpoints = 1;
+}
+
+/*******************************************************************************
+   Function: load_mission_script
+
+Description: Loads the bytecode script for a given mission type from its
+             resource (see "tools/mission_scripts.c"). If the script is missing
+             or malformed, the mission runs without one.
+
+     Inputs: type - The mission type.
+
+    Outputs: "True" if the script was loaded.
+*******************************************************************************/
+bool load_mission_script(const int8_t type) {
+  const ResHandle handle =
+    resource_get_handle(RESOURCE_ID_MISSION_SCRIPT_0 + type);
+
+  g_mission_script_size = 0;
+  if (resource_size(handle) < SCRIPT_HEADER_SIZE ||
+      resource_size(handle) > MAX_SCRIPT_SIZE) {
+    return false;
+  }
+  g_mission_script_size = resource_load(handle,
+                                        g_mission_script,
+                                        MAX_SCRIPT_SIZE);
+
+  return true;
+}
+
+/*******************************************************************************
+   Function: init_script_state
+
+Description: Clears the mission script's variables and points its main thread
+             at the script's "SCRIPT_TICK" entry point.
+
+     Inputs: None.
+
+    Outputs: None.
+*******************************************************************************/
+void init_script_state(void) {
+  memset(&g_script_state, 0, sizeof(script_state_t));
+  g_script_state.main_thread.pc = get_script_entry(SCRIPT_TICK);
+}
+
+/*******************************************************************************
+   Function: run_mission_script_event
+
+Description: Runs the mission script's handler for a given event, if it has
+             one. Handlers run to completion within a single instruction
+             budget; one that waits or overruns its budget is abandoned.
+
+     Inputs: event - The event type.
+             arg   - Event argument, readable via "VALUE_EVENT_ARG".
+             cell  - Coordinates associated with the event.
+
+    Outputs: None.
+*******************************************************************************/
+void run_mission_script_event(const int8_t event,
+                              const int16_t arg,
+                              const GPoint cell) {
+  script_thread_t thread = {.pc = get_script_entry(event)};
+
+  run_script_thread(&thread, arg, cell);  // Not resumed if unfinished.
+}
+
+/*******************************************************************************
+   Function: run_script_thread
+
+Description: Executes a mission script thread cooperatively, until it waits,
+             ends, faults or uses up its instruction budget (in which case it
+             resumes where it left off on the next call). Faults, such as stack
+             over- or underflows and out-of-range operands, end the thread.
+
+     Inputs: thread - Pointer to the thread's execution state.
+             arg    - Event argument, readable via "VALUE_EVENT_ARG".
+             cell   - Coordinates associated with the current event.
+
+    Outputs: "True" if the thread is still running (i.e., it may be resumed).
+*******************************************************************************/
+bool run_script_thread(script_thread_t *thread,
+                       const int16_t arg,
+                       const GPoint cell) {
+  int8_t budget, num_inputs;
+  uint8_t opcode, operand_size;
+  int16_t a = 0, b = 0;
+  uint16_t operand = 0;
+
+  if (thread->pc == NO_SCRIPT_ENTRY) {
+    return false;
+  }
+  if (thread->wait > 0 && --thread->wait > 0) {
+    return true;
+  }
+  for (budget = 0; budget < SCRIPT_INSTRUCTION_BUDGET; ++budget) {
+    if (thread->pc >= g_mission_script_size) {
+      goto fault;
+    }
+    opcode = g_mission_script[thread->pc++];
+
+    if (opcode >= NUM_SCRIPT_OPCODES) {
+      goto fault;
+    }
 
-  // Finally, add special NPCs, etc., if applicable:
-  if (g_mission->type == ASSASSINATE) {
-    add_new_npc(ALIEN_OFFICER, end_point);
-  } else if (g_mission->type == EXPROPRIATE) {
-    set_cell_type(end_point, ITEM);
-  } else if (g_mission->type == EXTRICATE) {
-    set_cell_type(end_point, HUMAN);
+    // Fetch the operand, if any:
+    operand_size = g_script_opcode_formats[opcode][OPERAND_SIZE];
+    if (thread->pc + operand_size > g_mission_script_size) {
+      goto fault;
+    }
+    if (operand_size > 0) {
+      operand = g_mission_script[thread->pc];
+      if (operand_size == 2) {
+        operand |= g_mission_script[thread->pc + 1] << 8;
+      }
+      thread->pc += operand_size;
+    }
+
+    // Pop inputs off the stack ("a" is the first pushed, "b" the second):
+    num_inputs = g_script_opcode_formats[opcode][NUM_INPUTS];
+    if (thread->sp < num_inputs) {
+      goto fault;
+    }
+    if (num_inputs == 2) {
+      b = thread->stack[--thread->sp];
+    }
+    if (num_inputs > 0) {
+      a = thread->stack[--thread->sp];
+    }
+    if ((opcode == OP_LOAD || opcode == OP_STORE) &&
+        operand >= NUM_SCRIPT_VARS) {
+      goto fault;
+    }
+
+    switch (opcode) {
+      case OP_END:
+        thread->pc = NO_SCRIPT_ENTRY;
+
+        return false;
+      case OP_PUSH:
+        a = (int16_t) operand;
+        break;
+      case OP_LOAD:
+        a = g_script_state.vars[operand];
+        break;
+      case OP_STORE:
+        g_script_state.vars[operand] = a;
+        continue;
+      case OP_GET:
+        a = get_script_value(operand, arg);
+        break;
+      case OP_ADD:
+        a += b;
+        break;
+      case OP_SUB:
+        a -= b;
+        break;
+      case OP_MUL:
+        a *= b;
+        break;
+      case OP_LESS:
+        a = a < b;
+        break;
+      case OP_EQUAL:
+        a = a == b;
+        break;
+      case OP_NOT:
+        a = !a;
+        break;
+      case OP_AND:
+        a = a && b;
+        break;
+      case OP_RANDOM:
+        if (a <= 0) {
+          goto fault;
+        }
+        a = rand() % a;
+        break;
+      case OP_JUMP:
+        thread->pc = operand;
+        continue;
+      case OP_JUMP_IF_NOT:
+        if (!a) {
+          thread->pc = operand;
+        }
+        continue;
+      case OP_WAIT:
+        thread->wait = a > 0 ? a : 0;
+
+        return true;
+      case OP_SPAWN:
+        if (a < 0 || a >= NUM_NPC_TYPES) {
+          goto fault;
+        }
+        add_new_npc(a, get_npc_spawn_point());
+        continue;
+      case OP_SPAWN_AT_EVENT:
+        if (a < 0 || a >= NUM_NPC_TYPES || out_of_bounds(cell)) {
+          goto fault;
+        }
+        add_new_npc(a, cell);
+        continue;
+      case OP_PLACE_AT_EVENT:
+        if (a < HUMAN || a >= SOLID || out_of_bounds(cell)) {
+          goto fault;
+        }
+        set_cell_type(cell, a);
+        continue;
+      case OP_SET_REWARD:
+        g_mission->reward = a;
+        continue;
+      case OP_COMPLETE:
+        g_mission->completed = true;
+        continue;
+      default:
+        goto fault;
+    }
+
+    // Push the result (for opcodes that "break" rather than "continue"):
+    if (thread->sp == SCRIPT_STACK_SIZE) {
+      goto fault;
+    }
+    thread->stack[thread->sp++] = a;
+  }
+
+  return true;  // Out of budget: resume here next time.
+
+fault:
+  thread->pc = NO_SCRIPT_ENTRY;  // A faulty thread simply ends.
+
+  return false;
+}
+
+/*******************************************************************************
+   Function: get_script_value
+
+Description: Returns a game value on behalf of a mission script.
+
+     Inputs: value - Which value to return ("VALUE_KILLS", etc.).
+             arg   - The current event's argument.
+
+    Outputs: The requested value (zero if unknown).
+*******************************************************************************/
+int16_t get_script_value(const int8_t value, const int16_t arg) {
+  int8_t i, num_npcs = 0;
+
+  switch (value) {
+    case VALUE_KILLS:
+      return g_mission->kills;
+    case VALUE_TOTAL_NPCS:
+      return g_mission->total_num_npcs;
+    case VALUE_NPCS_PRESENT:
+      for (i = 0; i < MAX_NPCS_AT_ONE_TIME; ++i) {
+        if (g_mission->npcs[i].type != NONE) {
+          num_npcs++;
+        }
+      }
+
+      return num_npcs;
+    case VALUE_EVENT_ARG:
+      return arg;
+    case VALUE_COMPLETED:
+      return g_mission->completed;
+    default:
+      return 0;
+  }
+}
+
+/*******************************************************************************
+   Function: get_script_entry
+
+Description: Looks up the mission script's entry point for a given event.
+
+     Inputs: event - The event type.
+
+    Outputs: Offset of the event's handler within the script, or
+             "NO_SCRIPT_ENTRY" if there is none.
+*******************************************************************************/
+uint16_t get_script_entry(const int8_t event) {
+  uint16_t entry;
+
+  if (g_mission_script_size < SCRIPT_HEADER_SIZE) {
+    return NO_SCRIPT_ENTRY;
   }
+  entry = g_mission_script[event * 2] | g_mission_script[event * 2 + 1] << 8;
+
+  return entry < g_mission_script_size ? entry : NO_SCRIPT_ENTRY;
 }
 
 /*******************************************************************************
@@ -2947,6 +6489,7 @@ void deinit_mission(void) {
     free(g_mission);
     g_mission = NULL;
   }
+  g_mission_history.num_checkpoints = 0;
 }
 
 /*******************************************************************************
@@ -2998,7 +6541,10 @@ Description: Initializes the graphics window.
 void init_graphics(void) {
   // Graphics window:
   g_graphics_window = window_create();
-  window_set_background_color(g_graphics_window, GColorBlack);
+
+  // No background color, so the frame buffer keeps the displayed scene while
+  // views are rendered ahead of time (see "speculate"):
+  window_set_background_color(g_graphics_window, GColorClear);
   window_set_window_handlers(g_graphics_window, (WindowHandlers) {
     .appear = graphics_window_appear,
     .disappear = graphics_window_disappear,
@@ -3007,6 +6553,16 @@ void init_graphics(void) {
                                    (ClickConfigProvider)
                                    graphics_click_config_provider);
   layer_set_update_proc(window_get_root_layer(g_graphics_window), draw_scene);
+  register_cache(SPRITE_CACHE, deinit_sprite_cache, SPRITE_CACHE_PRIORITY);
+#ifdef SPECULATIVE_VIEWS
+  register_cache(VIEW_CACHE, deinit_views, VIEW_CACHE_PRIORITY);
+#endif
+#ifdef COMPOSITED_SCENES
+  register_cache(STATIC_VIEW_CACHE,
+                 deinit_static_view,
+                 STATIC_VIEW_CACHE_PRIORITY);
+#endif
+  register_cache(WALL_CACHE, deinit_wall_tables, WALL_CACHE_PRIORITY);
 
 #ifdef PBL_COLOR
   // Blue background color scheme:
@@ -3121,9 +6677,158 @@ Description: Deinitializes the graphics window.
 *******************************************************************************/
 void deinit_graphics(void) {
   tick_timer_service_unsubscribe();
+  if (g_animation_timer != NULL) {
+    app_timer_cancel(g_animation_timer);
+    g_animation_timer = NULL;
+  }
+  if (g_half_res_timer != NULL) {
+    app_timer_cancel(g_half_res_timer);
+    g_half_res_timer = NULL;
+  }
+  if (g_input_timer != NULL) {
+    app_timer_cancel(g_input_timer);
+    g_input_timer = NULL;
+  }
+#ifdef SPECULATIVE_VIEWS
+  cancel_speculation();
+  deinit_views();
+#endif
+#ifdef COMPOSITED_SCENES
+  deinit_static_view();
+#endif
+  deinit_wall_tables();
+  deinit_sprite_cache();
   window_destroy(g_graphics_window);
 }
 
+#ifdef SPECULATIVE_VIEWS
+/*******************************************************************************
+   Function: deinit_views
+
+Description: Frees every view rendered ahead of time.
+
+     Inputs: None.
+
+    Outputs: None.
+*******************************************************************************/
+void deinit_views(void) {
+  int8_t i;
+
+  for (i = 0; i < MAX_VIEWS; ++i) {
+    if (g_views[i].data != NULL) {
+      free_view(&g_views[i]);
+    }
+  }
+}
+#endif
+
+#ifdef COMPOSITED_SCENES
+/*******************************************************************************
+   Function: deinit_static_view
+
+Description: Frees the static view.
+
+     Inputs: None.
+
+    Outputs: None.
+*******************************************************************************/
+void deinit_static_view(void) {
+  if (g_static_view != NULL) {
+    update_cache_size(STATIC_VIEW_CACHE,
+                      -(int32_t) (sizeof(static_view_t) + g_static_view->size));
+    free(g_static_view);
+    g_static_view = NULL;
+  }
+}
+#endif
+
+/*******************************************************************************
+   Function: deinit_wall_tables
+
+Description: Frees the pre-rendered wall columns.
+
+     Inputs: None.
+
+    Outputs: None.
+*******************************************************************************/
+void deinit_wall_tables(void) {
+  if (g_wall_tables != NULL) {
+    free(g_wall_tables);
+    g_wall_tables = NULL;
+    update_cache_size(WALL_CACHE, -(int32_t) sizeof(wall_tables_t));
+  }
+}
+
+/*******************************************************************************
+   Function: deinit_sprite_cache
+
+Description: Frees every pre-rasterized sprite frame.
+
+     Inputs: None.
+
+    Outputs: None.
+*******************************************************************************/
+void deinit_sprite_cache(void) {
+  int8_t i, j;
+
+  for (i = 0; i < NUM_SPRITE_TYPES; ++i) {
+    for (j = 0; j < MAX_VISIBILITY_DEPTH - 1; ++j) {
+      unload_sprite_frames(i, j);
+    }
+  }
+}
+
+/*******************************************************************************
+   Function: unload_sprite_frames
+
+Description: Frees the animation frames of a given sprite type at a given
+             visual depth, along with the strip they were carved from.
+
+     Inputs: sprite_index - Index of the sprite type.
+             depth        - Front-back visual depth in "g_back_wall_coords".
+
+    Outputs: None.
+*******************************************************************************/
+void unload_sprite_frames(const int8_t sprite_index, const int8_t depth) {
+  int8_t frame;
+  sprite_strip_t *strip = g_sprite_cache[sprite_index][depth];
+
+  if (strip == NULL) {
+    return;
+  }
+  for (frame = 0; frame < MAX_SPRITE_FRAMES; ++frame) {
+    destroy_sprite(&strip->frames[frame]);
+  }
+  update_cache_size(SPRITE_CACHE,
+                    -(int32_t) (sizeof(sprite_strip_t) +
+                                get_bitmap_size(strip->bitmap)));
+  gbitmap_destroy(strip->bitmap);
+  free(strip);
+  g_sprite_cache[sprite_index][depth] = NULL;
+}
+
+/*******************************************************************************
+   Function: destroy_sprite
+
+Description: Frees a single cached sprite frame's sub-bitmaps, if present.
+
+     Inputs: sprite - Pointer to the cached sprite frame.
+
+    Outputs: None.
+*******************************************************************************/
+void destroy_sprite(sprite_t *sprite) {
+  if (sprite->image != NULL) {
+    gbitmap_destroy(sprite->image);
+    sprite->image = NULL;
+  }
+#ifdef PBL_BW
+  if (sprite->mask != NULL) {
+    gbitmap_destroy(sprite->mask);
+    sprite->mask = NULL;
+  }
+#endif
+}
+
 /*******************************************************************************
    Function: init_upgrade_menu
 
@@ -3202,6 +6907,91 @@ void deinit_main_menu(void) {
   window_destroy(g_main_menu_window);
 }
 
+#ifdef INSTRUCTION_COUNTS
+/*******************************************************************************
+   Function: benchmark_timer_callback
+
+Description: Drives the benchmark scene run by "tools/instruction_counts.py":
+             waits for the debugger to arm it, starts it, then replays one
+             scripted button press per call until the scene is over, the
+             player's HP and energy kept topped up throughout.
+
+     Inputs: data - Pointer to additional data (not used).
+
+    Outputs: None.
+*******************************************************************************/
+static void benchmark_timer_callback(void *data) {
+  if (!g_benchmark_armed) {
+    app_timer_register(BENCHMARK_POLL_INTERVAL,
+                       benchmark_timer_callback,
+                       NULL);
+
+    return;
+  }
+  if (g_benchmark_step == 0) {
+    start_benchmark_scene();
+  } else if (g_benchmark_step <= BENCHMARK_SCENE_LENGTH) {
+    if (g_mission == NULL) {  // The player walked out.
+      g_benchmark_step = BENCHMARK_SCENE_LENGTH;
+    } else {
+      g_player->stats[CURRENT_HP] = g_player->stats[MAX_HP];
+      g_player->stats[CURRENT_ENERGY] = g_player->stats[MAX_ENERGY];
+      BENCHMARK_INPUTS[(g_benchmark_step - 1) %
+                       (sizeof(BENCHMARK_INPUTS) /
+                        sizeof(BENCHMARK_INPUTS[0]))](NULL, NULL);
+    }
+  } else {
+    benchmark_scene_finished();  // Disarms it, so it can be run again.
+    app_timer_register(BENCHMARK_POLL_INTERVAL,
+                       benchmark_timer_callback,
+                       NULL);
+
+    return;
+  }
+  g_benchmark_step++;
+  app_timer_register(BENCHMARK_INPUT_INTERVAL, benchmark_timer_callback, NULL);
+}
+
+/*******************************************************************************
+   Function: start_benchmark_scene
+
+Description: Starts the benchmark scene: a new mission, the same on every run,
+             shown in the graphics window.
+
+     Inputs: None.
+
+    Outputs: None.
+*******************************************************************************/
+void start_benchmark_scene(void) {
+  show_window(g_main_menu_window);
+  deinit_mission();
+  init_player();
+  g_mission = malloc_with_eviction(sizeof(mission_t));
+  if (g_mission == NULL) {
+    return;
+  }
+  srand(BENCHMARK_SEED);
+  init_mission(BENCHMARK_MISSION_TYPE);
+  narration_single_click(NULL, NULL);  // Dismisses the mission briefing.
+}
+
+/*******************************************************************************
+   Function: benchmark_scene_finished
+
+Description: Ends the benchmark scene, pausing the game. The debugger stops
+             here to collect its counts, so this must not be inlined.
+
+     Inputs: None.
+
+    Outputs: None.
+*******************************************************************************/
+__attribute__((noinline)) void benchmark_scene_finished(void) {
+  g_game_paused = true;
+  g_benchmark_armed = false;
+  g_benchmark_step = 0;
+}
+#endif
+
 /*******************************************************************************
    Function: init
 
@@ -3227,23 +7017,69 @@ void init(void) {
                                        GRAPHICS_FRAME_HEIGHT +
                                          STATUS_BAR_HEIGHT +
                                          STATUS_BAR_HEIGHT / 2));
+  g_exit_guidance_path = gpath_create(&EXIT_GUIDANCE_PATH_INFO);
+  gpath_move_to(g_exit_guidance_path, GPoint(SCREEN_CENTER_POINT_X,
+                                             GRAPHICS_FRAME_HEIGHT +
+                                               STATUS_BAR_HEIGHT +
+                                               STATUS_BAR_HEIGHT / 2));
   g_status_bar = status_bar_layer_create();
   show_window(g_main_menu_window);
 
   // Check for saved data and initialize the player struct, etc.:
-  g_player = malloc(sizeof(player_t));
+  g_player = malloc_with_eviction(sizeof(player_t));
+  if (g_player == NULL) {
+    window_stack_pop_all(NOT_ANIMATED);  // Nothing can run without it.
+
+    return;
+  }
+  g_mission = malloc_with_eviction(sizeof(mission_t));
+  if (g_mission != NULL) {
+    g_mission->location = rand() % NUM_LOCATION_TYPES;  // For older saves.
+  }
+
+  // Move any saves from older versions into the record format:
   if (persist_exists(PLAYER_STORAGE_KEY)) {
     persist_read_data(PLAYER_STORAGE_KEY, g_player, sizeof(player_t));
-    if (persist_exists(MISSION_STORAGE_KEY)) {
-      g_mission = malloc(sizeof(mission_t));
-      persist_read_data(MISSION_STORAGE_KEY, g_mission, sizeof(mission_t));
+    save_record(PLAYER_RECORD, g_player, sizeof(player_t));
+    persist_delete(PLAYER_STORAGE_KEY);
+  }
+  if (persist_exists(MISSION_STORAGE_KEY) && g_mission != NULL) {
+    persist_read_data(MISSION_STORAGE_KEY, g_mission, sizeof(mission_t));
+    save_record(MISSION_RECORD, g_mission, sizeof(mission_t));
+    persist_delete(MISSION_STORAGE_KEY);
+  }
+
+  if (load_record(PLAYER_RECORD, g_player, sizeof(player_t))) {
+    if (g_mission != NULL &&
+        (load_record(MISSION_RECORD, g_mission, sizeof(mission_t)) ||
+         load_record(MISSION_RECORD,  // Saved before locations were kept.
+                     g_mission,
+                     offsetof(mission_t, location)))) {
       set_player_direction(g_player->direction);  // To update compass.
+      compute_distance_field(g_exit_distances, &g_mission->entrance, 1);
+      if (!load_record(MISSION_HISTORY_RECORD,
+                       &g_mission_history,
+                       sizeof(mission_history_t))) {
+        g_mission_history.num_checkpoints = 0;
+      }
+      load_mission_script(g_mission->type);
+      if (!load_record(MISSION_SCRIPT_RECORD,
+                       &g_script_state,
+                       sizeof(script_state_t))) {
+        init_script_state();  // Saved before scripts existed.
+      }
+    } else {
+      deinit_mission();
     }
   } else {
+    deinit_mission();
     init_player();
     g_current_narration = INTRO_NARRATION_1;
     show_narration();
   }
+#ifdef INSTRUCTION_COUNTS
+  app_timer_register(BENCHMARK_POLL_INTERVAL, benchmark_timer_callback, NULL);
+#endif
 }
 
 /*******************************************************************************
@@ -3256,11 +7092,21 @@ Description: Deinitializes the SpaceMerc app.
     Outputs: None.
 *******************************************************************************/
 void deinit(void) {
-  persist_write_data(PLAYER_STORAGE_KEY, g_player, sizeof(player_t));
+  if (g_player != NULL) {
+    save_record(PLAYER_RECORD, g_player, sizeof(player_t));
+  }
   if (g_mission != NULL) {
-    persist_write_data(MISSION_STORAGE_KEY, g_mission, sizeof(mission_t));
+    save_record(MISSION_RECORD, g_mission, sizeof(mission_t));
+    save_record(MISSION_HISTORY_RECORD,
+                &g_mission_history,
+                sizeof(mission_history_t));
+    save_record(MISSION_SCRIPT_RECORD,
+                &g_script_state,
+                sizeof(script_state_t));
   }
   app_focus_service_unsubscribe();
+  gpath_destroy(g_compass_path);
+  gpath_destroy(g_exit_guidance_path);
   status_bar_layer_destroy(g_status_bar);
   deinit_upgrade_menu();
   deinit_narration();
@@ -96,6 +96,110 @@ enum {
   NUM_DIRECTIONS
 };
 
+// Caches registered with the cache manager:
+enum {
+  SPRITE_CACHE,
+  VIEW_CACHE,
+  STATIC_VIEW_CACHE,
+  WALL_CACHE,
+  NUM_CACHES
+};
+
+// Passes "draw_view_slots" may make over the cells in view:
+enum {
+  FULL_SCENE_PASS,  // Walls and cell contents, in drawing order.
+  STATIC_SCENE_PASS,  // Walls only, listing cell contents as sprites.
+  SPRITE_LIST_PASS,  // Cell contents only, listed as sprites.
+};
+
+// Persistent storage records:
+enum {
+  PLAYER_RECORD,
+  MISSION_RECORD,
+  MISSION_HISTORY_RECORD,
+  MISSION_SCRIPT_RECORD,
+  NUM_STORAGE_RECORDS
+};
+
+// Mission script events (each script begins with a table of entry points):
+enum {
+  SCRIPT_START,   // Mission generated. Event cell: the far end of the map.
+  SCRIPT_TICK,    // Main thread, resumed every second (may "WAIT").
+  SCRIPT_KILL,    // NPC killed. Event arg: NPC type; cell: its position.
+  SCRIPT_PICKUP,  // HUMAN/ITEM reached. Event arg: its type; cell: position.
+  NUM_SCRIPT_EVENTS
+};
+
+// Mission script opcodes (operands follow inline, little-endian):
+enum {
+  OP_END,             // Ends the event handler or main thread.
+  OP_PUSH,            // int16 operand: pushes it.
+  OP_LOAD,            // uint8 operand: pushes a script variable.
+  OP_STORE,           // uint8 operand: pops into a script variable.
+  OP_GET,             // uint8 operand: pushes a script value (see below).
+  OP_ADD,
+  OP_SUB,
+  OP_MUL,
+  OP_LESS,
+  OP_EQUAL,
+  OP_NOT,
+  OP_AND,
+  OP_RANDOM,          // Pops n, pushes "rand() % n".
+  OP_JUMP,            // uint16 operand: absolute target.
+  OP_JUMP_IF_NOT,     // uint16 operand: jumps if the popped value is zero.
+  OP_WAIT,            // Pops n, suspends the main thread for n ticks.
+  OP_SPAWN,           // Pops an NPC type, spawns it out of the player's view.
+  OP_SPAWN_AT_EVENT,  // Pops an NPC type, spawns it at the event cell.
+  OP_PLACE_AT_EVENT,  // Pops a cell type, places it at the event cell.
+  OP_SET_REWARD,      // Pops the mission's reward.
+  OP_COMPLETE,        // Marks the mission completed.
+  NUM_SCRIPT_OPCODES
+};
+
+// Columns of "g_script_opcode_formats":
+enum {
+  OPERAND_SIZE,  // Bytes following the opcode.
+  NUM_INPUTS,    // Values popped off the stack.
+  NUM_OPCODE_FORMAT_FIELDS
+};
+
+// Values readable by mission scripts via "OP_GET":
+enum {
+  VALUE_KILLS,
+  VALUE_TOTAL_NPCS,
+  VALUE_NPCS_PRESENT,
+  VALUE_EVENT_ARG,
+  VALUE_COMPLETED,
+  NUM_SCRIPT_VALUES
+};
+
+// Faces of a cell's walls, as seen by the player:
+enum {
+  BACK_WALL,
+  LEFT_WALL,
+  RIGHT_WALL,
+  NUM_WALL_FACES
+};
+
+// Wall textures (locations without one keep the plain shaded walls):
+enum {
+  NO_WALL_TEXTURE = -1,
+  PANEL_TEXTURE,
+  ROCK_TEXTURE,
+  HULL_TEXTURE,
+  NUM_WALL_TEXTURES
+};
+
+// Player inputs, queued by the graphics window's click handlers:
+enum {
+  INPUT_FORWARD,
+  INPUT_BACKWARD,
+  INPUT_TURN_LEFT,
+  INPUT_TURN_RIGHT,
+  INPUT_FIRE,
+  NUM_INPUT_TYPES
+};
+
 /*******************************************************************************
   Other Constants
 *******************************************************************************/
@@ -129,6 +233,10 @@ enum {
 #define MOVEMENT_REPEAT_INTERVAL         250  // milliseconds
 #define ATTACK_REPEAT_INTERVAL           250  // milliseconds
 #define PLAYER_TIMER_DURATION            20  // milliseconds
+#define HALF_RES_TRANSITION_DURATION     400  // milliseconds
+#define MAX_FULL_RES_FRAME_DURATION      50  // milliseconds
+#define FULL_RES_RETRY_INTERVAL          2000  // milliseconds
+#define MAX_QUEUED_INPUTS                4  // Further inputs are dropped until a frame is drawn.
 #define MAX_SMALL_INT_VALUE              9999
 #define MAX_SMALL_INT_DIGITS             4
 #define MAX_LARGE_INT_VALUE              999999999
@@ -167,19 +275,80 @@ enum {
 #define ENERGY_RECOVERY_RATE             1  // Energy (ammo) per second.
 #define MIN_DAMAGE                       (HP_RECOVERY_RATE + 1)
 #define ENERGY_LOSS_PER_SHOT             (ENERGY_RECOVERY_RATE + 1)
-#define PLAYER_STORAGE_KEY               417
-#define MISSION_STORAGE_KEY              (PLAYER_STORAGE_KEY + 1)
+#define PLAYER_STORAGE_KEY               417  // Legacy (pre-record) player save.
+#define MISSION_STORAGE_KEY              (PLAYER_STORAGE_KEY + 1)  // Legacy mission save.
+#define MAX_SHARDS_PER_RECORD            4
+#define RECORD_SHARD_SIZE                PERSIST_DATA_MAX_LENGTH
+#define MAX_RECORD_SIZE                  (MAX_SHARDS_PER_RECORD * RECORD_SHARD_SIZE)
+#define NUM_RECORD_SLOTS                 2  // Each save goes to the slot not currently committed.
+#define MAX_STORAGE_RECORDS              8  // Marker keys reserved, so shard keys never move.
+#define RECORD_MARKER_KEY(record)        (MISSION_STORAGE_KEY + 1 + (record))
+#define RECORD_SHARD_KEY(record, slot, shard) (RECORD_MARKER_KEY(MAX_STORAGE_RECORDS) + ((record) * NUM_RECORD_SLOTS + (slot)) * MAX_SHARDS_PER_RECORD + (shard))
+#define MIN_CODEC_MATCH                  3  // Bytes.
+#define MAX_CODEC_LITERALS               128  // Bytes per literal token.
+#define CODEC_MATCH_FLAG                 0x80
+#define CODEC_DISTANCE_SHIFT             5
+#define CODEC_LENGTH_MASK                0x1F  // All set: a length byte follows.
+#define MAX_CODEC_MATCH                  (MIN_CODEC_MATCH + CODEC_LENGTH_MASK + 0xFF)
+#define NUM_CODEC_DISTANCES              4
 #define MAX_NPCS_AT_ONE_TIME             2
+#define MAX_CHECKPOINTS                  4  // Including the mission's starting point.
+#define MAX_CELL_DELTAS                  128
+#define NUM_CELLS                        (LOCATION_WIDTH * LOCATION_HEIGHT)
+#define MAX_SCRIPT_SIZE                  256  // Bytes, including the entry point table.
+#define SCRIPT_HEADER_SIZE               (NUM_SCRIPT_EVENTS * 2)
+#define SCRIPT_STACK_SIZE                8
+#define NUM_SCRIPT_VARS                  4
+#define SCRIPT_INSTRUCTION_BUDGET        64  // Per thread, per call.
+#define NO_SCRIPT_ENTRY                  0xFFFF
+#define NPC_ATTACK_RANGE                 (MAX_VISIBILITY_DEPTH - 2)  // Cells, for ranged attacks.
+#define UNREACHABLE                      0xFF  // Distance field value for cut-off cells.
+#define MAX_FIRING_POSITIONS             (NUM_DIRECTIONS * NPC_ATTACK_RANGE)
+#define FLANK_PENALTY                    2  // Extra steps an NPC will take to avoid a taken side.
 #define ANIMATED                         true
 #define NOT_ANIMATED                     false
-#define RANDOM_NPC_TYPE                  (rand() % (NUM_NPC_TYPES - 1))  // Excludes ALIEN_OFFICER.
+#define NUM_SPRITE_TYPES                 (NUM_NPC_TYPES + 2)  // NPCs, HUMAN and ITEM.
+#define MAX_SPRITE_FRAMES                4
+#define SPRITE_FRAME_DURATION            250  // milliseconds
+#define CACHE_HEAP_RESERVE               4096  // Heap bytes caches must leave free.
+#define WALL_CACHE_PRIORITY              3  // Lower priorities are evicted first.
+#define STATIC_VIEW_CACHE_PRIORITY       2
+#define SPRITE_CACHE_PRIORITY            1
+#define VIEW_CACHE_PRIORITY              0
+#define NUM_SPECULATIVE_INPUTS           3  // Forward step, left turn and right turn.
+#define MAX_VIEWS                        (NUM_SPECULATIVE_INPUTS + 1)  // Plus the view on screen.
+#define NO_SIGNATURE                     0
+#define MAX_SCENE_SPRITES                ((MAX_VISIBILITY_DEPTH - 1) * (MAX_VISIBILITY_DEPTH + 1))  // One per view slot.
+#define BOTTOM_STATUS_BAR_TOP            (GRAPHICS_FRAME_HEIGHT + STATUS_BAR_HEIGHT + 1)  // First row below the graphics frame.
+#define SPECULATION_DELAY                100  // Idle milliseconds before each speculative view.
+#define MIN_SPECULATION_CHARGE           20  // Battery percentage below which nothing is speculated.
+#define LOW_SPECULATION_CHARGE           50  // Battery percentage below which only steps are speculated.
+#define WALL_TEXTURE_SIZE                16  // Texels per side.
+#define TEXTURE_COORD_SHIFT              8  // Fixed-point fraction bits.
+#define MAX_WALL_TOP                     (GRAPHICS_FRAME_HEIGHT / 2)
+#define MAX_WALL_COLUMNS                 560  // Precomputed wall columns (554 used).
+#define NO_DOOR                          0xFF
+#ifdef INSTRUCTION_COUNTS
+#define BENCHMARK_SEED                   1
+#define BENCHMARK_MISSION_TYPE           RETALIATE
+#define BENCHMARK_POLL_INTERVAL          250  // milliseconds
+#define BENCHMARK_INPUT_INTERVAL         400  // milliseconds
+#define BENCHMARK_SCENE_LENGTH           48  // Scripted inputs per scene.
+#endif
+#define VIEW_SIZE_ESTIMATE               4096  // Bytes, until a view's been kept.
+#ifdef PBL_COLOR  // Aplite's 24 KB of app memory can't spare the code or heap.
+#define SPECULATIVE_VIEWS  // Views rendered ahead of time (see "speculate").
+#define COMPOSITED_SCENES  // Sprites drawn over a kept static view.
+#endif
 #ifdef PBL_COLOR
 #define NUM_BACKGROUND_COLOR_SCHEMES     8
 #define NUM_BACKGROUND_COLORS_PER_SCHEME 10
 #define RANDOM_COLOR                     GColorFromRGB(rand() % 256, rand() % 256, rand() % 256)
 #define RANDOM_DARK_COLOR                GColorFromRGB(rand() % 128, rand() % 128, rand() % 128)
 #define RANDOM_BRIGHT_COLOR              GColorFromRGB(rand() % 128 + 128, rand() % 128 + 128, rand() % 128 + 128)
-#define NPC_LASER_COLOR                  (rand() % 2 ? GColorSunsetOrange : GColorDarkCandyAppleRed)
+#define RANDOM_SPRITE_COLOR              GColorFromRGB(sprite_rand() % 256, sprite_rand() % 256, sprite_rand() % 256)
+#define RANDOM_BRIGHT_SPRITE_COLOR       GColorFromRGB(sprite_rand() % 128 + 128, sprite_rand() % 128 + 128, sprite_rand() % 128 + 128)
+#define NPC_LASER_COLOR                  (laser_rand() % 2 ? GColorSunsetOrange : GColorDarkCandyAppleRed)
 #endif
 
 static const GPathInfo COMPASS_PATH_INFO = {
@@ -190,6 +359,21 @@ static const GPathInfo COMPASS_PATH_INFO = {
                          {-3, -3}}
 };
 
+// Marks the rim of the compass in the direction of the way out:
+static const GPathInfo EXIT_GUIDANCE_PATH_INFO = {
+  .num_points = 3,
+  .points = (GPoint []) {{-2, 3},
+                         {2, 3},
+                         {0, 5}}
+};
+
+// Inputs whose results are rendered ahead of time, most likely first:
+static const int8_t SPECULATIVE_INPUTS[NUM_SPECULATIVE_INPUTS] = {
+  INPUT_FORWARD,
+  INPUT_TURN_LEFT,
+  INPUT_TURN_RIGHT
+};
+
 static const char *const g_narration_strings[] = {
   "You fell in battle, but your body was found and resuscitated. Soldier on!",
   "SpaceMerc v1.9, designed and programmed by David C. Drake:\n\ndavidcdrake.com",
@@ -201,6 +385,45 @@ static const char *const g_narration_strings[] = {
   "    INSTRUCTIONS\nTo end a mission, walk out through the door where the mission began.",
 };
 
+// Operand size and no. of stack inputs per mission script opcode:
+static const int8_t g_script_opcode_formats[NUM_SCRIPT_OPCODES]
+                                           [NUM_OPCODE_FORMAT_FIELDS] = {
+  {0, 0},  // OP_END
+  {2, 0},  // OP_PUSH
+  {1, 0},  // OP_LOAD
+  {1, 1},  // OP_STORE
+  {1, 0},  // OP_GET
+  {0, 2},  // OP_ADD
+  {0, 2},  // OP_SUB
+  {0, 2},  // OP_MUL
+  {0, 2},  // OP_LESS
+  {0, 2},  // OP_EQUAL
+  {0, 1},  // OP_NOT
+  {0, 2},  // OP_AND
+  {0, 1},  // OP_RANDOM
+  {2, 0},  // OP_JUMP
+  {2, 1},  // OP_JUMP_IF_NOT
+  {0, 1},  // OP_WAIT
+  {0, 1},  // OP_SPAWN
+  {0, 1},  // OP_SPAWN_AT_EVENT
+  {0, 1},  // OP_PLACE_AT_EVENT
+  {0, 1},  // OP_SET_REWARD
+  {0, 0},  // OP_COMPLETE
+};
+
+// No. of animation frames per sprite type (NPC types, then HUMAN and ITEM):
+static const int8_t g_num_sprite_frames[NUM_SPRITE_TYPES] = {
+  4,  // FLOATING_MONSTROSITY (bob)
+  3,  // OOZE (wobble)
+  2,  // BEAST (stride)
+  2,  // ROBOT
+  2,  // ALIEN_SOLDIER
+  2,  // ALIEN_ELITE
+  2,  // ALIEN_OFFICER
+  1,  // HUMAN
+  2,  // ITEM
+};
+
 static const char *const g_location_strings[] = {
   "colony",
   "city",
@@ -212,6 +435,28 @@ static const char *const g_location_strings[] = {
   "space station",
 };
 
+static const int8_t g_location_wall_textures[] = {
+  NO_WALL_TEXTURE,  // Colony
+  NO_WALL_TEXTURE,  // City
+  PANEL_TEXTURE,    // Laboratory
+  PANEL_TEXTURE,    // Base
+  ROCK_TEXTURE,     // Mine
+  HULL_TEXTURE,     // Starship
+  PANEL_TEXTURE,    // Spaceport
+  HULL_TEXTURE,     // Space station
+};
+
+// One bit per texel, leftmost in the least significant bit (set bits take the
+// wall's color, the rest are black):
+static const uint16_t g_wall_textures[NUM_WALL_TEXTURES][WALL_TEXTURE_SIZE] = {
+  {0xFFFF, 0x0101, 0x3D3D, 0x2525, 0x2525, 0x3D3D, 0x0101, 0x0101,  // Panels
+   0xFFFF, 0x0101, 0x3D3D, 0x2525, 0x2525, 0x3D3D, 0x0101, 0x0101},
+  {0x2000, 0x1014, 0x5100, 0x0803, 0x0C0C, 0x1330, 0xE0C0, 0x0240,  // Rock
+   0x0022, 0x6520, 0x0010, 0x1811, 0x6608, 0x8188, 0x0064, 0x1004},
+  {0xFFFF, 0x0001, 0x2829, 0x0001, 0xFFFF, 0x0100, 0x2928, 0x0100,  // Hull
+   0xFFFF, 0x0001, 0x2829, 0x0001, 0xFFFF, 0x0100, 0x2928, 0x0100},
+};
+
 /*******************************************************************************
   Structures
 *******************************************************************************/
@@ -245,8 +490,201 @@ typedef struct Mission {
   GPoint entrance;
   npc_t npcs[MAX_NPCS_AT_ONE_TIME];
   bool completed;
+  int8_t location;  // Last, so older saves still load (see "init").
 } __attribute__((__packed__)) mission_t;
 
+// A cache that can be freed under memory pressure and rebuilt on demand:
+typedef struct Cache {
+  void (*evict)(void);  // Frees everything in the cache.
+  uint32_t size;  // Approx. heap bytes currently held.
+  int8_t priority;
+} cache_t;
+
+// A cell's type as it was before its first change since the latest checkpoint:
+typedef struct CellDelta {
+  uint8_t index;  // x * LOCATION_HEIGHT + y
+  int8_t type;
+} __attribute__((__packed__)) cell_delta_t;
+
+// Execution state of a mission script thread, kept between ticks:
+typedef struct ScriptThread {
+  uint16_t pc,    // NO_SCRIPT_ENTRY once the thread has ended.
+           wait;  // Ticks left before the thread resumes.
+  int16_t stack[SCRIPT_STACK_SIZE];
+  int8_t sp;
+} __attribute__((__packed__)) script_thread_t;
+
+typedef struct ScriptState {
+  script_thread_t main_thread;
+  int16_t vars[NUM_SCRIPT_VARS];  // Shared with event handlers.
+} __attribute__((__packed__)) script_state_t;
+
+// Perception shared by all NPCs, gathered once per tick:
+typedef struct Blackboard {
+  GPoint player_position;
+  uint8_t distances[LOCATION_WIDTH][LOCATION_HEIGHT],  // Steps to the player.
+          firing_distances[LOCATION_WIDTH][LOCATION_HEIGHT];  // To a line of fire.
+  int8_t los_ranges[NUM_DIRECTIONS];  // Cells visible from the player.
+  uint8_t claimed_sides;  // Bit per direction: sides of the player engaged.
+} blackboard_t;
+
+typedef struct Checkpoint {
+  GPoint player_position;
+  int16_t player_direction,
+          player_hp,
+          player_energy;
+  int8_t kills;
+  bool completed;
+  uint8_t num_cell_deltas;  // Length of the cell delta log when saved.
+  npc_t npcs[MAX_NPCS_AT_ONE_TIME];
+  script_state_t script_state;
+} __attribute__((__packed__)) checkpoint_t;
+
+// Checkpoints share one undo log of cell deltas, so rewinding to any of them
+// needs no copy of the map:
+typedef struct MissionHistory {
+  checkpoint_t checkpoints[MAX_CHECKPOINTS];  // [0] is the mission's start.
+  cell_delta_t cell_deltas[MAX_CELL_DELTAS];
+  uint8_t modified_cells[(NUM_CELLS + 7) / 8],  // Since latest checkpoint.
+          num_checkpoints,
+          num_cell_deltas;
+} __attribute__((__packed__)) mission_history_t;
+
+// Written after all of a record's shards, so it only ever describes a
+// complete save:
+typedef struct RecordMarker {
+  uint32_t generation,  // Incremented with every committed save.
+           checksum;
+  uint16_t size;
+  int8_t slot;
+  uint16_t stored_size;  // Less than "size" if compressed. (Last, since older
+                         // markers lack it: see "read_record_marker".)
+} __attribute__((__packed__)) record_marker_t;
+
+// Compressed data (see "compress_data") passing through a fixed buffer, which
+// "transfer" empties or refills as needed (e.g., a record shard at a time):
+typedef struct CodecStream {
+  uint8_t *buffer;  // NULL to count bytes written without keeping them.
+  uint16_t buffer_size,
+           position,  // Next byte within "buffer".
+           end,  // No. of bytes in "buffer" when reading.
+           total;  // No. of bytes written so far.
+  bool (*transfer)(struct CodecStream *stream);  // NULL if none.
+  int8_t record,  // For record shards only.
+         slot,
+         shard;
+} codec_stream_t;
+
+// A screen column of a wall face, pre-rendered (see "init_wall_columns") as
+// spans that take no divisions or shading math to draw. The column runs from
+// "top" down to GRAPHICS_FRAME_HEIGHT - "top", below the status bar:
+typedef struct WallColumn {
+  uint8_t top,
+          u;  // Texture column.
+  int8_t shading_phase;  // Shifts the column's shading pattern.
+  uint8_t door_top,  // NO_DOOR, or the first row the exit door covers.
+          door_bottom;  // The last row it covers.
+} wall_column_t;
+
+// The columns of a wall face at a given depth and position:
+typedef struct WallSpan {
+  int16_t left;  // Screen column of the first entry (may be off screen).
+  uint16_t first_column;  // Index in "columns" (see "wall_tables_t").
+  uint8_t num_columns;
+} wall_span_t;
+
+// Every wall face the player could see, pre-rendered as columns, plus the
+// texture step and shading of each column height (see "init_wall_columns"):
+typedef struct WallTables {
+  wall_span_t spans[MAX_VISIBILITY_DEPTH - 1]
+                   [(STRAIGHT_AHEAD * 2) + 1]
+                   [NUM_WALL_FACES];
+  wall_column_t columns[MAX_WALL_COLUMNS];
+  uint16_t texture_steps[MAX_WALL_TOP];  // Texture rows per screen row.
+  uint8_t shading_offsets[MAX_WALL_TOP];  // Rows per shading period.
+#ifdef PBL_COLOR
+  uint8_t shades[MAX_WALL_TOP];  // Wall color scheme index.
+#endif
+} wall_tables_t;
+
+// Everything "draw_scene" depends on, apart from animation:
+typedef struct SceneKey {
+  GPoint position;
+  int16_t direction,
+          stats[NUM_PLAYER_STATS];
+  uint32_t mission_checksum;
+} __attribute__((__packed__)) scene_key_t;
+
+// A full-resolution frame (below the status bar), compressed by
+// "compress_data" and identified by the signature of the scene it shows:
+typedef struct View {
+  uint8_t *data;  // NULL if unused.
+  uint16_t size;
+  uint32_t signature;
+} view_t;
+
+// Everything the scene depends on apart from its sprites (see
+// "composite_scene"):
+typedef struct StaticSceneKey {
+  GPoint position,
+         entrance;
+  int8_t direction,
+         entrance_direction,
+#ifdef PBL_COLOR
+         floor_color_scheme,
+         wall_color_scheme,
+#endif
+         location;
+  uint32_t cells_checksum;
+} __attribute__((__packed__)) static_scene_key_t;
+
+// An NPC, HUMAN or ITEM as drawn at a given view slot:
+typedef struct SceneSprite {
+  int8_t content_type,
+         depth,
+         position,
+         frame;
+  uint8_t order;  // Of its view slot, in drawing order (see "draw_view_slot").
+  GPoint floor_center_point;  // In screen coordinates.
+  GRect bounds;  // See "get_sprite_bounds".
+} scene_sprite_t;
+
+// A view slot's walls and contents drawn by a routine specialized to the slot
+// at build time (see "tools/view_slot_routines.c"):
+typedef void (*view_slot_routine_t)(GContext *ctx, const GPoint cell);
+
+// The scene from the player's current pose without its sprites, kept
+// uncompressed (below the status bar) so that columns of it can be restored
+// wherever sprites move, along with the sprites that belong over it:
+typedef struct StaticView {
+  uint16_t size;  // Of "data", in bytes.
+  uint32_t signature;  // See "get_static_signature".
+  uint8_t wall_orders[GRAPHICS_FRAME_WIDTH];  // Order of each column's
+                                              // nearest wall, or zero.
+  scene_sprite_t sprites[MAX_SCENE_SPRITES],  // As on screen, in order.
+                 scene_sprites[MAX_SCENE_SPRITES];  // Listed by latest pass.
+  int8_t num_sprites;
+  bool on_screen;  // "False" once anything else is drawn over it.
+  uint8_t data[];
+} static_view_t;
+
+// An animation frame of an NPC, HUMAN or ITEM at a given depth, pre-rasterized
+// at build time (see "tools/sprite_atlas.c"). Both bitmaps are sub-bitmaps of
+// the strip resource holding the type's frames at that depth:
+typedef struct Sprite {
+  GBitmap *image;
+#ifdef PBL_BW
+  GBitmap *mask;  // Set bits mark the sprite's opaque pixels.
+#endif
+  GPoint offset;  // Top-left corner relative to the floor center point.
+} sprite_t;
+
+// A loaded strip resource and the animation frames carved from it:
+typedef struct SpriteStrip {
+  GBitmap *bitmap;
+  sprite_t frames[MAX_SPRITE_FRAMES];
+} sprite_strip_t;
+
 /*******************************************************************************
   Global Variables
 *******************************************************************************/
@@ -259,39 +697,96 @@ MenuLayer *g_main_menu,
           *g_upgrade_menu;
 TextLayer *g_narration_text_layer;
 StatusBarLayer *g_status_bar;
-AppTimer *g_player_timer;
+AppTimer *g_player_timer,
+         *g_animation_timer,
+         *g_half_res_timer,
+         *g_input_timer,
+         *g_speculation_timer;
 GPoint g_back_wall_coords[MAX_VISIBILITY_DEPTH - 1]
                          [(STRAIGHT_AHEAD * 2) + 1]
                          [2];
-bool g_game_paused;
-int8_t g_current_narration,
+bool g_game_paused,
+     g_animated_sprites_visible,
+     g_half_res_mode,  // Render the scene at 72 columns, doubling each one.
+     g_input_batch_pending,  // Inputs processed, but not yet drawn.
+     g_speculation_pending;  // The next frame is a speculative view.
+int8_t g_input_queue[MAX_QUEUED_INPUTS],
+       g_num_queued_inputs,
+       g_current_narration,
        g_player_animation_mode,
        g_laser_base_width;
-GPath *g_compass_path;
+GPath *g_compass_path,
+      *g_exit_guidance_path;
 mission_t *g_mission;
 player_t *g_player;
+mission_history_t g_mission_history;
+blackboard_t g_blackboard;
+uint8_t g_exit_distances[LOCATION_WIDTH][LOCATION_HEIGHT];  // Steps to the entrance.
+script_state_t g_script_state;
+uint8_t g_mission_script[MAX_SCRIPT_SIZE];
+uint16_t g_mission_script_size;
+cache_t g_caches[NUM_CACHES];
+uint8_t g_record_buffer[RECORD_SHARD_SIZE];  // Codec buffer for records.
+#ifdef SPECULATIVE_VIEWS
+view_t g_views[MAX_VIEWS];
+uint32_t g_displayed_signature;  // NO_SIGNATURE unless the frame may be kept.
+uint8_t g_speculation_skips;  // Bit per speculative input: view not storable.
+#endif
+static_view_t *g_static_view;  // NULL unless cached.
+int8_t g_num_scene_sprites,  // In "g_static_view->scene_sprites".
+       g_scene_pass;
+uint8_t g_view_slot_order;  // Of the view slot being drawn.
+sprite_strip_t *g_sprite_cache[NUM_SPRITE_TYPES]
+                              [MAX_VISIBILITY_DEPTH - 1];  // NULL if unloaded.
+wall_tables_t *g_wall_tables;  // NULL unless cached (see "get_wall_tables").
+uint32_t g_sprite_seed,
+         g_laser_seed,
+         g_half_res_deadline,  // Time (ms) at which a transition ends.
+         g_full_res_frame_duration,  // Milliseconds.
+         g_full_res_retry_time;  // Time (ms) to retry full resolution.
 #ifdef PBL_COLOR
 GColor g_background_colors[NUM_BACKGROUND_COLOR_SCHEMES]
                           [NUM_BACKGROUND_COLORS_PER_SCHEME];
 #endif
+#ifdef INSTRUCTION_COUNTS
+volatile bool g_benchmark_armed;  // Set from the debugger to start a scene.
+int16_t g_benchmark_step;
+#endif
 
 /*******************************************************************************
   Function Declarations
 *******************************************************************************/
 
 void set_player_direction(const int8_t new_direction);
+int32_t get_compass_angle(const int8_t direction);
 void move_player(const int8_t direction);
 void move_npc(npc_t *npc, const int8_t direction);
 void determine_npc_behavior(npc_t *npc);
+void update_blackboard(void);
+void compute_distance_field(uint8_t distances[][LOCATION_HEIGHT],
+                            const GPoint *origins,
+                            const int8_t num_origins);
+bool in_line_of_fire(const GPoint cell);
+int8_t get_side_of_player(const GPoint cell);
+int8_t get_squad_move_direction(const npc_t *npc);
+void open_exit_path(const GPoint cell);
+int8_t get_exit_direction(const GPoint cell);
 void damage_player(int16_t damage);
 void damage_npc(npc_t *npc, const int16_t damage);
 void damage_cell(GPoint cell, const int16_t damage);
 bool adjust_player_money(const int32_t amount);
 void adjust_player_current_hp(const int16_t amount);
+void abandon_mission(void);
+bool player_defeated(void);
 void adjust_player_current_ammo(const int16_t amount);
 void add_new_npc(const int8_t npc_type, const GPoint position);
 GPoint get_npc_spawn_point(void);
+bool suitable_spawn_point(const GPoint cell, const bool off_route);
 GPoint get_floor_center_point(const int8_t depth, const int8_t position);
+GPoint get_cell_at_view_slot(const int8_t depth, const int8_t position);
+int8_t get_drawing_unit(const int8_t depth, const int8_t position);
+GRect get_sprite_bounds(const GPoint floor_center_point,
+                        const int8_t drawing_unit);
 GPoint get_cell_farther_away(const GPoint reference_point,
                              const int8_t direction,
                              const int8_t distance);
@@ -302,11 +797,50 @@ int8_t get_opposite_direction(const int8_t direction);
 int16_t get_upgraded_stat_value(const int8_t stat_index);
 int32_t get_upgrade_cost(const int16_t upgraded_stat_value);
 int8_t get_cell_type(const GPoint cell);
+int8_t get_cell_contents_type(const GPoint cell);
+int8_t get_sprite_index(const int8_t content_type);
+int8_t get_sprite_frame(const int8_t content_type);
+uint16_t sprite_rand(void);
+uint16_t laser_rand(void);
+uint32_t get_time_ms(void);
 void set_cell_type(GPoint cell, const int8_t type);
 npc_t *get_npc_at(const GPoint cell);
 bool out_of_bounds(const GPoint cell);
 bool occupiable(const GPoint cell);
 bool touching(const GPoint cell, const GPoint cell_2);
+uint32_t get_checksum(const void *data, const uint16_t size);
+bool compress_data(const uint8_t *data,
+                   const uint16_t size,
+                   const uint16_t stride,
+                   codec_stream_t *output);
+bool decompress_data(codec_stream_t *input,
+                     uint8_t *data,
+                     const uint16_t size,
+                     const uint16_t stride);
+bool write_codec_data(codec_stream_t *stream,
+                      const uint8_t *data,
+                      uint16_t size);
+bool read_codec_data(codec_stream_t *stream, uint8_t *data, uint16_t size);
+bool write_record_shard(codec_stream_t *stream);
+bool read_record_shard(codec_stream_t *stream);
+bool read_record_marker(const int8_t record, record_marker_t *marker);
+uint16_t get_record_stride(const int8_t record);
+bool load_record(const int8_t record, void *data, const uint16_t size);
+bool save_record(const int8_t record, const void *data, const uint16_t size);
+void delete_record(const int8_t record);
+void register_cache(const int8_t cache,
+                    void (*evict)(void),
+                    const int8_t priority);
+void update_cache_size(const int8_t cache, const int32_t change);
+bool evict_cache(const int8_t max_priority);
+bool reserve_cache_memory(const int8_t cache, const size_t size);
+void trim_caches(void);
+void *malloc_with_eviction(const size_t size);
+uint32_t get_bitmap_size(const GBitmap *bitmap);
+void save_checkpoint(void);
+void capture_checkpoint(checkpoint_t *checkpoint);
+void record_cell_change(const GPoint cell);
+bool rewind_mission(const int8_t checkpoint);
 void show_narration(void);
 void show_window(Window *window);
 static void main_menu_draw_row_callback(GContext *ctx,
@@ -336,14 +870,74 @@ static uint16_t menu_get_num_rows_callback(MenuLayer *menu_layer,
 void draw_scene(Layer *layer, GContext *ctx);
 void draw_player_laser_beam(GContext *ctx);
 void draw_floor_and_ceiling(GContext *ctx);
+void double_frame_columns(GContext *ctx);
+void start_half_res_transition(void);
+void render_scene(GContext *ctx, const GRect bounds);
+void draw_view_slots(GContext *ctx);
+void draw_view_slot(GContext *ctx,
+                    const GPoint cell,
+                    const int8_t depth,
+                    const int8_t position);
+void draw_bottom_status_bar(GContext *ctx);
+#ifdef COMPOSITED_SCENES
+bool composite_scene(GContext *ctx, const GRect bounds);
+bool render_static_view(GContext *ctx, const GRect bounds);
+uint32_t get_static_signature(void);
+bool mark_dirty_columns(bool *dirty_columns, const GRect bounds);
+bool overlaps_dirty_columns(const bool *dirty_columns, const GRect bounds);
+bool scene_sprites_match(const scene_sprite_t *sprite_1,
+                         const scene_sprite_t *sprite_2);
+void restore_static_columns(GBitmap *frame_buffer,
+                            const int16_t left,
+                            const int16_t right,
+                            int16_t top,
+                            int16_t bottom);
+void deinit_static_view(void);
+#endif
+void deinit_wall_tables(void);
+#ifdef SPECULATIVE_VIEWS
+uint32_t get_scene_signature(const GPoint position, const int8_t direction);
+uint32_t get_speculative_signature(const int8_t index);
+bool get_speculative_pose(const int8_t index,
+                          GPoint *position,
+                          int8_t *direction);
+int8_t get_speculation_budget(void);
+void schedule_speculation(void);
+void cancel_speculation(void);
+bool speculate(GContext *ctx, const GRect bounds);
+view_t *get_view(const uint32_t signature);
+view_t *store_view(GBitmap *frame_buffer, const uint32_t signature);
+void show_view(GBitmap *frame_buffer, const view_t *view);
+void prune_views(const int8_t budget);
+void free_view(view_t *view);
+void deinit_views(void);
+#endif
 void draw_cell_walls(GContext *ctx,
                      const GPoint cell,
                      const int8_t depth,
                      const int8_t position);
+void record_wall_columns(const int16_t left, const int16_t right);
 void draw_cell_contents(GContext *ctx,
                         const GPoint cell,
                         const int8_t depth,
-                        const int8_t position);
+                        const int8_t position,
+                        const GPoint floor_center_point,
+                        const int8_t drawing_unit);
+void draw_sprite_frame(GContext *ctx,
+                       const int8_t content_type,
+                       const int8_t depth,
+                       const int8_t position,
+                       const GPoint floor_center_point,
+                       const int8_t frame);
+void draw_sprite(GContext *ctx,
+                 const int8_t content_type,
+                 const int8_t depth,
+                 const int8_t position,
+                 const int8_t frame);
+void draw_cached_sprite(GContext *ctx,
+                        const sprite_t *sprite,
+                        const GPoint floor_center_point);
+bool load_sprite_frames(const int8_t content_type, const int8_t depth);
 void draw_floating_monstrosity(GContext *ctx,
                                GPoint center,
                                const int8_t radius,
@@ -354,6 +948,14 @@ void draw_shaded_quad(GContext *ctx,
                       const GPoint upper_right,
                       const GPoint lower_right,
                       const GPoint shading_ref);
+bool draw_wall_face(GContext *ctx,
+                    const int8_t depth,
+                    const int8_t position,
+                    const int8_t face);
+bool draw_wall_door(GContext *ctx,
+                    const int8_t depth,
+                    const int8_t position,
+                    const int8_t face);
 void fill_quad(GContext *ctx,
                const GPoint upper_left,
                const GPoint lower_left,
@@ -364,9 +966,18 @@ void draw_status_meter(GContext *ctx,
                        GPoint origin,
                        const float ratio);
 static void player_timer_callback(void *data);
+static void animation_timer_callback(void *data);
+static void half_res_timer_callback(void *data);
+static void input_timer_callback(void *data);
+#ifdef SPECULATIVE_VIEWS
+static void speculation_timer_callback(void *data);
+#endif
 static void main_menu_window_appear(Window *window);
 static void graphics_window_appear(Window *window);
 static void graphics_window_disappear(Window *window);
+void queue_input(const int8_t input);
+void process_inputs(void);
+void fire_player_laser(void);
 void graphics_up_single_repeating_click(ClickRecognizerRef recognizer,
                                         void *context);
 void graphics_up_multi_click(ClickRecognizerRef recognizer, void *context);
@@ -384,8 +995,34 @@ void init_player(void);
 void deinit_player(void);
 void init_npc(npc_t *npc, const int8_t type, const GPoint position);
 void init_wall_coords(void);
+wall_tables_t *get_wall_tables(void);
+void init_wall_columns(void);
+bool init_side_wall_span(wall_span_t *span,
+                         const int16_t left,
+                         const int16_t right,
+                         const int16_t left_top,
+                         const int16_t right_top,
+                         uint16_t *num_columns);
+void init_wall_door(const wall_span_t *span,
+                    const GPoint upper_left,
+                    const GPoint lower_left,
+                    const GPoint upper_right);
+void deinit_sprite_cache(void);
+void unload_sprite_frames(const int8_t sprite_index, const int8_t depth);
+void destroy_sprite(sprite_t *sprite);
 void init_mission(const int8_t type);
 void init_mission_location(void);
+void init_mission_history(void);
+bool load_mission_script(const int8_t type);
+void init_script_state(void);
+void run_mission_script_event(const int8_t event,
+                              const int16_t arg,
+                              const GPoint cell);
+bool run_script_thread(script_thread_t *thread,
+                       const int16_t arg,
+                       const GPoint cell);
+int16_t get_script_value(const int8_t value, const int16_t arg);
+uint16_t get_script_entry(const int8_t event);
 void deinit_mission(void);
 void init_narration(void);
 void deinit_narration(void);
@@ -395,8 +1032,27 @@ void init_upgrade_menu(void);
 void deinit_upgrade_menu(void);
 void init_main_menu(void);
 void deinit_main_menu(void);
+#ifdef INSTRUCTION_COUNTS
+static void benchmark_timer_callback(void *data);
+void start_benchmark_scene(void);
+void benchmark_scene_finished(void);
+#endif
 void init(void);
 void deinit(void);
 int main(void);
 
+#ifdef INSTRUCTION_COUNTS
+// Button presses replayed, in turn, by the benchmark scene:
+static const ClickHandler BENCHMARK_INPUTS[] = {
+  graphics_up_single_repeating_click,  // Forward.
+  graphics_up_single_repeating_click,
+  graphics_select_single_repeating_click,  // Fire.
+  graphics_down_multi_click,  // Turn right.
+  graphics_up_single_repeating_click,
+  graphics_select_single_repeating_click,
+  graphics_up_multi_click,  // Turn left.
+  graphics_down_single_repeating_click  // Backward.
+};
+#endif
+
 #endif  // SPACE_MERC_H_
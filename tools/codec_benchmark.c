@@ -0,0 +1,254 @@
+/*******************************************************************************
+   Filename: codec_benchmark.c
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Host benchmark for SpaceMerc's compression codec (see
+             "compress_data"). A seeded mission is played for a while on the
+             host SDK stand-in, and the codec is then run over its records (as
+             saved, with their shards counted) and over frames captured along
+             the way (as kept for views). For each, the compressed size and the
+             decode and encode throughputs are written to standard output.
+
+      Usage: codec_benchmark [<seed>]
+
+             Build with, e.g.:
+             cc -O2 -DPBL_COLOR -Itools/host -Isrc tools/codec_benchmark.c \
+               tools/host/host_shim.c -lz -lm
+*******************************************************************************/
+
+#include <time.h>
+
+#include "pebble.h"
+#include "host_shim.h"
+
+#define main space_merc_main
+#include "space_merc.c"
+#undef main
+
+#define DEFAULT_SEED                     1
+#define NUM_FRAMES                       32
+#define STEPS_PER_FRAME                  2
+#define MIN_BENCHMARK_NS                 200000000LL  // Per data set.
+#define MAX_MENU_PRESSES                 10
+#define NANOSECONDS_PER_SECOND           1000000000LL
+#define FRAME_SIZE                       (SCREEN_WIDTH * SCREEN_HEIGHT)
+
+static uint8_t s_frames[NUM_FRAMES][FRAME_SIZE],
+               s_compressed[NUM_FRAMES][FRAME_SIZE * 2],
+               s_decompressed[FRAME_SIZE];
+static uint16_t s_compressed_sizes[NUM_FRAMES];
+
+/*******************************************************************************
+   Function: get_time_ns
+
+Description: Returns the host's monotonic clock reading.
+
+     Inputs: None.
+
+    Outputs: Time in nanoseconds.
+*******************************************************************************/
+static int64_t get_time_ns(void) {
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return now.tv_sec * NANOSECONDS_PER_SECOND + now.tv_nsec;
+}
+
+/*******************************************************************************
+   Function: benchmark
+
+Description: Compresses a set of equally sized blocks, checks that each
+             decompresses intact, then times repeated decoding and encoding
+             of the whole set and prints the results.
+
+     Inputs: name       - Name of the data set.
+             blocks     - Pointer to the first block.
+             num_blocks - No. of blocks.
+             size       - Size of each block, in bytes.
+             stride     - Row stride to compress with, in bytes.
+             shard_size - Size of a storage shard, or zero if not stored.
+
+    Outputs: "True" if every block survived the round trip.
+*******************************************************************************/
+static bool benchmark(const char *name,
+                      const uint8_t *blocks,
+                      const int num_blocks,
+                      const uint16_t size,
+                      const uint16_t stride,
+                      const uint16_t shard_size) {
+  codec_stream_t stream;
+  int i;
+  uint16_t stored_size;
+  int64_t start, decode_ns, encode_ns, num_rounds;
+  uint32_t total_size = 0, total_compressed = 0, raw_shards = 0, shards = 0;
+
+  for (i = 0; i < num_blocks; ++i) {
+    stream = (codec_stream_t) {
+      .buffer = s_compressed[i],
+      .buffer_size = sizeof(s_compressed[i]),
+    };
+    compress_data(blocks + i * size, size, stride, &stream);
+    s_compressed_sizes[i] = stream.total;
+    stream = (codec_stream_t) {
+      .buffer = s_compressed[i],
+      .buffer_size = s_compressed_sizes[i],
+      .end = s_compressed_sizes[i],
+    };
+    if (!decompress_data(&stream, s_decompressed, size, stride) ||
+        memcmp(s_decompressed, blocks + i * size, size) != 0) {
+      fprintf(stderr, "%s: block %d didn't survive the round trip.\n",
+              name,
+              i);
+
+      return false;
+    }
+    stored_size = s_compressed_sizes[i] < size ? s_compressed_sizes[i] : size;
+    total_size += size;
+    total_compressed += stored_size;
+    if (shard_size > 0) {
+      raw_shards += (size + shard_size - 1) / shard_size;
+      shards += (stored_size + shard_size - 1) / shard_size;
+    }
+  }
+
+  start = get_time_ns();
+  for (num_rounds = 0;
+       get_time_ns() - start < MIN_BENCHMARK_NS;
+       ++num_rounds) {
+    for (i = 0; i < num_blocks; ++i) {
+      stream = (codec_stream_t) {
+        .buffer = s_compressed[i],
+        .buffer_size = s_compressed_sizes[i],
+        .end = s_compressed_sizes[i],
+      };
+      decompress_data(&stream, s_decompressed, size, stride);
+    }
+  }
+  decode_ns = (get_time_ns() - start) / num_rounds;
+
+  start = get_time_ns();
+  for (num_rounds = 0;
+       get_time_ns() - start < MIN_BENCHMARK_NS;
+       ++num_rounds) {
+    for (i = 0; i < num_blocks; ++i) {
+      stream = (codec_stream_t) {
+        .buffer = s_compressed[i],
+        .buffer_size = sizeof(s_compressed[i]),
+      };
+      compress_data(blocks + i * size, size, stride, &stream);
+    }
+  }
+  encode_ns = (get_time_ns() - start) / num_rounds;
+
+  printf("%-16s %3d x %5u bytes -> %5.1f%%",
+         name,
+         num_blocks,
+         (unsigned) size,
+         100.0 * total_compressed / total_size);
+  if (shard_size > 0) {
+    printf(", %lu shard(s) (%lu raw)",
+           (unsigned long) shards,
+           (unsigned long) raw_shards);
+  }
+  printf("\n%16s decode %7.1f MB/s, encode %6.1f MB/s\n",
+         "",
+         (double) total_size * NANOSECONDS_PER_SECOND / decode_ns / 1e6,
+         (double) total_size * NANOSECONDS_PER_SECOND / encode_ns / 1e6);
+
+  return true;
+}
+
+/*******************************************************************************
+   Function: main
+
+Description: Plays a seeded mission, capturing frames, then benchmarks the
+             codec over the mission's records and the frames.
+
+     Inputs: argc - No. of command-line arguments.
+             argv - Command-line arguments.
+
+    Outputs: Zero on success, one on failure.
+*******************************************************************************/
+int main(int argc, char **argv) {
+  const int seed = argc > 1 ? atoi(argv[1]) : DEFAULT_SEED;
+  GBitmap *frame_buffer;
+  uint16_t bytes_per_row = 0, frame_size = 0;
+  int i, j;
+  bool ok;
+
+  host_reset();
+  host_set_log_enabled(false);
+  init();
+  srand(seed);
+  for (i = 0;
+       i < MAX_MENU_PRESSES &&
+         window_stack_get_top_window() != g_graphics_window;
+       ++i) {
+    host_press_button(BUTTON_ID_SELECT, HOST_SINGLE_CLICK);  // Intro, etc.
+  }
+  if (g_mission == NULL) {
+    fprintf(stderr, "Failed to start a mission.\n");
+
+    return 1;
+  }
+  g_player->stats[MAX_HP] = g_player->stats[CURRENT_HP] = MAX_SMALL_INT_VALUE;
+  for (i = 0; i < NUM_FRAMES; ++i) {
+    for (j = 0; j < STEPS_PER_FRAME; ++j) {
+      host_press_button(rand() % 3 ? BUTTON_ID_UP : BUTTON_ID_DOWN,
+                        rand() % 2 ? HOST_SINGLE_CLICK : HOST_DOUBLE_CLICK);
+      host_advance_ms(SPRITE_FRAME_DURATION);
+      host_render();
+    }
+    if (i % (NUM_FRAMES / MAX_CHECKPOINTS) == 0) {
+      save_checkpoint();
+    }
+    frame_buffer = host_frame_buffer();
+    bytes_per_row = gbitmap_get_bytes_per_row(frame_buffer);
+    frame_size = (SCREEN_HEIGHT - STATUS_BAR_HEIGHT) * bytes_per_row;
+    memcpy(s_frames[i],
+           gbitmap_get_data(frame_buffer) + STATUS_BAR_HEIGHT * bytes_per_row,
+           frame_size);
+  }
+
+#ifdef PBL_COLOR
+  printf("Platform: basalt\n");
+#else
+  printf("Platform: aplite\n");
+#endif
+  printf("Seed: %d\n", seed);
+  ok = benchmark("player",
+                 (const uint8_t *) g_player,
+                 1,
+                 sizeof(player_t),
+                 get_record_stride(PLAYER_RECORD),
+                 RECORD_SHARD_SIZE) &&
+       benchmark("mission",
+                 (const uint8_t *) g_mission,
+                 1,
+                 sizeof(mission_t),
+                 get_record_stride(MISSION_RECORD),
+                 RECORD_SHARD_SIZE) &&
+       benchmark("mission history",
+                 (const uint8_t *) &g_mission_history,
+                 1,
+                 sizeof(mission_history_t),
+                 get_record_stride(MISSION_HISTORY_RECORD),
+                 RECORD_SHARD_SIZE) &&
+       benchmark("mission script",
+                 (const uint8_t *) &g_script_state,
+                 1,
+                 sizeof(script_state_t),
+                 get_record_stride(MISSION_SCRIPT_RECORD),
+                 RECORD_SHARD_SIZE) &&
+       benchmark("frames",
+                 s_frames[0],
+                 NUM_FRAMES,
+                 frame_size,
+                 bytes_per_row,
+                 0);
+  deinit();
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,254 @@
+/*******************************************************************************
+   Filename: heap_report.c
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Host replay of SpaceMerc's heap usage. Runs a series of scripted
+             scenarios on the host SDK stand-in (launch, a new mission, a loop
+             of deaths and checkpoint rewinds, a hundred missions back to back,
+             and shutdown) and reports, for each, the peak heap, the
+             fragmentation left behind and every allocation made during the
+             scenario that's still live at its end, by call site. Anything
+             still live after shutdown is a leak.
+
+      Usage: heap_report [<seed> [<resource directory> [<memory report>]]]
+
+             Given the resource directory (after a build, "resources"), the
+             sprite strips and mission scripts are loaded from it; otherwise
+             sprites are drawn directly and missions run without scripts.
+             Given the build's memory report for the platform (e.g.,
+             "build/aplite/app_memory_usage.txt"), the heap available is the
+             free heap it reports; otherwise, it's the least a build may
+             leave (see "HOST_DEFAULT_HEAP_FREE").
+
+             Build with, e.g.:
+             cc -DPBL_BW -Itools/host -Isrc tools/heap_report.c \
+               tools/host/host_shim.c -lz -lm
+*******************************************************************************/
+
+#include "pebble.h"
+#include "host_shim.h"
+
+#define main space_merc_main
+#include "space_merc.c"
+#undef main
+
+#define DEFAULT_SEED                     1
+#define NUM_DEATHS                       20
+#define NUM_MISSIONS                     100
+#define MISSION_DURATION                 3000  // milliseconds
+#define MAX_MENU_PRESSES                 10
+#define FRAME_INTERVAL                   50  // milliseconds
+#define MAX_PATH_LENGTH                  256
+#ifdef PBL_COLOR
+#define PLATFORM_NAME                    "basalt"
+#else
+#define PLATFORM_NAME                    "aplite"
+#endif
+
+/*******************************************************************************
+   Function: set_resource_files
+
+Description: Points the host's sprite strip and mission script resources at the
+             files generated under a given resource directory.
+
+     Inputs: directory - Path of the resource directory.
+
+    Outputs: None.
+*******************************************************************************/
+static void set_resource_files(const char *directory) {
+  char path[MAX_PATH_LENGTH];
+  int i;
+
+  for (i = 0; i < NUM_SPRITE_TYPES * (MAX_VISIBILITY_DEPTH - 1); ++i) {
+    snprintf(path,
+             MAX_PATH_LENGTH,
+             "%s/images/sprites/strip_%02d~%s.png",
+             directory,
+             i,
+             PLATFORM_NAME);
+    host_set_resource_file(RESOURCE_ID_SPRITE_STRIP_0 + i, path);
+  }
+  for (i = 0; i < NUM_MISSION_TYPES; ++i) {
+    snprintf(path, MAX_PATH_LENGTH, "%s/scripts/mission_%d.bin", directory, i);
+    host_set_resource_file(RESOURCE_ID_MISSION_SCRIPT_0 + i, path);
+  }
+}
+
+/*******************************************************************************
+   Function: set_heap_free
+
+Description: Sets the heap available to the free heap reported by a build (see
+             "report_app_memory_usage" in "wscript").
+
+     Inputs: path - Path of the build's memory report for this platform.
+
+    Outputs: "True" if the report was read.
+*******************************************************************************/
+static bool set_heap_free(const char *path) {
+  FILE *file = fopen(path, "r");
+  long free_heap;
+  bool read;
+
+  if (file == NULL) {
+    return false;
+  }
+  read = fscanf(file,
+                "footprint: %*d bytes, free heap: %ld",
+                &free_heap) == 1 && free_heap > 0;
+  fclose(file);
+  if (read) {
+    host_set_heap_free(free_heap);
+  }
+
+  return read;
+}
+
+/*******************************************************************************
+   Function: run
+
+Description: Advances the virtual clock, drawing frames as they're due.
+
+     Inputs: ms - No. of milliseconds to run for.
+
+    Outputs: None.
+*******************************************************************************/
+static void run(const uint32_t ms) {
+  uint32_t elapsed;
+
+  for (elapsed = 0; elapsed < ms; elapsed += FRAME_INTERVAL) {
+    host_advance_ms(FRAME_INTERVAL);
+    host_render();
+  }
+}
+
+/*******************************************************************************
+   Function: start_mission
+
+Description: Selects "New Mission" (or, after a death, "Retry Checkpoint") from
+             the main menu, via any narration in the way, and dismisses the
+             objective, leaving the graphics window up.
+
+     Inputs: None.
+
+    Outputs: "True" if a mission is underway.
+*******************************************************************************/
+static bool start_mission(void) {
+  int i;
+
+  show_window(g_main_menu_window);
+  menu_layer_set_selected_index(g_main_menu,
+                                (MenuIndex) {0, 0},
+                                MenuRowAlignCenter,
+                                NOT_ANIMATED);
+  for (i = 0;
+       i < MAX_MENU_PRESSES &&
+         window_stack_get_top_window() != g_graphics_window;
+       ++i) {
+    host_press_button(BUTTON_ID_SELECT, HOST_SINGLE_CLICK);
+    host_render();
+  }
+
+  return g_mission != NULL &&
+         window_stack_get_top_window() == g_graphics_window;
+}
+
+/*******************************************************************************
+   Function: leave_mission
+
+Description: Walks the player out through the mission's entrance, ending it.
+
+     Inputs: None.
+
+    Outputs: None.
+*******************************************************************************/
+static void leave_mission(void) {
+  g_player->position = g_mission->entrance;
+  set_player_direction(g_mission->entrance_direction);
+  host_press_button(BUTTON_ID_UP, HOST_SINGLE_CLICK);
+  run(FRAME_INTERVAL);
+  host_press_button(BUTTON_ID_SELECT, HOST_SINGLE_CLICK);  // Conclusion.
+  host_render();
+}
+
+/*******************************************************************************
+   Function: main
+
+Description: Runs each scenario in turn and prints its report.
+
+     Inputs: argc - No. of command-line arguments.
+             argv - Command-line arguments.
+
+    Outputs: Zero on success, one on failure.
+*******************************************************************************/
+int main(int argc, char **argv) {
+  const int seed = argc > 1 ? atoi(argv[1]) : DEFAULT_SEED;
+  int i;
+
+  host_reset();
+  host_set_log_enabled(false);
+  if (argc > 2) {
+    set_resource_files(argv[2]);
+  }
+  if (argc > 3 && !set_heap_free(argv[3])) {
+    fprintf(stderr, "Failed to read \"%s\".\n", argv[3]);
+
+    return 1;
+  }
+
+  host_heap_begin_scenario();
+  init();
+  srand(seed);
+  for (i = 0;
+       i < MAX_MENU_PRESSES &&
+         window_stack_get_top_window() == g_narration_window;
+       ++i) {
+    host_press_button(BUTTON_ID_SELECT, HOST_SINGLE_CLICK);  // Intro.
+  }
+  host_render();
+  host_heap_report(stdout, "launch", false);
+
+  host_heap_begin_scenario();
+  if (!start_mission()) {
+    fprintf(stderr, "Failed to start a mission.\n");
+
+    return 1;
+  }
+  run(MISSION_DURATION);
+  host_heap_report(stdout, "new mission", false);
+
+  host_heap_begin_scenario();
+  for (i = 0; i < NUM_DEATHS && g_mission != NULL; ++i) {
+    if (i % 4 == 0) {
+      save_checkpoint();
+    }
+    adjust_player_current_hp(-g_player->stats[CURRENT_HP]);
+    host_press_button(BUTTON_ID_SELECT, HOST_SINGLE_CLICK);  // Narration.
+    if (!start_mission()) {
+      break;
+    }
+    run(FRAME_INTERVAL * 4);
+  }
+  host_heap_report(stdout, "death loop", false);
+
+  host_heap_begin_scenario();
+  for (i = 0; i < NUM_MISSIONS; ++i) {
+    if (g_mission != NULL) {
+      leave_mission();
+    }
+    if (!start_mission()) {
+      fprintf(stderr, "Failed to start mission %d.\n", i + 1);
+
+      return 1;
+    }
+    run(MISSION_DURATION);
+  }
+  leave_mission();
+  host_heap_report(stdout, "100 missions", false);
+
+  host_heap_begin_scenario();
+  deinit();
+  host_heap_report(stdout, "shutdown", true);  // Leaks.
+
+  return 0;
+}
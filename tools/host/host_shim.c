@@ -0,0 +1,1582 @@
+/*******************************************************************************
+   Filename: host_shim.c
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Host-side implementation of the Pebble SDK subset declared in
+             "pebble.h": a software rasterizer for the drawing primitives
+             SpaceMerc uses, an in-memory persistent store, a virtual clock
+             with app timers, and a window stack with simulated buttons.
+*******************************************************************************/
+
+#include <math.h>
+#include <stdarg.h>
+#include <zlib.h>
+
+#define HOST_SHIM_IMPLEMENTATION  // Not tracked via "host_shim.h" macros.
+#include "pebble.h"
+
+#define HOST_MAX_TIMERS                  32
+#define HOST_MAX_WINDOWS                 8
+#define HOST_MAX_PERSIST_KEYS            128
+#define HOST_MAX_RESOURCES               64
+#define HOST_FRAME_BUFFER_ROW_SIZE_BW    20
+#define HOST_MAX_ALLOCATIONS             4096
+#define HOST_HEAP_BLOCK_OVERHEAD         8  // Allocator header per block.
+#define HOST_HEAP_ALIGNMENT              8
+
+struct AppTimer {
+  uint32_t due_ms;
+  AppTimerCallback callback;
+  void *data;
+  bool active;
+};
+
+struct HostClickRecognizer {
+  ButtonId button_id;
+  uint8_t num_clicks;
+};
+
+struct HostResource {
+  uint32_t resource_id;
+  char path[256];
+};
+
+// Kinds of tracked allocation:
+enum {
+  HOST_HEAP_ALLOCATION,
+  HOST_BITMAP_ALLOCATION,
+  HOST_PATH_ALLOCATION,
+  HOST_WINDOW_ALLOCATION,
+  HOST_LAYER_ALLOCATION,
+  HOST_RESOURCE_ALLOCATION,  // Transient buffer for loading a resource.
+  NUM_HOST_ALLOCATION_KINDS
+};
+
+// A live allocation, placed first-fit in a simulated heap so fragmentation
+// can be measured:
+typedef struct HostAllocation {
+  const void *pointer;
+  size_t size,    // As requested.
+         offset,  // Of the block in the simulated heap.
+         block_size;
+  const char *file;
+  int line,
+      kind;
+  uint32_t serial;
+} HostAllocation;
+
+typedef struct HostPersistEntry {
+  uint32_t key;
+  int size;
+  uint8_t data[PERSIST_DATA_MAX_LENGTH];
+  bool used;
+} HostPersistEntry;
+
+static uint8_t s_frame_buffer_data[HOST_SCREEN_HEIGHT * HOST_SCREEN_WIDTH];
+static GBitmap s_frame_buffer;
+static GContext s_ctx;
+static uint32_t s_now_ms,
+                s_frame_count;
+static AppTimer s_timers[HOST_MAX_TIMERS];
+static Window *s_window_stack[HOST_MAX_WINDOWS];
+static int s_num_windows;
+static Window *s_configuring_window;
+static HostPersistEntry s_persist[HOST_MAX_PERSIST_KEYS];
+static struct HostResource s_resources[HOST_MAX_RESOURCES];
+static TickHandler s_tick_handler;
+static AppFocusHandler s_focus_handler;
+static BatteryChargeState s_battery = {100, false, false};
+static bool s_log_enabled = true;
+static size_t s_heap_free = HOST_DEFAULT_HEAP_FREE;
+static HostAllocation s_allocations[HOST_MAX_ALLOCATIONS];  // By offset.
+static int s_num_allocations;
+static const char *s_call_site_file = "(unknown)",
+                  *s_failure_file;  // First failed this scenario, if any.
+static int s_call_site_line,
+           s_failure_line;
+static bool s_call_site_held;  // See "HOST_TRACKED_CALLER".
+static uint32_t s_allocation_serial,
+                s_scenario_serial,
+                s_scenario_allocs,
+                s_scenario_frees,
+                s_scenario_failures;  // Allocations the heap had no room for.
+static size_t s_heap_live,
+              s_heap_peak_live,
+              s_heap_peak_footprint;
+static const char *const s_allocation_kind_names[] = {
+  "heap",
+  "bitmap",
+  "path",
+  "window",
+  "layer",
+  "resource",
+};
+
+/*******************************************************************************
+  Allocation tracking
+*******************************************************************************/
+
+static size_t heap_footprint(void) {
+  return s_num_allocations == 0 ? 0 :
+    s_allocations[s_num_allocations - 1].offset +
+    s_allocations[s_num_allocations - 1].block_size;
+}
+
+// Places an allocation in the simulated heap, or returns false (the caller
+// then frees it and fails) if there's no room for it there:
+static bool track_allocation(const void *pointer, size_t size, int kind) {
+  const size_t block_size = (size + HOST_HEAP_BLOCK_OVERHEAD +
+                             HOST_HEAP_ALIGNMENT - 1) /
+                            HOST_HEAP_ALIGNMENT * HOST_HEAP_ALIGNMENT;
+  size_t offset = 0;
+  int i;
+
+  if (pointer == NULL) {
+    return false;
+  }
+
+  // First fit:
+  for (i = 0; i < s_num_allocations; ++i) {
+    if (s_allocations[i].offset - offset >= block_size) {
+      break;
+    }
+    offset = s_allocations[i].offset + s_allocations[i].block_size;
+  }
+  if (offset + block_size > s_heap_free ||
+      s_num_allocations == HOST_MAX_ALLOCATIONS) {
+    if (s_scenario_failures++ == 0) {
+      s_failure_file = s_call_site_file;
+      s_failure_line = s_call_site_line;
+    }
+    return false;
+  }
+  memmove(&s_allocations[i + 1],
+          &s_allocations[i],
+          (s_num_allocations - i) * sizeof(HostAllocation));
+  s_allocations[i] = (HostAllocation) {pointer, size, offset, block_size,
+                                       s_call_site_file, s_call_site_line,
+                                       kind, ++s_allocation_serial};
+  s_num_allocations++;
+  s_scenario_allocs++;
+  s_heap_live += block_size;
+  if (s_heap_live > s_heap_peak_live) {
+    s_heap_peak_live = s_heap_live;
+  }
+  if (heap_footprint() > s_heap_peak_footprint) {
+    s_heap_peak_footprint = heap_footprint();
+  }
+
+  return true;
+}
+
+static void untrack_allocation(const void *pointer) {
+  int i;
+
+  for (i = 0; i < s_num_allocations; ++i) {
+    if (s_allocations[i].pointer == pointer) {
+      s_heap_live -= s_allocations[i].block_size;
+      s_scenario_frees++;
+      s_num_allocations--;
+      memmove(&s_allocations[i],
+              &s_allocations[i + 1],
+              (s_num_allocations - i) * sizeof(HostAllocation));
+      return;
+    }
+  }
+}
+
+static void *tracked_calloc(size_t size, int kind) {
+  void *pointer = calloc(1, size);
+
+  if (!track_allocation(pointer, size, kind)) {
+    free(pointer);
+    return NULL;
+  }
+
+  return pointer;
+}
+
+static void tracked_free(void *pointer) {
+  untrack_allocation(pointer);
+  free(pointer);
+}
+
+void host_set_call_site(const char *file, int line) {
+  if (!s_call_site_held) {
+    s_call_site_file = file;
+    s_call_site_line = line;
+  }
+}
+
+void host_hold_call_site(const char *file, int line) {
+  host_set_call_site(file, line);
+  s_call_site_held = true;
+}
+
+void *host_release_call_site(void *result) {
+  s_call_site_held = false;
+
+  return result;
+}
+
+void *host_malloc(size_t size, const char *file, int line) {
+  void *pointer = malloc(size);
+
+  host_set_call_site(file, line);
+  if (!track_allocation(pointer, size, HOST_HEAP_ALLOCATION)) {
+    free(pointer);
+    return NULL;
+  }
+
+  return pointer;
+}
+
+void *host_calloc(size_t count, size_t size, const char *file, int line) {
+  void *pointer = calloc(count, size);
+
+  host_set_call_site(file, line);
+  if (!track_allocation(pointer, count * size, HOST_HEAP_ALLOCATION)) {
+    free(pointer);
+    return NULL;
+  }
+
+  return pointer;
+}
+
+void host_free(void *pointer) {
+  tracked_free(pointer);
+}
+
+void host_heap_begin_scenario(void) {
+  s_scenario_serial = s_allocation_serial;
+  s_scenario_allocs = 0;
+  s_scenario_frees = 0;
+  s_scenario_failures = 0;
+  s_heap_peak_live = s_heap_live;
+  s_heap_peak_footprint = heap_footprint();
+}
+
+void host_heap_report(FILE *file, const char *scenario, bool all_live) {
+  size_t footprint = heap_footprint(), offset = 0, largest_gap = 0,
+         num_bytes;
+  int i, j, num_live = 0, count;
+  size_t live_bytes = 0;
+
+  for (i = 0; i < s_num_allocations; ++i) {
+    if (s_allocations[i].offset - offset > largest_gap) {
+      largest_gap = s_allocations[i].offset - offset;
+    }
+    offset = s_allocations[i].offset + s_allocations[i].block_size;
+    if (all_live || s_allocations[i].serial > s_scenario_serial) {
+      num_live++;
+      live_bytes += s_allocations[i].block_size;
+    }
+  }
+  fprintf(file, "Scenario: %s\n", scenario);
+  fprintf(file, "  Peak heap: %zu bytes live, %zu bytes footprint "
+                "(%zu available)\n",
+          s_heap_peak_live, s_heap_peak_footprint, s_heap_free);
+  fprintf(file, "  Allocations: %lu (%lu freed)\n",
+          (unsigned long) s_scenario_allocs, (unsigned long) s_scenario_frees);
+  if (s_scenario_failures > 0) {
+    fprintf(file, "  Out of heap: %lu allocations failed (the first at "
+                  "%s:%d)\n",
+            (unsigned long) s_scenario_failures, s_failure_file,
+            s_failure_line);
+  }
+  fprintf(file, "  Fragmentation at end: %.0f%% (largest free block %zu of "
+                "%zu free bytes)\n",
+          footprint > s_heap_live ?
+            100.0 * (1.0 - (double) largest_gap / (footprint - s_heap_live)) :
+            0.0,
+          largest_gap, footprint - s_heap_live);
+  fprintf(file, "  Still live%s: %d allocations, %zu bytes\n",
+          all_live ? "" : " from this scenario", num_live, live_bytes);
+
+  // List them by call site:
+  for (i = 0; i < s_num_allocations; ++i) {
+    if (!all_live && s_allocations[i].serial <= s_scenario_serial) {
+      continue;
+    }
+    for (j = 0; j < i; ++j) {
+      if ((all_live || s_allocations[j].serial > s_scenario_serial) &&
+          s_allocations[j].line == s_allocations[i].line &&
+          strcmp(s_allocations[j].file, s_allocations[i].file) == 0) {
+        break;
+      }
+    }
+    if (j < i) {
+      continue;  // Already listed.
+    }
+    count = 0;
+    num_bytes = 0;
+    for (j = i; j < s_num_allocations; ++j) {
+      if ((all_live || s_allocations[j].serial > s_scenario_serial) &&
+          s_allocations[j].line == s_allocations[i].line &&
+          strcmp(s_allocations[j].file, s_allocations[i].file) == 0) {
+        count++;
+        num_bytes += s_allocations[j].size;
+      }
+    }
+    fprintf(file, "    %s:%d %s x%d, %zu bytes\n",
+            s_allocations[i].file, s_allocations[i].line,
+            s_allocation_kind_names[s_allocations[i].kind], count, num_bytes);
+  }
+}
+
+/*******************************************************************************
+  Geometry helpers
+*******************************************************************************/
+
+bool gpoint_equal(const GPoint *const point_a, const GPoint *const point_b) {
+  return point_a->x == point_b->x && point_a->y == point_b->y;
+}
+
+bool grect_equal(const GRect *const rect_a, const GRect *const rect_b) {
+  return memcmp(rect_a, rect_b, sizeof(GRect)) == 0;
+}
+
+int32_t sin_lookup(int32_t angle) {
+  return (int32_t) lround(sin(2.0 * M_PI * angle / TRIG_MAX_ANGLE) *
+                          TRIG_MAX_RATIO);
+}
+
+int32_t cos_lookup(int32_t angle) {
+  return (int32_t) lround(cos(2.0 * M_PI * angle / TRIG_MAX_ANGLE) *
+                          TRIG_MAX_RATIO);
+}
+
+/*******************************************************************************
+  Bitmaps
+*******************************************************************************/
+
+static uint16_t row_size_for(int16_t width, GBitmapFormat format) {
+  if (format == GBitmapFormat1Bit) {
+    return ((width + 31) / 32) * 4;
+  }
+
+  return width;
+}
+
+GBitmap *gbitmap_create_blank(GSize size, GBitmapFormat format) {
+  GBitmap *bitmap;
+
+  if (format != GBitmapFormat1Bit && format != GBitmapFormat8Bit) {
+    return NULL;
+  }
+  bitmap = calloc(1, sizeof(GBitmap));
+  if (bitmap == NULL) {
+    return NULL;
+  }
+  bitmap->format = format;
+  bitmap->bounds = GRect(0, 0, size.w, size.h);
+  bitmap->row_size_bytes = row_size_for(size.w, format);
+  bitmap->addr = calloc(1, bitmap->row_size_bytes * (size.h > 0 ? size.h : 1));
+  if (bitmap->addr == NULL) {
+    free(bitmap);
+    return NULL;
+  }
+  bitmap->owns_data = true;
+  if (!track_allocation(bitmap,
+                        sizeof(GBitmap) +
+                          bitmap->row_size_bytes * (size.h > 0 ? size.h : 1),
+                        HOST_BITMAP_ALLOCATION)) {
+    free(bitmap->addr);
+    free(bitmap);
+    return NULL;
+  }
+
+  return bitmap;
+}
+
+GBitmap *gbitmap_create_as_sub_bitmap(const GBitmap *base_bitmap,
+                                      GRect sub_rect) {
+  GBitmap *bitmap = tracked_calloc(sizeof(GBitmap), HOST_BITMAP_ALLOCATION);
+
+  if (bitmap == NULL) {
+    return NULL;
+  }
+  *bitmap = *base_bitmap;
+  bitmap->bounds = sub_rect;
+  bitmap->owns_data = false;
+
+  return bitmap;
+}
+
+void gbitmap_destroy(GBitmap *bitmap) {
+  if (bitmap == NULL) {
+    return;
+  }
+  if (bitmap->owns_data) {
+    free(bitmap->addr);
+  }
+  tracked_free(bitmap);
+}
+
+uint8_t *gbitmap_get_data(const GBitmap *bitmap) {
+  return bitmap->addr;
+}
+
+uint16_t gbitmap_get_bytes_per_row(const GBitmap *bitmap) {
+  return bitmap->row_size_bytes;
+}
+
+GBitmapFormat gbitmap_get_format(const GBitmap *bitmap) {
+  return bitmap->format;
+}
+
+GRect gbitmap_get_bounds(const GBitmap *bitmap) {
+  return bitmap->bounds;
+}
+
+/*******************************************************************************
+  Rasterizer
+*******************************************************************************/
+
+static bool color_is_white(GColor color) {
+  return color.r + color.g + color.b >= 5;
+}
+
+static void put_pixel(GBitmap *bitmap, int x, int y, GColor color) {
+  uint8_t *byte;
+
+  if (color.a == 0 ||
+      x < 0 || y < 0 ||
+      x >= bitmap->bounds.size.w || y >= bitmap->bounds.size.h) {
+    return;
+  }
+  x += bitmap->bounds.origin.x;
+  y += bitmap->bounds.origin.y;
+  if (bitmap->format == GBitmapFormat1Bit) {
+    byte = &bitmap->addr[y * bitmap->row_size_bytes + x / 8];
+    if (color_is_white(color)) {
+      *byte |= 1 << (x % 8);
+    } else {
+      *byte &= ~(1 << (x % 8));
+    }
+  } else {
+    bitmap->addr[y * bitmap->row_size_bytes + x] = color.argb;
+  }
+}
+
+static GColor get_pixel(const GBitmap *bitmap, int x, int y) {
+  x += bitmap->bounds.origin.x;
+  y += bitmap->bounds.origin.y;
+  if (bitmap->format == GBitmapFormat1Bit) {
+    return (bitmap->addr[y * bitmap->row_size_bytes + x / 8] >> (x % 8)) & 1 ?
+             GColorWhite : GColorBlack;
+  }
+
+  return (GColor8) {.argb = bitmap->addr[y * bitmap->row_size_bytes + x]};
+}
+
+void graphics_context_set_stroke_color(GContext *ctx, GColor color) {
+  ctx->stroke_color = color;
+}
+
+void graphics_context_set_fill_color(GContext *ctx, GColor color) {
+  ctx->fill_color = color;
+}
+
+void graphics_context_set_compositing_mode(GContext *ctx, GCompOp mode) {
+  ctx->compositing_mode = mode;
+}
+
+void graphics_draw_pixel(GContext *ctx, GPoint point) {
+  put_pixel(ctx->frame_buffer, point.x, point.y, ctx->stroke_color);
+}
+
+void graphics_draw_line(GContext *ctx, GPoint p0, GPoint p1) {
+  int x0 = p0.x, y0 = p0.y, x1 = p1.x, y1 = p1.y,
+      dx = abs(x1 - x0), dy = -abs(y1 - y0),
+      sx = x0 < x1 ? 1 : -1, sy = y0 < y1 ? 1 : -1,
+      err = dx + dy, e2;
+
+  for (;;) {
+    put_pixel(ctx->frame_buffer, x0, y0, ctx->stroke_color);
+    if (x0 == x1 && y0 == y1) {
+      break;
+    }
+    e2 = 2 * err;
+    if (e2 >= dy) {
+      err += dy;
+      x0 += sx;
+    }
+    if (e2 <= dx) {
+      err += dx;
+      y0 += sy;
+    }
+  }
+}
+
+static bool outside_corner(int x, int y, GRect rect, int radius,
+                           GCornerMask corners) {
+  int cx, cy;
+
+  if (radius <= 0) {
+    return false;
+  }
+  if (x < rect.origin.x + radius) {
+    cx = rect.origin.x + radius;
+    if (y < rect.origin.y + radius && (corners & GCornerTopLeft)) {
+      cy = rect.origin.y + radius;
+    } else if (y >= rect.origin.y + rect.size.h - radius &&
+               (corners & GCornerBottomLeft)) {
+      cy = rect.origin.y + rect.size.h - radius - 1;
+    } else {
+      return false;
+    }
+  } else if (x >= rect.origin.x + rect.size.w - radius) {
+    cx = rect.origin.x + rect.size.w - radius - 1;
+    if (y < rect.origin.y + radius && (corners & GCornerTopRight)) {
+      cy = rect.origin.y + radius;
+    } else if (y >= rect.origin.y + rect.size.h - radius &&
+               (corners & GCornerBottomRight)) {
+      cy = rect.origin.y + rect.size.h - radius - 1;
+    } else {
+      return false;
+    }
+  } else {
+    return false;
+  }
+
+  return (x - cx) * (x - cx) + (y - cy) * (y - cy) > radius * radius;
+}
+
+void graphics_fill_rect(GContext *ctx,
+                        GRect rect,
+                        uint16_t corner_radius,
+                        GCornerMask corner_mask) {
+  int x, y, radius = corner_radius;
+
+  if (rect.size.w < 0) {
+    rect.origin.x += rect.size.w;
+    rect.size.w = -rect.size.w;
+  }
+  if (rect.size.h < 0) {
+    rect.origin.y += rect.size.h;
+    rect.size.h = -rect.size.h;
+  }
+  if (radius > rect.size.w / 2) {
+    radius = rect.size.w / 2;
+  }
+  if (radius > rect.size.h / 2) {
+    radius = rect.size.h / 2;
+  }
+  for (y = rect.origin.y; y < rect.origin.y + rect.size.h; ++y) {
+    for (x = rect.origin.x; x < rect.origin.x + rect.size.w; ++x) {
+      if (!outside_corner(x, y, rect, radius, corner_mask)) {
+        put_pixel(ctx->frame_buffer, x, y, ctx->fill_color);
+      }
+    }
+  }
+}
+
+void graphics_fill_circle(GContext *ctx, GPoint p, uint16_t radius) {
+  int x, y, r = radius;
+
+  for (y = -r; y <= r; ++y) {
+    for (x = -r; x <= r; ++x) {
+      if (x * x + y * y <= r * r + r) {
+        put_pixel(ctx->frame_buffer, p.x + x, p.y + y, ctx->fill_color);
+      }
+    }
+  }
+}
+
+void graphics_draw_circle(GContext *ctx, GPoint p, uint16_t radius) {
+  int32_t theta;
+
+  for (theta = 0; theta < TRIG_MAX_ANGLE; theta += TRIG_MAX_ANGLE / 256) {
+    put_pixel(ctx->frame_buffer,
+              p.x + cos_lookup(theta) * radius / TRIG_MAX_RATIO,
+              p.y + sin_lookup(theta) * radius / TRIG_MAX_RATIO,
+              ctx->stroke_color);
+  }
+}
+
+void graphics_draw_bitmap_in_rect(GContext *ctx,
+                                  const GBitmap *bitmap,
+                                  GRect rect) {
+  int x, y;
+  bool src_white, dst_white;
+  GColor src, dst;
+
+  for (y = 0; y < rect.size.h && y < bitmap->bounds.size.h; ++y) {
+    for (x = 0; x < rect.size.w && x < bitmap->bounds.size.w; ++x) {
+      if (rect.origin.x + x < 0 || rect.origin.y + y < 0 ||
+          rect.origin.x + x >= ctx->frame_buffer->bounds.size.w ||
+          rect.origin.y + y >= ctx->frame_buffer->bounds.size.h) {
+        continue;
+      }
+      src = get_pixel(bitmap, x, y);
+      if (bitmap->format == GBitmapFormat8Bit &&
+          ctx->frame_buffer->format == GBitmapFormat8Bit) {
+        if (ctx->compositing_mode == GCompOpSet && src.a == 0) {
+          continue;
+        }
+        put_pixel(ctx->frame_buffer, rect.origin.x + x, rect.origin.y + y, src);
+        continue;
+      }
+      src_white = color_is_white(src);
+      dst = get_pixel(ctx->frame_buffer, rect.origin.x + x, rect.origin.y + y);
+      dst_white = color_is_white(dst);
+      switch (ctx->compositing_mode) {
+        case GCompOpAssignInverted:
+          dst_white = !src_white;
+          break;
+        case GCompOpOr:
+          dst_white = dst_white || src_white;
+          break;
+        case GCompOpAnd:
+          dst_white = dst_white && src_white;
+          break;
+        case GCompOpClear:
+          dst_white = dst_white && !src_white;
+          break;
+        case GCompOpSet:
+          dst_white = dst_white || !src_white;
+          break;
+        default:  // case GCompOpAssign:
+          dst_white = src_white;
+          break;
+      }
+      put_pixel(ctx->frame_buffer,
+                rect.origin.x + x,
+                rect.origin.y + y,
+                dst_white ? GColorWhite : GColorBlack);
+    }
+  }
+}
+
+GBitmap *graphics_capture_frame_buffer(GContext *ctx) {
+  if (ctx->frame_buffer_captured) {
+    return NULL;
+  }
+  ctx->frame_buffer_captured = true;
+
+  return ctx->frame_buffer;
+}
+
+bool graphics_release_frame_buffer(GContext *ctx, GBitmap *buffer) {
+  ctx->frame_buffer_captured = false;
+
+  return buffer == ctx->frame_buffer;
+}
+
+/*******************************************************************************
+  Paths
+*******************************************************************************/
+
+GPath *gpath_create(const GPathInfo *init) {
+  GPath *path = tracked_calloc(sizeof(GPath), HOST_PATH_ALLOCATION);
+
+  path->num_points = init->num_points;
+  path->points = init->points;
+
+  return path;
+}
+
+void gpath_destroy(GPath *path) {
+  tracked_free(path);
+}
+
+void gpath_rotate_to(GPath *path, int32_t angle) {
+  path->rotation = angle;
+}
+
+void gpath_move_to(GPath *path, GPoint point) {
+  path->offset = point;
+}
+
+static GPoint transformed_point(const GPath *path, uint32_t i) {
+  const int32_t c = cos_lookup(path->rotation), s = sin_lookup(path->rotation);
+  const GPoint p = path->points[i];
+
+  return GPoint((p.x * c - p.y * s) / TRIG_MAX_RATIO + path->offset.x,
+                (p.x * s + p.y * c) / TRIG_MAX_RATIO + path->offset.y);
+}
+
+void gpath_draw_filled(GContext *ctx, GPath *path) {
+  int y, x, min_y = 1000, max_y = -1000;
+  uint32_t i, j;
+  GPoint a, b;
+
+  for (i = 0; i < path->num_points; ++i) {
+    a = transformed_point(path, i);
+    min_y = a.y < min_y ? a.y : min_y;
+    max_y = a.y > max_y ? a.y : max_y;
+  }
+  for (y = min_y; y <= max_y; ++y) {
+    for (x = 0; x < ctx->frame_buffer->bounds.size.w; ++x) {
+      bool inside = false;
+
+      for (i = 0, j = path->num_points - 1; i < path->num_points; j = i++) {
+        a = transformed_point(path, i);
+        b = transformed_point(path, j);
+        if ((a.y > y) != (b.y > y) &&
+            x < (b.x - a.x) * (y - a.y) / (double) (b.y - a.y) + a.x) {
+          inside = !inside;
+        }
+      }
+      if (inside) {
+        put_pixel(ctx->frame_buffer, x, y, ctx->fill_color);
+      }
+    }
+  }
+}
+
+void gpath_draw_outline(GContext *ctx, GPath *path) {
+  uint32_t i;
+
+  for (i = 0; i < path->num_points; ++i) {
+    graphics_draw_line(ctx,
+                       transformed_point(path, i),
+                       transformed_point(path, (i + 1) % path->num_points));
+  }
+}
+
+/*******************************************************************************
+  Windows and layers
+*******************************************************************************/
+
+Layer *layer_create(GRect frame) {
+  Layer *layer = tracked_calloc(sizeof(Layer), HOST_LAYER_ALLOCATION);
+
+  layer->frame = frame;
+
+  return layer;
+}
+
+void layer_destroy(Layer *layer) {
+  tracked_free(layer);
+}
+
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc) {
+  layer->update_proc = update_proc;
+}
+
+void layer_mark_dirty(Layer *layer) {
+  layer->dirty = true;
+}
+
+void layer_add_child(Layer *parent, Layer *child) {
+  Layer *sibling;
+
+  for (sibling = parent->first_child; sibling != NULL;
+       sibling = sibling->next_sibling) {
+    if (sibling == child) {
+      return;
+    }
+  }
+  child->next_sibling = parent->first_child;
+  parent->first_child = child;
+}
+
+GRect layer_get_bounds(const Layer *layer) {
+  return GRect(0, 0, layer->frame.size.w, layer->frame.size.h);
+}
+
+GRect layer_get_frame(const Layer *layer) {
+  return layer->frame;
+}
+
+Window *window_create(void) {
+  Window *window = tracked_calloc(sizeof(Window), HOST_WINDOW_ALLOCATION);
+
+  window->root_layer.frame = GRect(0, 0, HOST_SCREEN_WIDTH, HOST_SCREEN_HEIGHT);
+  window->background_color = GColorWhite;
+
+  return window;
+}
+
+void window_destroy(Window *window) {
+  tracked_free(window);
+}
+
+Layer *window_get_root_layer(const Window *window) {
+  return (Layer *) &window->root_layer;
+}
+
+void window_set_background_color(Window *window, GColor background_color) {
+  window->background_color = background_color;
+}
+
+void window_set_window_handlers(Window *window, WindowHandlers handlers) {
+  window->handlers = handlers;
+}
+
+void window_set_click_config_provider(Window *window,
+                                      ClickConfigProvider provider) {
+  window->click_config_provider = provider;
+}
+
+void window_single_click_subscribe(ButtonId button_id, ClickHandler handler) {
+  s_configuring_window->single_click_handlers[button_id] = handler;
+}
+
+void window_single_repeating_click_subscribe(ButtonId button_id,
+                                             uint16_t repeat_interval_ms,
+                                             ClickHandler handler) {
+  s_configuring_window->single_click_handlers[button_id] = handler;
+  s_configuring_window->repeat_intervals[button_id] = repeat_interval_ms;
+}
+
+void window_multi_click_subscribe(ButtonId button_id,
+                                  uint8_t min_clicks,
+                                  uint8_t max_clicks,
+                                  uint16_t timeout,
+                                  bool last_click_only,
+                                  ClickHandler handler) {
+  s_configuring_window->multi_click_handlers[button_id] = handler;
+}
+
+uint8_t click_number_of_clicks_counted(ClickRecognizerRef recognizer) {
+  return recognizer->num_clicks;
+}
+
+ButtonId click_recognizer_get_button_id(ClickRecognizerRef recognizer) {
+  return recognizer->button_id;
+}
+
+static void configure_clicks(Window *window) {
+  memset(window->single_click_handlers, 0,
+         sizeof(window->single_click_handlers));
+  memset(window->multi_click_handlers, 0, sizeof(window->multi_click_handlers));
+  if (window->click_config_provider != NULL) {
+    s_configuring_window = window;
+    window->click_config_provider(window);
+  }
+}
+
+void window_stack_push(Window *window, bool animated) {
+  Window *previous = window_stack_get_top_window();
+
+  if (previous != NULL && previous->handlers.disappear != NULL) {
+    previous->handlers.disappear(previous);
+  }
+  s_window_stack[s_num_windows++] = window;
+  configure_clicks(window);
+  if (window->handlers.appear != NULL) {
+    window->handlers.appear(window);
+  }
+  window->root_layer.dirty = true;
+}
+
+void window_stack_pop_all(const bool animated) {
+  while (s_num_windows > 0) {
+    window_stack_pop(animated);
+  }
+}
+
+Window *window_stack_pop(bool animated) {
+  Window *window, *top;
+
+  if (s_num_windows == 0) {
+    return NULL;
+  }
+  window = s_window_stack[--s_num_windows];
+  if (window->handlers.disappear != NULL) {
+    window->handlers.disappear(window);
+  }
+  top = window_stack_get_top_window();
+  if (top != NULL) {
+    if (top->handlers.appear != NULL) {
+      top->handlers.appear(top);
+    }
+    top->root_layer.dirty = true;
+  }
+
+  return window;
+}
+
+bool window_stack_contains_window(Window *window) {
+  int i;
+
+  for (i = 0; i < s_num_windows; ++i) {
+    if (s_window_stack[i] == window) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+Window *window_stack_get_top_window(void) {
+  return s_num_windows > 0 ? s_window_stack[s_num_windows - 1] : NULL;
+}
+
+GFont fonts_get_system_font(const char *font_key) {
+  return NULL;
+}
+
+TextLayer *text_layer_create(GRect frame) {
+  TextLayer *text_layer = tracked_calloc(sizeof(TextLayer),
+                                         HOST_LAYER_ALLOCATION);
+
+  text_layer->layer.frame = frame;
+
+  return text_layer;
+}
+
+void text_layer_destroy(TextLayer *text_layer) {
+  tracked_free(text_layer);
+}
+
+Layer *text_layer_get_layer(TextLayer *text_layer) {
+  return &text_layer->layer;
+}
+
+void text_layer_set_text(TextLayer *text_layer, const char *text) {
+  text_layer->text = text;
+}
+
+void text_layer_set_background_color(TextLayer *text_layer, GColor color) {}
+void text_layer_set_text_color(TextLayer *text_layer, GColor color) {}
+void text_layer_set_font(TextLayer *text_layer, GFont font) {}
+void text_layer_set_text_alignment(TextLayer *text_layer,
+                                   GTextAlignment text_alignment) {}
+
+StatusBarLayer *status_bar_layer_create(void) {
+  StatusBarLayer *status_bar = tracked_calloc(sizeof(StatusBarLayer),
+                                              HOST_LAYER_ALLOCATION);
+
+  status_bar->layer.frame = GRect(0, 0, HOST_SCREEN_WIDTH, 16);
+
+  return status_bar;
+}
+
+void status_bar_layer_destroy(StatusBarLayer *status_bar_layer) {
+  tracked_free(status_bar_layer);
+}
+
+Layer *status_bar_layer_get_layer(StatusBarLayer *status_bar_layer) {
+  return &status_bar_layer->layer;
+}
+
+MenuLayer *menu_layer_create(GRect frame) {
+  MenuLayer *menu_layer = tracked_calloc(sizeof(MenuLayer),
+                                         HOST_LAYER_ALLOCATION);
+
+  menu_layer->layer.frame = frame;
+
+  return menu_layer;
+}
+
+void menu_layer_destroy(MenuLayer *menu_layer) {
+  tracked_free(menu_layer);
+}
+
+Layer *menu_layer_get_layer(const MenuLayer *menu_layer) {
+  return (Layer *) &menu_layer->layer;
+}
+
+void menu_layer_set_callbacks(MenuLayer *menu_layer,
+                              void *callback_context,
+                              MenuLayerCallbacks callbacks) {
+  menu_layer->callbacks = callbacks;
+}
+
+static MenuLayer *s_window_menus[HOST_MAX_WINDOWS];
+static Window *s_menu_windows[HOST_MAX_WINDOWS];
+static int s_num_menus;
+
+static void menu_click(ClickRecognizerRef recognizer, void *context) {
+  int i;
+  MenuLayer *menu_layer = NULL;
+
+  for (i = 0; i < s_num_menus; ++i) {
+    if (s_menu_windows[i] == window_stack_get_top_window()) {
+      menu_layer = s_window_menus[i];
+    }
+  }
+  if (menu_layer == NULL) {
+    return;
+  }
+  if (recognizer->button_id == BUTTON_ID_UP) {
+    if (menu_layer->selected_index.row > 0) {
+      menu_layer->selected_index.row--;
+    }
+  } else if (recognizer->button_id == BUTTON_ID_DOWN) {
+    if (menu_layer->selected_index.row + 1 <
+        menu_layer->callbacks.get_num_rows(menu_layer, 0, NULL)) {
+      menu_layer->selected_index.row++;
+    }
+  } else if (recognizer->button_id == BUTTON_ID_SELECT &&
+             menu_layer->callbacks.select_click != NULL) {
+    menu_layer->callbacks.select_click(menu_layer,
+                                       &menu_layer->selected_index,
+                                       NULL);
+  } else if (recognizer->button_id == BUTTON_ID_BACK) {
+    window_stack_pop(false);
+  }
+}
+
+static void menu_click_config_provider(void *context) {
+  window_single_click_subscribe(BUTTON_ID_UP, menu_click);
+  window_single_click_subscribe(BUTTON_ID_DOWN, menu_click);
+  window_single_click_subscribe(BUTTON_ID_SELECT, menu_click);
+  window_single_click_subscribe(BUTTON_ID_BACK, menu_click);
+}
+
+void menu_layer_set_click_config_onto_window(MenuLayer *menu_layer,
+                                             Window *window) {
+  if (s_num_menus < HOST_MAX_WINDOWS) {
+    s_window_menus[s_num_menus] = menu_layer;
+    s_menu_windows[s_num_menus++] = window;
+  }
+  window->click_config_provider = menu_click_config_provider;
+}
+
+void menu_layer_reload_data(MenuLayer *menu_layer) {}
+
+void menu_layer_set_selected_index(MenuLayer *menu_layer,
+                                   MenuIndex index,
+                                   MenuRowAlign scroll_align,
+                                   bool animated) {
+  menu_layer->selected_index = index;
+}
+
+void menu_cell_basic_draw(GContext *ctx,
+                          const Layer *cell_layer,
+                          const char *title,
+                          const char *subtitle,
+                          GBitmap *icon) {}
+
+void menu_cell_basic_header_draw(GContext *ctx,
+                                 const Layer *cell_layer,
+                                 const char *title) {}
+
+/*******************************************************************************
+  Services
+*******************************************************************************/
+
+void tick_timer_service_subscribe(TimeUnits tick_units, TickHandler handler) {
+  s_tick_handler = handler;
+}
+
+void tick_timer_service_unsubscribe(void) {
+  s_tick_handler = NULL;
+}
+
+void app_focus_service_subscribe(AppFocusHandler handler) {
+  s_focus_handler = handler;
+}
+
+void app_focus_service_unsubscribe(void) {
+  s_focus_handler = NULL;
+}
+
+BatteryChargeState battery_state_service_peek(void) {
+  return s_battery;
+}
+
+AppTimer *app_timer_register(uint32_t timeout_ms,
+                             AppTimerCallback callback,
+                             void *callback_data) {
+  int i;
+
+  for (i = 0; i < HOST_MAX_TIMERS; ++i) {
+    if (!s_timers[i].active) {
+      s_timers[i] = (AppTimer) {s_now_ms + timeout_ms, callback, callback_data,
+                                true};
+      return &s_timers[i];
+    }
+  }
+
+  return NULL;
+}
+
+bool app_timer_reschedule(AppTimer *timer_handle, uint32_t new_timeout_ms) {
+  if (timer_handle == NULL || !timer_handle->active) {
+    return false;
+  }
+  timer_handle->due_ms = s_now_ms + new_timeout_ms;
+
+  return true;
+}
+
+void app_timer_cancel(AppTimer *timer_handle) {
+  if (timer_handle != NULL) {
+    timer_handle->active = false;
+  }
+}
+
+void app_event_loop(void) {}
+void light_enable_interaction(void) {}
+void vibes_short_pulse(void) {}
+
+uint16_t time_ms(time_t *tloc, uint16_t *out_ms) {
+  if (tloc != NULL) {
+    *tloc = s_now_ms / 1000;
+  }
+  if (out_ms != NULL) {
+    *out_ms = s_now_ms % 1000;
+  }
+
+  return s_now_ms % 1000;
+}
+
+bool persist_exists(const uint32_t key) {
+  return persist_get_size(key) >= 0;
+}
+
+static HostPersistEntry *find_persist_entry(const uint32_t key) {
+  int i;
+
+  for (i = 0; i < HOST_MAX_PERSIST_KEYS; ++i) {
+    if (s_persist[i].used && s_persist[i].key == key) {
+      return &s_persist[i];
+    }
+  }
+
+  return NULL;
+}
+
+int persist_get_size(const uint32_t key) {
+  HostPersistEntry *entry = find_persist_entry(key);
+
+  return entry == NULL ? E_DOES_NOT_EXIST : entry->size;
+}
+
+int32_t persist_read_int(const uint32_t key) {
+  int32_t value = 0;
+
+  persist_read_data(key, &value, sizeof(value));
+
+  return value;
+}
+
+status_t persist_write_int(const uint32_t key, const int32_t value) {
+  return persist_write_data(key, &value, sizeof(value)) == sizeof(value) ?
+           S_SUCCESS : E_ERROR;
+}
+
+int persist_read_data(const uint32_t key,
+                      void *buffer,
+                      const size_t buffer_size) {
+  HostPersistEntry *entry = find_persist_entry(key);
+  int size;
+
+  if (entry == NULL) {
+    return E_DOES_NOT_EXIST;
+  }
+  size = (size_t) entry->size < buffer_size ? entry->size : (int) buffer_size;
+  memcpy(buffer, entry->data, size);
+
+  return size;
+}
+
+int persist_write_data(const uint32_t key,
+                       const void *data,
+                       const size_t size) {
+  HostPersistEntry *entry = find_persist_entry(key);
+  int i, written = size > PERSIST_DATA_MAX_LENGTH ? PERSIST_DATA_MAX_LENGTH :
+                                                    (int) size;
+
+  for (i = 0; entry == NULL && i < HOST_MAX_PERSIST_KEYS; ++i) {
+    if (!s_persist[i].used) {
+      entry = &s_persist[i];
+      entry->used = true;
+      entry->key = key;
+    }
+  }
+  if (entry == NULL) {
+    return E_ERROR;
+  }
+  memcpy(entry->data, data, written);
+  entry->size = written;
+
+  return written;
+}
+
+status_t persist_delete(const uint32_t key) {
+  HostPersistEntry *entry = find_persist_entry(key);
+
+  if (entry == NULL) {
+    return E_DOES_NOT_EXIST;
+  }
+  entry->used = false;
+
+  return S_SUCCESS;
+}
+
+void host_set_resource_file(uint32_t resource_id, const char *path) {
+  int i;
+
+  for (i = 0; i < HOST_MAX_RESOURCES; ++i) {
+    if (s_resources[i].path[0] == '\0' ||
+        s_resources[i].resource_id == resource_id) {
+      s_resources[i].resource_id = resource_id;
+      snprintf(s_resources[i].path, sizeof(s_resources[i].path), "%s", path);
+      return;
+    }
+  }
+}
+
+ResHandle resource_get_handle(uint32_t resource_id) {
+  int i;
+
+  for (i = 0; i < HOST_MAX_RESOURCES; ++i) {
+    if (s_resources[i].path[0] != '\0' &&
+        s_resources[i].resource_id == resource_id) {
+      return &s_resources[i];
+    }
+  }
+
+  return NULL;
+}
+
+size_t resource_size(ResHandle handle) {
+  FILE *file;
+  long size;
+
+  if (handle == NULL || (file = fopen(handle->path, "rb")) == NULL) {
+    return 0;
+  }
+  fseek(file, 0, SEEK_END);
+  size = ftell(file);
+  fclose(file);
+
+  return size < 0 ? 0 : (size_t) size;
+}
+
+size_t resource_load_byte_range(ResHandle handle,
+                                uint32_t start_offset,
+                                uint8_t *buffer,
+                                size_t num_bytes) {
+  FILE *file;
+  size_t num_read;
+
+  if (handle == NULL || (file = fopen(handle->path, "rb")) == NULL) {
+    return 0;
+  }
+  fseek(file, start_offset, SEEK_SET);
+  num_read = fread(buffer, 1, num_bytes, file);
+  fclose(file);
+
+  return num_read;
+}
+
+size_t resource_load(ResHandle handle, uint8_t *buffer, size_t max_length) {
+  return resource_load_byte_range(handle, 0, buffer, max_length);
+}
+
+static uint32_t read_uint32_be(const uint8_t *data) {
+  return (uint32_t) data[0] << 24 | data[1] << 16 | data[2] << 8 | data[3];
+}
+
+// Decodes the non-interlaced, unfiltered grayscale or palettized PNGs written
+// by "tools/sprite_atlas.c" (the same subset the Pebble SDK accepts).
+static GBitmap *decode_png(const uint8_t *data, size_t size) {
+  size_t pos = 8, chunk_size, idat_size = 0;
+  uLongf raw_size;
+  uint8_t *idat = NULL, *raw = NULL, *row, palette[256][4], color_type = 0,
+          bit_depth = 0, index;
+  int x, y, width = 0, height = 0, row_size, num_colors = 0;
+  GBitmap *bitmap = NULL;
+
+  if (size < 8 || memcmp(data, "\x89PNG\r\n\x1a\n", 8) != 0) {
+    return NULL;
+  }
+  memset(palette, 0xff, sizeof(palette));
+  while (pos + 12 <= size) {
+    chunk_size = read_uint32_be(data + pos);
+    if (pos + 12 + chunk_size > size) {
+      break;
+    }
+    if (memcmp(data + pos + 4, "IHDR", 4) == 0) {
+      width = read_uint32_be(data + pos + 8);
+      height = read_uint32_be(data + pos + 12);
+      bit_depth = data[pos + 16];
+      color_type = data[pos + 17];
+    } else if (memcmp(data + pos + 4, "PLTE", 4) == 0) {
+      for (num_colors = 0; num_colors < (int) chunk_size / 3; ++num_colors) {
+        memcpy(palette[num_colors], data + pos + 8 + num_colors * 3, 3);
+      }
+    } else if (memcmp(data + pos + 4, "tRNS", 4) == 0) {
+      for (x = 0; x < (int) chunk_size && x < 256; ++x) {
+        palette[x][3] = data[pos + 8 + x];
+      }
+    } else if (memcmp(data + pos + 4, "IDAT", 4) == 0) {
+      idat = realloc(idat, idat_size + chunk_size);
+      memcpy(idat + idat_size, data + pos + 8, chunk_size);
+      idat_size += chunk_size;
+    }
+    pos += 12 + chunk_size;
+  }
+  if (idat == NULL || width <= 0 || height <= 0 || bit_depth > 8 ||
+      (color_type != 0 && color_type != 3)) {
+    free(idat);
+    return NULL;
+  }
+  row_size = 1 + (width * bit_depth + 7) / 8;
+  raw_size = (uLongf) height * row_size;
+  raw = tracked_calloc(raw_size, HOST_RESOURCE_ALLOCATION);  // Decompressed.
+  if (raw == NULL ||
+      uncompress(raw, &raw_size, idat, idat_size) != Z_OK ||
+      raw_size != (uLongf) height * row_size) {
+    goto done;
+  }
+#ifdef PBL_COLOR
+  bitmap = gbitmap_create_blank(GSize(width, height), GBitmapFormat8Bit);
+#else
+  bitmap = gbitmap_create_blank(GSize(width, height), GBitmapFormat1Bit);
+#endif
+  for (y = 0; bitmap != NULL && y < height; ++y) {
+    row = raw + y * row_size;
+    if (row[0] != 0) {  // Only the "None" filter is supported.
+      gbitmap_destroy(bitmap);
+      bitmap = NULL;
+      break;
+    }
+    for (x = 0; x < width; ++x) {
+      index = (row[1 + x * bit_depth / 8] >>
+                 (8 - bit_depth - (x * bit_depth) % 8)) &
+              ((1 << bit_depth) - 1);
+      if (color_type == 0) {
+        index = index * 255 / ((1 << bit_depth) - 1);
+        put_pixel(bitmap, x, y, GColorFromRGB(index, index, index));
+      } else {
+        put_pixel(bitmap, x, y, palette[index][3] >= 128 ?
+                                  GColorFromRGB(palette[index][0],
+                                                palette[index][1],
+                                                palette[index][2]) :
+                                  GColorClear);
+      }
+    }
+  }
+
+done:
+  free(idat);
+  tracked_free(raw);
+
+  return bitmap;
+}
+
+GBitmap *gbitmap_create_with_resource(uint32_t resource_id) {
+  ResHandle handle = resource_get_handle(resource_id);
+  size_t size = resource_size(handle);
+  uint8_t *data;
+  GBitmap *bitmap;
+
+  if (size == 0 ||
+      (data = tracked_calloc(size, HOST_RESOURCE_ALLOCATION)) == NULL) {
+    return NULL;
+  }
+  resource_load(handle, data, size);
+  bitmap = decode_png(data, size);
+  tracked_free(data);
+
+  return bitmap;
+}
+
+void app_log(uint8_t log_level,
+             const char *src_filename,
+             int src_line_number,
+             const char *fmt,
+             ...) {
+  va_list args;
+
+  if (!s_log_enabled) {
+    return;
+  }
+  va_start(args, fmt);
+  fprintf(stderr, "[%u] %s:%d> ", log_level, src_filename, src_line_number);
+  vfprintf(stderr, fmt, args);
+  fprintf(stderr, "\n");
+  va_end(args);
+}
+
+/*******************************************************************************
+  Host driver hooks
+*******************************************************************************/
+
+void host_set_log_enabled(bool enabled) {
+  s_log_enabled = enabled;
+}
+
+void host_reset(void) {
+  memset(s_timers, 0, sizeof(s_timers));
+  memset(s_persist, 0, sizeof(s_persist));
+  s_num_windows = 0;
+  s_num_menus = 0;
+  s_now_ms = 0;
+  s_frame_count = 0;
+  s_tick_handler = NULL;
+  s_focus_handler = NULL;
+}
+
+size_t heap_bytes_free(void) {
+  return s_heap_free > s_heap_live ? s_heap_free - s_heap_live : 0;
+}
+
+size_t heap_bytes_used(void) {
+  return s_heap_live;
+}
+
+void host_set_heap_free(size_t bytes) {
+  s_heap_free = bytes;
+}
+
+uint32_t host_now_ms(void) {
+  return s_now_ms;
+}
+
+static void run_due_timers(void) {
+  int i;
+  bool fired;
+  AppTimer timer;
+
+  do {
+    fired = false;
+    for (i = 0; i < HOST_MAX_TIMERS; ++i) {
+      if (s_timers[i].active && s_timers[i].due_ms <= s_now_ms) {
+        timer = s_timers[i];
+        s_timers[i].active = false;
+        timer.callback(timer.data);
+        fired = true;
+      }
+    }
+  } while (fired);
+}
+
+void host_advance_ms(uint32_t ms) {
+  uint32_t target = s_now_ms + ms;
+  struct tm tick_time;
+  time_t now;
+
+  while (s_now_ms < target) {
+    s_now_ms++;
+    run_due_timers();
+    if (s_now_ms % 1000 == 0 && s_tick_handler != NULL) {
+      now = s_now_ms / 1000;
+      tick_time = *gmtime(&now);
+      s_tick_handler(&tick_time, SECOND_UNIT);
+    }
+  }
+}
+
+void host_set_battery(uint8_t charge_percent, bool is_charging) {
+  s_battery.charge_percent = charge_percent;
+  s_battery.is_charging = is_charging;
+}
+
+void host_press_button(ButtonId button_id, int8_t click_type) {
+  Window *window = window_stack_get_top_window();
+  struct HostClickRecognizer recognizer = {button_id, 1};
+
+  if (window == NULL) {
+    return;
+  }
+  if (click_type == HOST_DOUBLE_CLICK &&
+      window->multi_click_handlers[button_id] != NULL) {
+    recognizer.num_clicks = 2;
+    window->multi_click_handlers[button_id](&recognizer, window);
+  } else if (window->single_click_handlers[button_id] != NULL) {
+    window->single_click_handlers[button_id](&recognizer, window);
+  } else if (button_id == BUTTON_ID_BACK) {
+    window_stack_pop(false);
+  }
+}
+
+static void render_layer(Layer *layer) {
+  Layer *child;
+
+  if (layer->update_proc != NULL) {
+    layer->update_proc(layer, &s_ctx);
+  }
+  layer->dirty = false;
+  for (child = layer->first_child; child != NULL;
+       child = child->next_sibling) {
+    render_layer(child);
+  }
+}
+
+static bool layer_tree_dirty(Layer *layer) {
+  Layer *child;
+
+  if (layer->dirty) {
+    return true;
+  }
+  for (child = layer->first_child; child != NULL;
+       child = child->next_sibling) {
+    if (layer_tree_dirty(child)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+GContext *host_graphics_context(void) {
+  s_ctx.frame_buffer = host_frame_buffer();
+  s_ctx.frame_buffer_captured = false;
+  s_ctx.compositing_mode = GCompOpAssign;
+
+  return &s_ctx;
+}
+
+GBitmap *host_frame_buffer(void) {
+  if (s_frame_buffer.addr == NULL) {
+    s_frame_buffer.addr = s_frame_buffer_data;
+#ifdef PBL_COLOR
+    s_frame_buffer.format = GBitmapFormat8Bit;
+    s_frame_buffer.row_size_bytes = HOST_SCREEN_WIDTH;
+#else
+    s_frame_buffer.format = GBitmapFormat1Bit;
+    s_frame_buffer.row_size_bytes = HOST_FRAME_BUFFER_ROW_SIZE_BW;
+#endif
+    s_frame_buffer.bounds = GRect(0, 0, HOST_SCREEN_WIDTH, HOST_SCREEN_HEIGHT);
+  }
+
+  return &s_frame_buffer;
+}
+
+bool host_render(void) {
+  Window *window = window_stack_get_top_window();
+
+  if (window == NULL || !layer_tree_dirty(&window->root_layer)) {
+    return false;
+  }
+  s_ctx.frame_buffer = host_frame_buffer();
+  s_ctx.frame_buffer_captured = false;
+  s_ctx.compositing_mode = GCompOpAssign;
+  if (window->background_color.a != 0) {
+    s_ctx.fill_color = window->background_color;
+    graphics_fill_rect(&s_ctx,
+                       GRect(0, 0, HOST_SCREEN_WIDTH, HOST_SCREEN_HEIGHT),
+                       0,
+                       GCornerNone);
+  }
+  render_layer(&window->root_layer);
+  s_frame_count++;
+
+  return true;
+}
+
+uint32_t host_frame_count(void) {
+  return s_frame_count;
+}
+
+void host_write_ppm(const char *path) {
+  FILE *file = fopen(path, "wb");
+  GBitmap *frame_buffer = host_frame_buffer();
+  GColor color;
+  int x, y;
+
+  if (file == NULL) {
+    return;
+  }
+  fprintf(file, "P6\n%d %d\n255\n", HOST_SCREEN_WIDTH, HOST_SCREEN_HEIGHT);
+  for (y = 0; y < HOST_SCREEN_HEIGHT; ++y) {
+    for (x = 0; x < HOST_SCREEN_WIDTH; ++x) {
+      color = get_pixel(frame_buffer, x, y);
+      fputc(color.r * 85, file);
+      fputc(color.g * 85, file);
+      fputc(color.b * 85, file);
+    }
+  }
+  fclose(file);
+}
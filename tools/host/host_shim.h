@@ -0,0 +1,85 @@
+/*******************************************************************************
+   Filename: host_shim.h
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Host-only hooks into the Pebble SDK stand-in: a virtual clock,
+             simulated button presses, frame rendering and heap tracking, so
+             host tools can drive and measure SpaceMerc without a watch or
+             emulator.
+*******************************************************************************/
+
+#ifndef HOST_SHIM_H_
+#define HOST_SHIM_H_
+
+#define HOST_SCREEN_WIDTH                144
+#define HOST_SCREEN_HEIGHT               168
+#ifdef PBL_COLOR
+#define HOST_DEFAULT_HEAP_FREE           50000
+#else
+#define HOST_DEFAULT_HEAP_FREE           6144  // Least a build may leave (see "MIN_FREE_HEAP" in "wscript").
+#endif
+
+// Button press types understood by "host_press_button":
+enum {
+  HOST_SINGLE_CLICK,
+  HOST_DOUBLE_CLICK,
+  NUM_HOST_CLICK_TYPES
+};
+
+void host_reset(void);
+uint32_t host_now_ms(void);
+void host_advance_ms(uint32_t ms);
+void host_set_battery(uint8_t charge_percent, bool is_charging);
+void host_press_button(ButtonId button_id, int8_t click_type);
+bool host_render(void);
+GBitmap *host_frame_buffer(void);
+GContext *host_graphics_context(void);
+uint32_t host_frame_count(void);
+void host_write_ppm(const char *path);
+void host_set_resource_file(uint32_t resource_id, const char *path);
+void host_set_log_enabled(bool enabled);
+void host_set_heap_free(size_t bytes);
+
+// Heap tracking: every allocation made through "malloc", "calloc" and the SDK
+// constructors below is recorded with its call site and size, and placed in a
+// simulated first-fit heap so peak usage and fragmentation can be reported.
+// Like the watch's, that heap is only as big as "host_set_heap_free" says: an
+// allocation that doesn't fit fails (and is flagged in the report).
+// "heap_bytes_used" and "heap_bytes_free" reflect the tracked allocations.
+// "HOST_TRACKED_CALLER" credits everything a call allocates (e.g., the app's
+// "malloc_with_eviction") to the call's own site rather than the wrapper's.
+void host_set_call_site(const char *file, int line);
+void host_hold_call_site(const char *file, int line);
+void *host_release_call_site(void *result);
+void *host_malloc(size_t size, const char *file, int line);
+void *host_calloc(size_t count, size_t size, const char *file, int line);
+void host_free(void *pointer);
+void host_heap_begin_scenario(void);
+void host_heap_report(FILE *file, const char *scenario, bool all_live);
+
+#ifndef HOST_SHIM_IMPLEMENTATION
+#define HOST_TRACKED(call)               (host_set_call_site(__FILE__,         \
+                                                             __LINE__), call)
+#define HOST_TRACKED_CALLER(call)        (host_hold_call_site(__FILE__,        \
+                                                              __LINE__),       \
+                                          host_release_call_site(call))
+#define malloc(size)                     host_malloc(size, __FILE__, __LINE__)
+#define calloc(count, size)              host_calloc(count, size, __FILE__,    \
+                                                     __LINE__)
+#define free(pointer)                    host_free(pointer)
+#define gbitmap_create_blank(size, format)                                     \
+  HOST_TRACKED(gbitmap_create_blank(size, format))
+#define gbitmap_create_with_resource(resource_id)                              \
+  HOST_TRACKED(gbitmap_create_with_resource(resource_id))
+#define gbitmap_create_as_sub_bitmap(base_bitmap, sub_rect)                    \
+  HOST_TRACKED(gbitmap_create_as_sub_bitmap(base_bitmap, sub_rect))
+#define gpath_create(init)               HOST_TRACKED(gpath_create(init))
+#define window_create()                  HOST_TRACKED(window_create())
+#define layer_create(frame)              HOST_TRACKED(layer_create(frame))
+#define text_layer_create(frame)         HOST_TRACKED(text_layer_create(frame))
+#define status_bar_layer_create()        HOST_TRACKED(status_bar_layer_create())
+#define menu_layer_create(frame)         HOST_TRACKED(menu_layer_create(frame))
+#endif
+
+#endif  // HOST_SHIM_H_
@@ -0,0 +1,525 @@
+/*******************************************************************************
+   Filename: pebble.h
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Host-side stand-in for the Pebble SDK 3 header. Declares just
+             enough of the SDK for "src/space_merc.c" to be compiled and run on
+             a desktop machine, where the host tools rasterize sprites, replay
+             scripted input and benchmark the game logic. Build with either
+             -DPBL_COLOR (basalt) or -DPBL_BW (aplite).
+*******************************************************************************/
+
+#ifndef HOST_PEBBLE_H_
+#define HOST_PEBBLE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if !defined(PBL_COLOR) && !defined(PBL_BW)
+#define PBL_BW
+#endif
+#ifdef PBL_COLOR
+#define PBL_PLATFORM_BASALT
+#define PBL_PLATFORM_NAME                "basalt"
+#define HOST_APP_HEAP_SIZE               65536
+#else
+#define PBL_PLATFORM_APLITE
+#define PBL_PLATFORM_NAME                "aplite"
+#define HOST_APP_HEAP_SIZE               24576
+#endif
+#define PBL_RECT
+#define PBL_SDK_3
+
+/*******************************************************************************
+  Geometry
+*******************************************************************************/
+
+typedef struct GPoint {
+  int16_t x, y;
+} GPoint;
+
+typedef struct GSize {
+  int16_t w, h;
+} GSize;
+
+typedef struct GRect {
+  GPoint origin;
+  GSize size;
+} GRect;
+
+#define GPoint(x, y)                     ((GPoint) {(x), (y)})
+#define GSize(w, h)                      ((GSize) {(w), (h)})
+#define GRect(x, y, w, h)                ((GRect) {{(x), (y)}, {(w), (h)}})
+#define GPointZero                       GPoint(0, 0)
+#define GRectZero                        GRect(0, 0, 0, 0)
+
+bool gpoint_equal(const GPoint *const point_a, const GPoint *const point_b);
+bool grect_equal(const GRect *const rect_a, const GRect *const rect_b);
+
+typedef enum {
+  GCornerNone        = 0,
+  GCornerTopLeft     = 1 << 0,
+  GCornerTopRight    = 1 << 1,
+  GCornerBottomLeft  = 1 << 2,
+  GCornerBottomRight = 1 << 3,
+  GCornersAll        = 0x0F,
+  GCornersTop        = GCornerTopLeft | GCornerTopRight,
+  GCornersBottom     = GCornerBottomLeft | GCornerBottomRight,
+  GCornersLeft       = GCornerTopLeft | GCornerBottomLeft,
+  GCornersRight      = GCornerTopRight | GCornerBottomRight,
+} GCornerMask;
+
+#define TRIG_MAX_RATIO                   0xffff
+#define TRIG_MAX_ANGLE                   0x10000
+
+int32_t sin_lookup(int32_t angle);
+int32_t cos_lookup(int32_t angle);
+
+/*******************************************************************************
+  Colors
+*******************************************************************************/
+
+typedef union GColor8 {
+  uint8_t argb;
+  struct {
+    uint8_t b:2;
+    uint8_t g:2;
+    uint8_t r:2;
+    uint8_t a:2;
+  };
+} GColor8;
+
+typedef GColor8 GColor;
+
+#define GColorFromHEX(v)                 ((GColor8) {.argb = (uint8_t) (0xC0 | \
+                                           ((((v) >> 22) & 3) << 4) |          \
+                                           ((((v) >> 14) & 3) << 2) |          \
+                                           (((v) >> 6) & 3))})
+#define GColorFromRGB(r, g, b)           GColorFromHEX((((r) & 0xFF) << 16) |  \
+                                                       (((g) & 0xFF) << 8) |   \
+                                                       ((b) & 0xFF))
+#define gcolor_equal(a, b)               ((a).argb == (b).argb)
+
+#define GColorClear                      ((GColor8) {.argb = 0x00})
+#define GColorBlack                      GColorFromHEX(0x000000)
+#define GColorOxfordBlue                 GColorFromHEX(0x000055)
+#define GColorDukeBlue                   GColorFromHEX(0x0000AA)
+#define GColorBlue                       GColorFromHEX(0x0000FF)
+#define GColorDarkGreen                  GColorFromHEX(0x005500)
+#define GColorMidnightGreen              GColorFromHEX(0x005555)
+#define GColorCobaltBlue                 GColorFromHEX(0x0055AA)
+#define GColorBlueMoon                   GColorFromHEX(0x0055FF)
+#define GColorIslamicGreen               GColorFromHEX(0x00AA00)
+#define GColorJaegerGreen                GColorFromHEX(0x00AA55)
+#define GColorTiffanyBlue                GColorFromHEX(0x00AAAA)
+#define GColorVividCerulean              GColorFromHEX(0x00AAFF)
+#define GColorGreen                      GColorFromHEX(0x00FF00)
+#define GColorMalachite                  GColorFromHEX(0x00FF55)
+#define GColorMediumSpringGreen          GColorFromHEX(0x00FFAA)
+#define GColorCyan                       GColorFromHEX(0x00FFFF)
+#define GColorBulgarianRose              GColorFromHEX(0x550000)
+#define GColorImperialPurple             GColorFromHEX(0x550055)
+#define GColorIndigo                     GColorFromHEX(0x5500AA)
+#define GColorElectricUltramarine        GColorFromHEX(0x5500FF)
+#define GColorArmyGreen                  GColorFromHEX(0x555500)
+#define GColorDarkGray                   GColorFromHEX(0x555555)
+#define GColorLiberty                    GColorFromHEX(0x5555AA)
+#define GColorVeryLightBlue              GColorFromHEX(0x5555FF)
+#define GColorKellyGreen                 GColorFromHEX(0x55AA00)
+#define GColorMayGreen                   GColorFromHEX(0x55AA55)
+#define GColorCadetBlue                  GColorFromHEX(0x55AAAA)
+#define GColorPictonBlue                 GColorFromHEX(0x55AAFF)
+#define GColorBrightGreen                GColorFromHEX(0x55FF00)
+#define GColorScreaminGreen              GColorFromHEX(0x55FF55)
+#define GColorMediumAquamarine           GColorFromHEX(0x55FFAA)
+#define GColorElectricBlue               GColorFromHEX(0x55FFFF)
+#define GColorDarkCandyAppleRed          GColorFromHEX(0xAA0000)
+#define GColorJazzberryJam               GColorFromHEX(0xAA0055)
+#define GColorPurple                     GColorFromHEX(0xAA00AA)
+#define GColorVividViolet                GColorFromHEX(0xAA00FF)
+#define GColorWindsorTan                 GColorFromHEX(0xAA5500)
+#define GColorRoseVale                   GColorFromHEX(0xAA5555)
+#define GColorPurpureus                  GColorFromHEX(0xAA55AA)
+#define GColorLavenderIndigo             GColorFromHEX(0xAA55FF)
+#define GColorLimerick                   GColorFromHEX(0xAAAA00)
+#define GColorBrass                      GColorFromHEX(0xAAAA55)
+#define GColorLightGray                  GColorFromHEX(0xAAAAAA)
+#define GColorBabyBlueEyes               GColorFromHEX(0xAAAAFF)
+#define GColorSpringBud                  GColorFromHEX(0xAAFF00)
+#define GColorInchworm                   GColorFromHEX(0xAAFF55)
+#define GColorMintGreen                  GColorFromHEX(0xAAFFAA)
+#define GColorCeleste                    GColorFromHEX(0xAAFFFF)
+#define GColorRed                        GColorFromHEX(0xFF0000)
+#define GColorFolly                      GColorFromHEX(0xFF0055)
+#define GColorFashionMagenta             GColorFromHEX(0xFF00AA)
+#define GColorMagenta                    GColorFromHEX(0xFF00FF)
+#define GColorOrange                     GColorFromHEX(0xFF5500)
+#define GColorSunsetOrange               GColorFromHEX(0xFF5555)
+#define GColorBrilliantRose              GColorFromHEX(0xFF55AA)
+#define GColorShockingPink               GColorFromHEX(0xFF55FF)
+#define GColorChromeYellow               GColorFromHEX(0xFFAA00)
+#define GColorRajah                      GColorFromHEX(0xFFAA55)
+#define GColorMelon                      GColorFromHEX(0xFFAAAA)
+#define GColorRichBrilliantLavender      GColorFromHEX(0xFFAAFF)
+#define GColorYellow                     GColorFromHEX(0xFFFF00)
+#define GColorIcterine                   GColorFromHEX(0xFFFF55)
+#define GColorPastelYellow               GColorFromHEX(0xFFFFAA)
+#define GColorWhite                      GColorFromHEX(0xFFFFFF)
+
+/*******************************************************************************
+  Bitmaps and graphics contexts
+*******************************************************************************/
+
+typedef enum GBitmapFormat {
+  GBitmapFormat1Bit = 0,
+  GBitmapFormat8Bit,
+  GBitmapFormat1BitPalette,
+  GBitmapFormat2BitPalette,
+  GBitmapFormat4BitPalette,
+} GBitmapFormat;
+
+typedef enum {
+  GCompOpAssign,
+  GCompOpAssignInverted,
+  GCompOpOr,
+  GCompOpAnd,
+  GCompOpClear,
+  GCompOpSet,
+} GCompOp;
+
+typedef struct GBitmap {
+  uint8_t *addr;
+  uint16_t row_size_bytes;
+  GBitmapFormat format;
+  GRect bounds;
+  bool owns_data;
+} GBitmap;
+
+typedef struct GContext {
+  GBitmap *frame_buffer;
+  GColor stroke_color,
+         fill_color;
+  GCompOp compositing_mode;
+  bool frame_buffer_captured;
+} GContext;
+
+GBitmap *gbitmap_create_blank(GSize size, GBitmapFormat format);
+GBitmap *gbitmap_create_with_resource(uint32_t resource_id);
+GBitmap *gbitmap_create_as_sub_bitmap(const GBitmap *base_bitmap,
+                                      GRect sub_rect);
+void gbitmap_destroy(GBitmap *bitmap);
+uint8_t *gbitmap_get_data(const GBitmap *bitmap);
+uint16_t gbitmap_get_bytes_per_row(const GBitmap *bitmap);
+GBitmapFormat gbitmap_get_format(const GBitmap *bitmap);
+GRect gbitmap_get_bounds(const GBitmap *bitmap);
+
+void graphics_context_set_stroke_color(GContext *ctx, GColor color);
+void graphics_context_set_fill_color(GContext *ctx, GColor color);
+void graphics_context_set_compositing_mode(GContext *ctx, GCompOp mode);
+void graphics_draw_pixel(GContext *ctx, GPoint point);
+void graphics_draw_line(GContext *ctx, GPoint p0, GPoint p1);
+void graphics_fill_rect(GContext *ctx,
+                        GRect rect,
+                        uint16_t corner_radius,
+                        GCornerMask corner_mask);
+void graphics_fill_circle(GContext *ctx, GPoint p, uint16_t radius);
+void graphics_draw_circle(GContext *ctx, GPoint p, uint16_t radius);
+void graphics_draw_bitmap_in_rect(GContext *ctx,
+                                  const GBitmap *bitmap,
+                                  GRect rect);
+GBitmap *graphics_capture_frame_buffer(GContext *ctx);
+bool graphics_release_frame_buffer(GContext *ctx, GBitmap *buffer);
+
+typedef struct GPathInfo {
+  uint32_t num_points;
+  GPoint *points;
+} GPathInfo;
+
+typedef struct GPath {
+  uint32_t num_points;
+  GPoint *points;
+  int32_t rotation;
+  GPoint offset;
+} GPath;
+
+GPath *gpath_create(const GPathInfo *init);
+void gpath_destroy(GPath *path);
+void gpath_rotate_to(GPath *path, int32_t angle);
+void gpath_move_to(GPath *path, GPoint point);
+void gpath_draw_filled(GContext *ctx, GPath *path);
+void gpath_draw_outline(GContext *ctx, GPath *path);
+
+/*******************************************************************************
+  Windows, layers and menus
+*******************************************************************************/
+
+typedef struct Layer Layer;
+typedef void (*LayerUpdateProc)(Layer *layer, GContext *ctx);
+
+struct Layer {
+  GRect frame;
+  LayerUpdateProc update_proc;
+  Layer *first_child,
+        *next_sibling;
+  bool dirty;
+};
+
+typedef struct Window Window;
+typedef void (*WindowHandler)(Window *window);
+typedef struct WindowHandlers {
+  WindowHandler load,
+                appear,
+                disappear,
+                unload;
+} WindowHandlers;
+
+typedef enum {
+  BUTTON_ID_BACK,
+  BUTTON_ID_UP,
+  BUTTON_ID_SELECT,
+  BUTTON_ID_DOWN,
+  NUM_BUTTONS
+} ButtonId;
+
+typedef struct HostClickRecognizer *ClickRecognizerRef;
+typedef void (*ClickHandler)(ClickRecognizerRef recognizer, void *context);
+typedef void (*ClickConfigProvider)(void *context);
+
+struct Window {
+  Layer root_layer;
+  GColor background_color;
+  WindowHandlers handlers;
+  ClickConfigProvider click_config_provider;
+  ClickHandler single_click_handlers[NUM_BUTTONS],
+               multi_click_handlers[NUM_BUTTONS];
+  uint16_t repeat_intervals[NUM_BUTTONS];
+};
+
+Window *window_create(void);
+void window_destroy(Window *window);
+Layer *window_get_root_layer(const Window *window);
+void window_set_background_color(Window *window, GColor background_color);
+void window_set_window_handlers(Window *window, WindowHandlers handlers);
+void window_set_click_config_provider(Window *window,
+                                      ClickConfigProvider click_config_provider);
+void window_single_click_subscribe(ButtonId button_id, ClickHandler handler);
+void window_single_repeating_click_subscribe(ButtonId button_id,
+                                             uint16_t repeat_interval_ms,
+                                             ClickHandler handler);
+void window_multi_click_subscribe(ButtonId button_id,
+                                  uint8_t min_clicks,
+                                  uint8_t max_clicks,
+                                  uint16_t timeout,
+                                  bool last_click_only,
+                                  ClickHandler handler);
+uint8_t click_number_of_clicks_counted(ClickRecognizerRef recognizer);
+ButtonId click_recognizer_get_button_id(ClickRecognizerRef recognizer);
+void window_stack_push(Window *window, bool animated);
+Window *window_stack_pop(bool animated);
+void window_stack_pop_all(const bool animated);
+bool window_stack_contains_window(Window *window);
+Window *window_stack_get_top_window(void);
+
+Layer *layer_create(GRect frame);
+void layer_destroy(Layer *layer);
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc);
+void layer_mark_dirty(Layer *layer);
+void layer_add_child(Layer *parent, Layer *child);
+GRect layer_get_bounds(const Layer *layer);
+GRect layer_get_frame(const Layer *layer);
+
+typedef struct GFont *GFont;
+#define FONT_KEY_GOTHIC_24_BOLD          "RESOURCE_ID_GOTHIC_24_BOLD"
+GFont fonts_get_system_font(const char *font_key);
+
+typedef enum {
+  GTextAlignmentLeft,
+  GTextAlignmentCenter,
+  GTextAlignmentRight,
+} GTextAlignment;
+
+typedef struct TextLayer {
+  Layer layer;
+  const char *text;
+} TextLayer;
+
+TextLayer *text_layer_create(GRect frame);
+void text_layer_destroy(TextLayer *text_layer);
+Layer *text_layer_get_layer(TextLayer *text_layer);
+void text_layer_set_text(TextLayer *text_layer, const char *text);
+void text_layer_set_background_color(TextLayer *text_layer, GColor color);
+void text_layer_set_text_color(TextLayer *text_layer, GColor color);
+void text_layer_set_font(TextLayer *text_layer, GFont font);
+void text_layer_set_text_alignment(TextLayer *text_layer,
+                                   GTextAlignment text_alignment);
+
+typedef struct StatusBarLayer {
+  Layer layer;
+} StatusBarLayer;
+
+StatusBarLayer *status_bar_layer_create(void);
+void status_bar_layer_destroy(StatusBarLayer *status_bar_layer);
+Layer *status_bar_layer_get_layer(StatusBarLayer *status_bar_layer);
+
+typedef struct MenuIndex {
+  uint16_t section,
+           row;
+} MenuIndex;
+
+typedef enum {
+  MenuRowAlignNone,
+  MenuRowAlignCenter,
+  MenuRowAlignTop,
+  MenuRowAlignBottom,
+} MenuRowAlign;
+
+typedef struct MenuLayer MenuLayer;
+typedef uint16_t (*MenuLayerGetNumberOfRowsInSectionsCallback)(
+  MenuLayer *menu_layer, uint16_t section_index, void *callback_context);
+typedef int16_t (*MenuLayerGetHeaderHeightCallback)(
+  MenuLayer *menu_layer, uint16_t section_index, void *callback_context);
+typedef void (*MenuLayerDrawRowCallback)(GContext *ctx,
+                                         const Layer *cell_layer,
+                                         MenuIndex *cell_index,
+                                         void *callback_context);
+typedef void (*MenuLayerDrawHeaderCallback)(GContext *ctx,
+                                            const Layer *cell_layer,
+                                            uint16_t section_index,
+                                            void *callback_context);
+typedef void (*MenuLayerSelectCallback)(MenuLayer *menu_layer,
+                                        MenuIndex *cell_index,
+                                        void *callback_context);
+typedef struct MenuLayerCallbacks {
+  MenuLayerGetNumberOfRowsInSectionsCallback get_num_rows;
+  MenuLayerGetHeaderHeightCallback get_header_height;
+  MenuLayerDrawRowCallback draw_row;
+  MenuLayerDrawHeaderCallback draw_header;
+  MenuLayerSelectCallback select_click;
+} MenuLayerCallbacks;
+
+struct MenuLayer {
+  Layer layer;
+  MenuLayerCallbacks callbacks;
+  MenuIndex selected_index;
+};
+
+#define MENU_CELL_BASIC_HEADER_HEIGHT    16
+
+MenuLayer *menu_layer_create(GRect frame);
+void menu_layer_destroy(MenuLayer *menu_layer);
+Layer *menu_layer_get_layer(const MenuLayer *menu_layer);
+void menu_layer_set_callbacks(MenuLayer *menu_layer,
+                              void *callback_context,
+                              MenuLayerCallbacks callbacks);
+void menu_layer_set_click_config_onto_window(MenuLayer *menu_layer,
+                                             Window *window);
+void menu_layer_reload_data(MenuLayer *menu_layer);
+void menu_layer_set_selected_index(MenuLayer *menu_layer,
+                                   MenuIndex index,
+                                   MenuRowAlign scroll_align,
+                                   bool animated);
+void menu_cell_basic_draw(GContext *ctx,
+                          const Layer *cell_layer,
+                          const char *title,
+                          const char *subtitle,
+                          GBitmap *icon);
+void menu_cell_basic_header_draw(GContext *ctx,
+                                 const Layer *cell_layer,
+                                 const char *title);
+
+/*******************************************************************************
+  Services
+*******************************************************************************/
+
+typedef enum {
+  SECOND_UNIT = 1 << 0,
+  MINUTE_UNIT = 1 << 1,
+  HOUR_UNIT   = 1 << 2,
+  DAY_UNIT    = 1 << 3,
+} TimeUnits;
+
+typedef void (*TickHandler)(struct tm *tick_time, TimeUnits units_changed);
+typedef void (*AppFocusHandler)(bool in_focus);
+typedef void (*AppTimerCallback)(void *data);
+typedef struct AppTimer AppTimer;
+
+typedef struct BatteryChargeState {
+  uint8_t charge_percent;
+  bool is_charging,
+       is_plugged;
+} BatteryChargeState;
+
+void tick_timer_service_subscribe(TimeUnits tick_units, TickHandler handler);
+void tick_timer_service_unsubscribe(void);
+void app_focus_service_subscribe(AppFocusHandler handler);
+void app_focus_service_unsubscribe(void);
+BatteryChargeState battery_state_service_peek(void);
+AppTimer *app_timer_register(uint32_t timeout_ms,
+                             AppTimerCallback callback,
+                             void *callback_data);
+bool app_timer_reschedule(AppTimer *timer_handle, uint32_t new_timeout_ms);
+void app_timer_cancel(AppTimer *timer_handle);
+void app_event_loop(void);
+void light_enable_interaction(void);
+void vibes_short_pulse(void);
+uint16_t time_ms(time_t *tloc, uint16_t *out_ms);
+size_t heap_bytes_free(void);
+size_t heap_bytes_used(void);
+
+typedef int32_t status_t;
+#define S_SUCCESS                        0
+#define E_ERROR                          (-1)
+#define E_DOES_NOT_EXIST                 (-4)
+#define PERSIST_DATA_MAX_LENGTH          256
+
+bool persist_exists(const uint32_t key);
+int persist_get_size(const uint32_t key);
+int32_t persist_read_int(const uint32_t key);
+status_t persist_write_int(const uint32_t key, const int32_t value);
+int persist_read_data(const uint32_t key,
+                      void *buffer,
+                      const size_t buffer_size);
+int persist_write_data(const uint32_t key,
+                       const void *data,
+                       const size_t size);
+status_t persist_delete(const uint32_t key);
+
+// Resource IDs, in the order they are listed in "appinfo.json":
+#define RESOURCE_ID_SPRITE_STRIP_0       1  // One per sprite type and depth.
+#define RESOURCE_ID_MISSION_SCRIPT_0     (RESOURCE_ID_SPRITE_STRIP_0 +         \
+                                          NUM_SPRITE_TYPES *                   \
+                                          (MAX_VISIBILITY_DEPTH - 1))
+
+typedef struct HostResource *ResHandle;
+ResHandle resource_get_handle(uint32_t resource_id);
+size_t resource_size(ResHandle handle);
+size_t resource_load(ResHandle handle, uint8_t *buffer, size_t max_length);
+size_t resource_load_byte_range(ResHandle handle,
+                                uint32_t start_offset,
+                                uint8_t *buffer,
+                                size_t num_bytes);
+
+typedef enum {
+  APP_LOG_LEVEL_ERROR = 1,
+  APP_LOG_LEVEL_WARNING = 50,
+  APP_LOG_LEVEL_INFO = 100,
+  APP_LOG_LEVEL_DEBUG = 200,
+} AppLogLevel;
+
+void app_log(uint8_t log_level,
+             const char *src_filename,
+             int src_line_number,
+             const char *fmt,
+             ...);
+#define APP_LOG(level, fmt, args...)     app_log(level, __FILE__, __LINE__,    \
+                                                 fmt, ## args)
+
+#include "host_shim.h"
+
+#endif  // HOST_PEBBLE_H_
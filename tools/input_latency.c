@@ -0,0 +1,266 @@
+/*******************************************************************************
+   Filename: input_latency.c
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Host replay that measures SpaceMerc's input-to-photon latency.
+             Bursts of button presses are replayed against a seeded mission on
+             the host SDK stand-in, whose display is modeled as taking a fixed
+             time per frame. Each input's latency runs from its press to the
+             end of the first frame drawn after it left the input queue.
+             Inputs coalesced away (see "queue_input") aren't timed, but are
+             counted. Frames shown from views rendered ahead of time (see
+             "speculate", color platforms only) are modeled as taking a
+             shorter, fixed time, while speculative frames take as long as
+             any other rendered frame.
+             Forward presses that would walk the player out through the
+             entrance are skipped; should the player leave anyway, the replay
+             ends early and says so.
+
+      Usage: input_latency [<seed> [<frame duration (ms)>
+                                    [<view frame duration (ms)>]]]
+
+             Build with, e.g.:
+             cc -DPBL_COLOR -Itools/host -Isrc tools/input_latency.c \
+               tools/host/host_shim.c -lz -lm
+*******************************************************************************/
+
+#include "pebble.h"
+#include "host_shim.h"
+
+#define main space_merc_main
+#include "space_merc.c"
+#undef main
+
+#define DEFAULT_SEED                     1
+#define DEFAULT_FRAME_DURATION           40  // milliseconds
+#define DEFAULT_VIEW_FRAME_DURATION      8  // milliseconds
+#define NUM_BURSTS                       40
+#define MAX_BURST_PRESSES                6
+#define BURST_PRESS_INTERVAL             15  // milliseconds
+#define BURST_GAP                        600  // milliseconds
+#define MAX_PENDING_PRESSES              (MAX_QUEUED_INPUTS + 1)
+#define MAX_MENU_PRESSES                 10
+
+static uint32_t s_pending_press_times[MAX_PENDING_PRESSES],
+                s_batch_press_times[MAX_PENDING_PRESSES];
+static int s_num_pending_presses,
+           s_num_batch_presses;
+static uint32_t s_frame_end,  // When the frame being displayed is complete.
+                s_total_latency,
+                s_max_latency,
+                s_num_timed,
+                s_num_coalesced,
+                s_num_frames,
+                s_num_view_frames,
+                s_num_speculative_frames,
+                s_num_batches,
+                s_num_skipped;
+
+/*******************************************************************************
+   Function: press
+
+Description: Presses a button of the graphics window and keeps track of which
+             queued input it became, if any. A forward press is skipped while
+             the player stands at the entrance facing out, since it would end
+             the mission.
+
+     Inputs: button_id  - The button to press.
+             click_type - "HOST_SINGLE_CLICK" or "HOST_DOUBLE_CLICK".
+
+    Outputs: None.
+*******************************************************************************/
+static void press(const ButtonId button_id, const int8_t click_type) {
+  const int8_t num_queued = g_num_queued_inputs;
+
+  if (g_mission == NULL) {
+    return;  // See "step".
+  }
+  if (button_id == BUTTON_ID_UP                               &&
+      click_type == HOST_SINGLE_CLICK                         &&
+      gpoint_equal(&g_player->position, &g_mission->entrance) &&
+      g_player->direction == g_mission->entrance_direction) {
+    s_num_skipped++;
+
+    return;
+  }
+  host_press_button(button_id, click_type);
+  if (g_num_queued_inputs > num_queued) {
+    s_pending_press_times[s_num_pending_presses++] = host_now_ms();
+  } else {
+    s_num_coalesced++;
+    if (g_num_queued_inputs < num_queued) {  // Cancelled a queued turn.
+      s_num_pending_presses--;
+      s_num_coalesced++;
+    }
+  }
+}
+
+/*******************************************************************************
+   Function: step
+
+Description: Advances the virtual clock by a millisecond. Inputs that have left
+             the queue join the next frame, which starts as soon as the display
+             is free; once a frame is complete, its inputs are on screen.
+
+     Inputs: frame_duration      - Modeled time per rendered frame, in
+                                   milliseconds.
+             view_frame_duration - Modeled time per frame shown from a view,
+                                   in milliseconds.
+
+    Outputs: None.
+*******************************************************************************/
+static void step(const uint32_t frame_duration,
+                 const uint32_t view_frame_duration) {
+#ifdef SPECULATIVE_VIEWS
+  uint32_t signature;
+#endif
+  uint32_t latency;
+  int i, num_processed;
+  bool speculative = false, from_view = false;
+
+  if (g_mission == NULL) {
+    return;  // The player walked out, ending the replay.
+  }
+#ifdef SPECULATIVE_VIEWS
+  signature = get_scene_signature(g_player->position, g_player->direction);
+#endif
+  host_advance_ms(1);
+  num_processed = s_num_pending_presses - g_num_queued_inputs;
+  if (num_processed > 0) {
+    s_num_batches++;
+  }
+  for (i = 0; i < num_processed; ++i) {
+    s_batch_press_times[s_num_batch_presses++] = s_pending_press_times[i];
+  }
+  s_num_pending_presses -= num_processed;
+  memmove(s_pending_press_times,
+          s_pending_press_times + num_processed,
+          s_num_pending_presses * sizeof(uint32_t));
+  if (host_now_ms() < s_frame_end) {
+    return;  // Still displaying the previous frame.
+  }
+
+#ifdef SPECULATIVE_VIEWS
+  // Tell the kinds of frame apart as "draw_scene" does:
+  speculative = g_speculation_pending                 &&
+                signature == g_displayed_signature    &&
+                !g_input_batch_pending;
+  from_view = !speculative                            &&
+              g_player_animation_mode == 0            &&
+              get_view(signature) != NULL;
+#endif
+  if (!host_render()) {
+    return;
+  }
+  s_num_frames++;
+  if (speculative) {
+    s_num_speculative_frames++;
+    s_frame_end = host_now_ms() + frame_duration;
+
+    return;  // Nothing new on screen.
+  }
+  if (from_view) {
+    s_num_view_frames++;
+  }
+  s_frame_end = host_now_ms() +
+                (from_view ? view_frame_duration : frame_duration);
+  for (i = 0; i < s_num_batch_presses; ++i) {
+    latency = s_frame_end - s_batch_press_times[i];
+    s_total_latency += latency;
+    s_num_timed++;
+    if (latency > s_max_latency) {
+      s_max_latency = latency;
+    }
+  }
+  s_num_batch_presses = 0;
+}
+
+/*******************************************************************************
+   Function: main
+
+Description: Starts a seeded mission, replays bursts of presses (forward steps,
+             shots, turns and mixtures of these) and reports the latencies,
+             along with how many bursts were replayed before any early end.
+
+     Inputs: argc - No. of command-line arguments.
+             argv - Command-line arguments.
+
+    Outputs: Zero on success, one on failure.
+*******************************************************************************/
+int main(int argc, char **argv) {
+  const int seed = argc > 1 ? atoi(argv[1]) : DEFAULT_SEED;
+  const uint32_t frame_duration = argc > 2 ? atoi(argv[2]) :
+                                             DEFAULT_FRAME_DURATION,
+                 view_frame_duration = argc > 3 ? atoi(argv[3]) :
+                                                  DEFAULT_VIEW_FRAME_DURATION;
+  int burst, i, num_presses, pattern;
+  uint32_t ms;
+
+  host_reset();
+  host_set_log_enabled(false);
+  init();
+  srand(seed);
+  for (i = 0;
+       i < MAX_MENU_PRESSES &&
+         window_stack_get_top_window() != g_graphics_window;
+       ++i) {
+    host_press_button(BUTTON_ID_SELECT, HOST_SINGLE_CLICK);  // Intro, etc.
+  }
+  if (window_stack_get_top_window() != g_graphics_window) {
+    fprintf(stderr, "Failed to start a mission.\n");
+
+    return 1;
+  }
+  g_player->stats[MAX_HP] = g_player->stats[CURRENT_HP] = MAX_SMALL_INT_VALUE;
+  for (burst = 0; burst < NUM_BURSTS && g_mission != NULL; ++burst) {
+    num_presses = rand() % MAX_BURST_PRESSES + 1;
+    pattern = rand() % 4;
+    for (i = 0; i < num_presses; ++i) {
+      switch (pattern) {
+        case 0:  // Running forward.
+          press(BUTTON_ID_UP, HOST_SINGLE_CLICK);
+          break;
+        case 1:  // Rapid fire.
+          press(BUTTON_ID_SELECT, HOST_SINGLE_CLICK);
+          break;
+        case 2:  // Strafing fire.
+          press(i % 2 ? BUTTON_ID_SELECT : BUTTON_ID_UP, HOST_SINGLE_CLICK);
+          break;
+        default:  // Looking around.
+          press(rand() % 2 ? BUTTON_ID_UP : BUTTON_ID_DOWN, HOST_DOUBLE_CLICK);
+          break;
+      }
+      g_player->stats[CURRENT_ENERGY] = g_player->stats[MAX_ENERGY];
+      for (ms = 0; ms < BURST_PRESS_INTERVAL; ++ms) {
+        step(frame_duration, view_frame_duration);
+      }
+    }
+    for (ms = 0; ms < BURST_GAP; ++ms) {
+      step(frame_duration, view_frame_duration);
+    }
+  }
+
+  printf("Frame duration: %lu ms (%lu ms from a view)\n",
+         (unsigned long) frame_duration,
+         (unsigned long) view_frame_duration);
+  printf("Bursts replayed: %d of %d%s\n",
+         burst,
+         NUM_BURSTS,
+         g_mission == NULL ? " (the player left the mission)" : "");
+  printf("Forward presses skipped at the entrance: %lu\n",
+         (unsigned long) s_num_skipped);
+  printf("Inputs timed: %lu (%lu coalesced)\n",
+         (unsigned long) s_num_timed,
+         (unsigned long) s_num_coalesced);
+  printf("Input batches: %lu\n", (unsigned long) s_num_batches);
+  printf("Frames drawn: %lu (%lu from views, %lu speculative)\n",
+         (unsigned long) s_num_frames,
+         (unsigned long) s_num_view_frames,
+         (unsigned long) s_num_speculative_frames);
+  printf("Latency: mean %lu ms, max %lu ms\n",
+         (unsigned long) (s_num_timed ? s_total_latency / s_num_timed : 0),
+         (unsigned long) s_max_latency);
+
+  return 0;
+}
@@ -0,0 +1,161 @@
+# Filename: instruction_counts.py
+#
+# Author: David C. Drake (https://davidcdrake.com)
+#
+# Description: Counts the instructions SpaceMerc executes on the SDK's emulator,
+#              per call to "draw_scene", "tick_handler" and the input handlers,
+#              for judging optimizations by target costs (soft-float, firmware
+#              drawing calls, etc.) rather than host timings. Runs inside the
+#              SDK's GDB, attached to the emulator: the app's benchmark scene
+#              (a build with "INSTRUCTION_COUNTS" defined) is armed, and each
+#              call to a counted function is single-stepped to its return,
+#              every instruction attributed to the function (app or firmware)
+#              it belongs to. The totals, with those breakdowns, are written
+#              as JSON.
+#
+#       Usage: INSTRUCTION_COUNTS=1 pebble build
+#              pebble install --emulator <aplite|basalt>
+#              pebble gdb --emulator <aplite|basalt>
+#              (gdb) source tools/instruction_counts.py
+#              (gdb) count-instructions <output file> [<function> ...]
+#
+#              Stepping goes through GDB's remote protocol one instruction at
+#              a time, so a scene takes several minutes. QEMU's single-step
+#              mode masks interrupts and timers, so they aren't counted.
+
+import collections
+import json
+
+import gdb
+
+COUNTED_FUNCTIONS = [
+  'draw_scene',
+  'tick_handler',
+  'input_timer_callback',
+  'player_timer_callback',
+  'animation_timer_callback',
+  'speculation_timer_callback',
+  'graphics_up_single_repeating_click',
+  'graphics_up_multi_click',
+  'graphics_down_single_repeating_click',
+  'graphics_down_multi_click',
+  'graphics_select_single_repeating_click',
+]
+FINISHED_FUNCTION = 'benchmark_scene_finished'
+ARMED_VARIABLE = 'g_benchmark_armed'
+FIRMWARE = '(firmware)'
+MAX_STEPS_PER_CALL = 50000000
+
+
+def register(name):
+  return int(gdb.parse_and_eval('(unsigned long) $' + name)) & 0xFFFFFFFF
+
+
+def function_address(name):
+  return int(gdb.parse_and_eval('(unsigned long) &' + name)) & ~1
+
+
+class CountInstructions(gdb.Command):
+  """count-instructions <output file> [<function> ...]
+
+Arms SpaceMerc's benchmark scene, counts the instructions executed by each
+call to the given functions (by default, the scene drawing, tick and input
+handlers) until the scene is over and writes per-function totals as JSON."""
+
+  def __init__(self):
+    super(CountInstructions, self).__init__('count-instructions',
+                                            gdb.COMMAND_USER)
+    self.function_names = {}  # By instruction address.
+
+  def get_function_name(self, pc):
+    # Names the function containing an instruction, caching by address.
+    if pc not in self.function_names:
+      try:
+        block = gdb.block_for_pc(pc)
+      except RuntimeError:  # No symbols at all there.
+        block = None
+      while block is not None and block.function is None:
+        block = block.superblock
+      self.function_names[pc] = (block.function.name if block is not None
+                                 else FIRMWARE)
+    return self.function_names[pc]
+
+  def count_call(self, breakdown):
+    # Steps from a counted function's first instruction to its return,
+    # adding each instruction to "breakdown". Returns the total.
+    return_address = register('lr') & ~1
+    entry_sp = register('sp')
+    pc = register('pc')
+    steps = 0
+    while steps < MAX_STEPS_PER_CALL:
+      name = self.get_function_name(pc)
+      gdb.execute('stepi', to_string=True)
+      steps += 1
+      breakdown[name] = breakdown.get(name, 0) + 1
+      pc = register('pc')
+      if pc == return_address and register('sp') >= entry_sp:
+        return steps
+    raise gdb.GdbError('No return after {} steps.'.format(steps))
+
+  def invoke(self, argument, from_tty):
+    arguments = gdb.string_to_argv(argument)
+    if not arguments:
+      raise gdb.GdbError('Usage: count-instructions <output file> '
+                         '[<function> ...]')
+    path, names = arguments[0], arguments[1:] or COUNTED_FUNCTIONS
+    gdb.execute('set pagination off')
+    entries = {}
+    for name in names:
+      try:
+        entries[function_address(name)] = name
+      except gdb.error:
+        gdb.write('Skipping "{}": not in this build.\n'.format(name))
+    breakpoints = [gdb.Breakpoint('*{:#x}'.format(address), internal=True)
+                   for address in entries]
+    finished = gdb.Breakpoint('*{:#x}'.format(
+                                function_address(FINISHED_FUNCTION)),
+                              internal=True)
+    totals = {name: {'calls': 0, 'instructions': 0, 'max': 0,
+                     'breakdown': {}} for name in entries.values()}
+    try:
+      gdb.execute('set var {} = 1'.format(ARMED_VARIABLE))
+      while True:
+        gdb.execute('continue', to_string=True)
+        pc = register('pc')
+        if pc not in entries:
+          break  # The scene's over.
+        total = totals[entries[pc]]
+        for breakpoint in breakpoints:  # Nested calls count toward this one.
+          breakpoint.enabled = False
+        count = self.count_call(total['breakdown'])
+        for breakpoint in breakpoints:
+          breakpoint.enabled = True
+        total['calls'] += 1
+        total['instructions'] += count
+        total['max'] = max(total['max'], count)
+    finally:
+      for breakpoint in breakpoints + [finished]:
+        breakpoint.delete()
+    results = []
+    for name in names:
+      if name not in totals:
+        continue
+      total = totals[name]
+      results.append({
+        'name': name,
+        'calls': total['calls'],
+        'instructions': total['instructions'],
+        'mean': (total['instructions'] // total['calls'] if total['calls']
+                 else 0),
+        'max': total['max'],
+        'breakdown': collections.OrderedDict(
+          sorted(total['breakdown'].items(), key=lambda item: -item[1])),
+      })
+      gdb.write('{:40} calls {:6} mean {:10} max {:10}\n'.format(
+        name, total['calls'], results[-1]['mean'], total['max']))
+    with open(path, 'w') as output:
+      json.dump({'results': results}, output, indent=2)
+      output.write('\n')
+
+
+CountInstructions()
@@ -0,0 +1,320 @@
+/*******************************************************************************
+   Filename: micro_benchmarks.c
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Host micro-benchmarks for SpaceMerc's core game-logic primitives.
+             Each primitive is timed over inputs drawn from a set of seeded
+             missions, at every NPC density from none to
+             "MAX_NPCS_AT_ONE_TIME", and the per-call costs are written to
+             standard output as JSON. Primitives that change the mission
+             (shooting, damage, NPC behavior) run in short batches, with the
+             mission restored between batches outside the timed region.
+             Drawing the view slots is timed too, through the generic
+             routines or, built with "VIEW_SLOT_ROUTINES" defined, the
+             generated ones (see "tools/view_slot_routines.c"), as the JSON
+             notes; the build reports their code size on the watch.
+
+      Usage: micro_benchmarks [<seed>]
+
+             Build with, e.g.:
+             cc -O2 -DPBL_COLOR -Itools/host -Isrc tools/micro_benchmarks.c \
+               tools/host/host_shim.c -lz -lm
+             or, after generating "src/view_slot_routines.h":
+             cc -O2 -DPBL_COLOR -DVIEW_SLOT_ROUTINES -Itools/host -Isrc \
+               tools/micro_benchmarks.c tools/host/host_shim.c -lz -lm
+*******************************************************************************/
+
+#include <time.h>
+
+#include "pebble.h"
+#include "host_shim.h"
+
+#define main space_merc_main
+#include "space_merc.c"
+#undef main
+
+#define DEFAULT_SEED                     1
+#define NUM_MISSIONS                     8  // Per NPC density.
+#define NUM_INPUT_CELLS                  256  // Per mission.
+#define CALLS_PER_MISSION                20000
+#define MUTATING_BATCH_SIZE              16  // Calls between restores.
+#define MAX_MENU_PRESSES                 10
+#define NANOSECONDS_PER_SECOND           1000000000LL
+
+typedef void (*benchmark_fn)(const int32_t i);
+
+typedef struct Benchmark {
+  const char *name;
+  benchmark_fn function;
+  bool mutating;  // Changes the mission, so must be run in batches.
+} benchmark_t;
+
+static GPoint s_input_cells[NUM_INPUT_CELLS],
+              s_open_cells[NUM_INPUT_CELLS];  // Occupiable cells only.
+static int32_t s_num_open_cells;
+static volatile int32_t s_sink;  // Keeps results from being optimized away.
+static mission_t s_saved_mission;
+static mission_history_t s_saved_history;
+static player_t s_saved_player;
+
+/*******************************************************************************
+  Benchmarked calls, one per primitive
+*******************************************************************************/
+
+static void bench_occupiable(const int32_t i) {
+  s_sink += occupiable(s_input_cells[i % NUM_INPUT_CELLS]);
+}
+
+static void bench_get_cell_type(const int32_t i) {
+  s_sink += get_cell_type(s_input_cells[i % NUM_INPUT_CELLS]);
+}
+
+static void bench_get_npc_at(const int32_t i) {
+  s_sink += get_npc_at(s_input_cells[i % NUM_INPUT_CELLS]) != NULL;
+}
+
+static void bench_get_pursuit_direction(const int32_t i) {
+  s_sink += get_pursuit_direction(s_open_cells[i % s_num_open_cells],
+                                  g_player->position);
+}
+
+static void bench_get_npc_spawn_point(const int32_t i) {
+  g_player->position = s_open_cells[i % s_num_open_cells];
+  s_sink += get_npc_spawn_point().x;
+}
+
+static void bench_update_blackboard(const int32_t i) {
+  update_blackboard();
+  s_sink += g_blackboard.claimed_sides;
+}
+
+static void bench_determine_npc_behavior(const int32_t i) {
+  npc_t *npc = &g_mission->npcs[i % MAX_NPCS_AT_ONE_TIME];
+
+  if (npc->type != NONE) {
+    determine_npc_behavior(npc);
+  }
+  s_sink += npc->position.x;
+}
+
+static void bench_damage_cell(const int32_t i) {
+  damage_cell(s_input_cells[i % NUM_INPUT_CELLS], 1);
+}
+
+static void bench_fire_player_laser(const int32_t i) {
+  g_player->stats[CURRENT_ENERGY] = g_player->stats[MAX_ENERGY];
+  set_player_direction(i % NUM_DIRECTIONS);
+  fire_player_laser();
+}
+
+static void bench_draw_view_slots(const int32_t i) {
+  g_player->position = s_open_cells[i % s_num_open_cells];
+  g_player->direction = i % NUM_DIRECTIONS;
+  draw_view_slots(host_graphics_context());
+  s_sink += g_view_slot_order;
+}
+
+static const benchmark_t s_benchmarks[] = {
+  {"occupiable", bench_occupiable, false},
+  {"get_cell_type", bench_get_cell_type, false},
+  {"get_npc_at", bench_get_npc_at, false},
+  {"get_pursuit_direction", bench_get_pursuit_direction, false},
+  {"get_npc_spawn_point", bench_get_npc_spawn_point, false},
+  {"update_blackboard", bench_update_blackboard, false},
+  {"determine_npc_behavior", bench_determine_npc_behavior, true},
+  {"damage_cell", bench_damage_cell, true},
+  {"fire_player_laser", bench_fire_player_laser, true},
+  {"draw_view_slots", bench_draw_view_slots, false},
+};
+
+#define NUM_BENCHMARKS (sizeof(s_benchmarks) / sizeof(s_benchmarks[0]))
+
+/*******************************************************************************
+   Function: get_time_ns
+
+Description: Returns the host's monotonic clock reading.
+
+     Inputs: None.
+
+    Outputs: Time in nanoseconds.
+*******************************************************************************/
+static int64_t get_time_ns(void) {
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return now.tv_sec * NANOSECONDS_PER_SECOND + now.tv_nsec;
+}
+
+/*******************************************************************************
+   Function: generate_mission
+
+Description: Generates a seeded mission location with a given no. of NPCs at
+             random open cells and the player at its entrance, then picks the
+             benchmark inputs: random cells (some of them out of bounds) and
+             random occupiable cells.
+
+     Inputs: seed     - Random seed for the mission.
+             num_npcs - No. of NPCs to place.
+
+    Outputs: None.
+*******************************************************************************/
+static void generate_mission(const int32_t seed, const int8_t num_npcs) {
+  int32_t i;
+  GPoint cell;
+
+  srand(seed);
+  for (i = 0; i < MAX_NPCS_AT_ONE_TIME; ++i) {
+    g_mission->npcs[i].type = NONE;
+  }
+  g_mission->completed = false;
+  init_mission_location();
+  g_player->position = g_mission->entrance;
+  set_player_direction(get_opposite_direction(g_mission->entrance_direction));
+  g_player->stats[CURRENT_HP] = g_player->stats[MAX_HP] = MAX_SMALL_INT_VALUE;
+  for (i = 0; i < MAX_NPCS_AT_ONE_TIME; ++i) {
+    g_mission->npcs[i].type = NONE;  // Discard any the script placed.
+  }
+  s_num_open_cells = 0;
+  for (i = 0; i < NUM_INPUT_CELLS * 8; ++i) {
+    cell = GPoint(rand() % (LOCATION_WIDTH + 2) - 1,
+                  rand() % (LOCATION_HEIGHT + 2) - 1);
+    if (i < NUM_INPUT_CELLS) {
+      s_input_cells[i] = cell;
+    }
+    if (s_num_open_cells < NUM_INPUT_CELLS && occupiable(cell)) {
+      s_open_cells[s_num_open_cells++] = cell;
+    }
+  }
+  for (i = 0; i < num_npcs; ++i) {
+    add_new_npc(rand() % NUM_NPC_TYPES, s_open_cells[rand() %
+                                                     s_num_open_cells]);
+  }
+  init_mission_history();
+  update_blackboard();
+  s_saved_mission = *g_mission;
+  s_saved_history = g_mission_history;
+  s_saved_player = *g_player;
+}
+
+/*******************************************************************************
+   Function: restore_mission
+
+Description: Restores the mission saved by "generate_mission".
+
+     Inputs: None.
+
+    Outputs: None.
+*******************************************************************************/
+static void restore_mission(void) {
+  *g_mission = s_saved_mission;
+  g_mission_history = s_saved_history;
+  *g_player = s_saved_player;
+  compute_distance_field(g_exit_distances, &g_mission->entrance, 1);
+  update_blackboard();
+}
+
+/*******************************************************************************
+   Function: run_benchmark
+
+Description: Times a benchmark over "CALLS_PER_MISSION" calls on the current
+             mission.
+
+     Inputs: benchmark - The benchmark to run.
+
+    Outputs: Total time spent in the benchmarked calls, in nanoseconds.
+*******************************************************************************/
+static int64_t run_benchmark(const benchmark_t *benchmark) {
+  int32_t i, j;
+  int64_t start, total = 0;
+
+  if (!benchmark->mutating) {
+    start = get_time_ns();
+    for (i = 0; i < CALLS_PER_MISSION; ++i) {
+      benchmark->function(i);
+    }
+    total = get_time_ns() - start;
+    restore_mission();
+
+    return total;
+  }
+  for (i = 0; i < CALLS_PER_MISSION; i += MUTATING_BATCH_SIZE) {
+    start = get_time_ns();
+    for (j = i; j < i + MUTATING_BATCH_SIZE; ++j) {
+      benchmark->function(j);
+    }
+    total += get_time_ns() - start;
+    restore_mission();
+  }
+
+  return total;
+}
+
+/*******************************************************************************
+   Function: main
+
+Description: Runs every benchmark at every NPC density and prints the results
+             as JSON.
+
+     Inputs: argc - No. of command-line arguments.
+             argv - Command-line arguments.
+
+    Outputs: Zero on success, one on failure.
+*******************************************************************************/
+int main(int argc, char **argv) {
+  const int32_t seed = argc > 1 ? atoi(argv[1]) : DEFAULT_SEED;
+  int32_t i, mission;
+  int8_t num_npcs;
+  int64_t total_ns;
+
+  host_reset();
+  host_set_log_enabled(false);
+  init();
+  for (i = 0;
+       i < MAX_MENU_PRESSES &&
+         window_stack_get_top_window() != g_graphics_window;
+       ++i) {
+    host_press_button(BUTTON_ID_SELECT, HOST_SINGLE_CLICK);  // Intro, etc.
+  }
+  if (g_mission == NULL) {
+    fprintf(stderr, "Failed to start a mission.\n");
+
+    return 1;
+  }
+  tick_timer_service_unsubscribe();
+
+  printf("{\n");
+#ifdef PBL_COLOR
+  printf("  \"platform\": \"basalt\",\n");
+#else
+  printf("  \"platform\": \"aplite\",\n");
+#endif
+  printf("  \"seed\": %ld,\n", (long) seed);
+#ifdef VIEW_SLOT_ROUTINES
+  printf("  \"view_slot_routines\": \"generated\",\n");
+#else
+  printf("  \"view_slot_routines\": \"generic\",\n");
+#endif
+  printf("  \"missions_per_density\": %d,\n", NUM_MISSIONS);
+  printf("  \"calls_per_mission\": %d,\n", CALLS_PER_MISSION);
+  printf("  \"results\": [");
+  for (i = 0; i < (int32_t) NUM_BENCHMARKS; ++i) {
+    for (num_npcs = 0; num_npcs <= MAX_NPCS_AT_ONE_TIME; ++num_npcs) {
+      total_ns = 0;
+      for (mission = 0; mission < NUM_MISSIONS; ++mission) {
+        generate_mission(seed * NUM_MISSIONS + mission, num_npcs);
+        total_ns += run_benchmark(&s_benchmarks[i]);
+      }
+      printf("%s\n    {\"name\": \"%s\", \"npcs\": %d, "
+               "\"ns_per_call\": %.1f}",
+             i == 0 && num_npcs == 0 ? "" : ",",
+             s_benchmarks[i].name,
+             num_npcs,
+             (double) total_ns / (NUM_MISSIONS * CALLS_PER_MISSION));
+    }
+  }
+  printf("\n  ]\n}\n");
+
+  return 0;
+}
@@ -0,0 +1,242 @@
+/*******************************************************************************
+   Filename: mission_scripts.c
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Build-time assembler for SpaceMerc's mission scripts. Each mission
+             type's objectives, reward and reinforcements are written here with
+             a few emitter helpers and saved as "mission_N.bin", the bytecode
+             run by "run_script_thread" (see the opcode list in
+             "space_merc.h").
+
+      Usage: mission_scripts <output directory>
+*******************************************************************************/
+
+#include "pebble.h"
+
+#define main space_merc_main
+#include "space_merc.c"
+#undef main
+
+#define MAX_PATH_LENGTH                  256
+#define REWARD_PER_NPC                   600  // $3-12,000 per mission.
+#define REINFORCEMENT_CHANCE             5  // 1 in 5 per tick.
+
+static uint8_t s_script[MAX_SCRIPT_SIZE];
+static uint16_t s_script_size;
+static bool s_script_overflow;
+
+/*******************************************************************************
+   Function: emit_byte
+
+Description: Appends a byte to the script being assembled.
+
+     Inputs: byte - The byte to append.
+
+    Outputs: None.
+*******************************************************************************/
+static void emit_byte(const uint8_t byte) {
+  if (s_script_size == MAX_SCRIPT_SIZE) {
+    s_script_overflow = true;
+  } else {
+    s_script[s_script_size++] = byte;
+  }
+}
+
+/*******************************************************************************
+   Function: emit
+
+Description: Appends an instruction, with its operand (if the opcode takes
+             one), to the script being assembled.
+
+     Inputs: opcode  - The instruction's opcode.
+             operand - The instruction's operand, if any.
+
+    Outputs: Offset of the operand within the script, for use with
+             "patch_jump".
+*******************************************************************************/
+static uint16_t emit(const uint8_t opcode, const int16_t operand) {
+  const uint16_t operand_offset = s_script_size + 1;
+
+  emit_byte(opcode);
+  if (g_script_opcode_formats[opcode][OPERAND_SIZE] > 0) {
+    emit_byte(operand & 0xFF);
+  }
+  if (g_script_opcode_formats[opcode][OPERAND_SIZE] > 1) {
+    emit_byte((operand >> 8) & 0xFF);
+  }
+
+  return operand_offset;
+}
+
+/*******************************************************************************
+   Function: patch_jump
+
+Description: Points a previously emitted forward jump at the next instruction
+             to be emitted.
+
+     Inputs: operand_offset - Offset of the jump's operand.
+
+    Outputs: None.
+*******************************************************************************/
+static void patch_jump(const uint16_t operand_offset) {
+  s_script[operand_offset] = s_script_size & 0xFF;
+  s_script[operand_offset + 1] = s_script_size >> 8;
+}
+
+/*******************************************************************************
+   Function: begin_event
+
+Description: Makes the next instruction to be emitted the entry point for a
+             given event.
+
+     Inputs: event - The event type.
+
+    Outputs: None.
+*******************************************************************************/
+static void begin_event(const int8_t event) {
+  s_script[event * 2] = s_script_size & 0xFF;
+  s_script[event * 2 + 1] = s_script_size >> 8;
+}
+
+/*******************************************************************************
+   Function: emit_reinforcements
+
+Description: Emits the main thread shared by all mission types: each tick, while
+             fewer than "MAX_NPCS_AT_ONE_TIME" enemies are present and more
+             remain to be fought, there's a chance another one arrives.
+
+     Inputs: None.
+
+    Outputs: None.
+*******************************************************************************/
+static void emit_reinforcements(void) {
+  uint16_t loop, skip[3];
+
+  begin_event(SCRIPT_TICK);
+  loop = s_script_size;
+  emit(OP_GET, VALUE_NPCS_PRESENT);
+  emit(OP_PUSH, MAX_NPCS_AT_ONE_TIME);
+  emit(OP_LESS, 0);
+  skip[0] = emit(OP_JUMP_IF_NOT, 0);
+  emit(OP_GET, VALUE_KILLS);
+  emit(OP_GET, VALUE_NPCS_PRESENT);
+  emit(OP_ADD, 0);
+  emit(OP_GET, VALUE_TOTAL_NPCS);
+  emit(OP_LESS, 0);
+  skip[1] = emit(OP_JUMP_IF_NOT, 0);
+  emit(OP_PUSH, REINFORCEMENT_CHANCE);
+  emit(OP_RANDOM, 0);
+  emit(OP_PUSH, 0);
+  emit(OP_EQUAL, 0);
+  skip[2] = emit(OP_JUMP_IF_NOT, 0);
+  emit(OP_PUSH, NUM_NPC_TYPES - 1);  // Excludes ALIEN_OFFICER.
+  emit(OP_RANDOM, 0);
+  emit(OP_SPAWN, 0);
+  patch_jump(skip[0]);
+  patch_jump(skip[1]);
+  patch_jump(skip[2]);
+  emit(OP_PUSH, 1);
+  emit(OP_WAIT, 0);
+  emit(OP_JUMP, loop);
+}
+
+/*******************************************************************************
+   Function: assemble_mission_script
+
+Description: Assembles the script for a given mission type into "s_script".
+
+     Inputs: type - The mission type.
+
+    Outputs: None.
+*******************************************************************************/
+static void assemble_mission_script(const int8_t type) {
+  uint16_t skip;
+
+  memset(s_script, 0xFF, SCRIPT_HEADER_SIZE);  // No entry points yet.
+  s_script_size = SCRIPT_HEADER_SIZE;
+  s_script_overflow = false;
+
+  // Start: set the reward and place any mission target at the far end.
+  begin_event(SCRIPT_START);
+  emit(OP_PUSH, REWARD_PER_NPC);
+  emit(OP_GET, VALUE_TOTAL_NPCS);
+  emit(OP_MUL, 0);
+  emit(OP_SET_REWARD, 0);
+  if (type == ASSASSINATE) {
+    emit(OP_PUSH, ALIEN_OFFICER);
+    emit(OP_SPAWN_AT_EVENT, 0);
+  } else if (type == EXPROPRIATE) {
+    emit(OP_PUSH, ITEM);
+    emit(OP_PLACE_AT_EVENT, 0);
+  } else if (type == EXTRICATE) {
+    emit(OP_PUSH, HUMAN);
+    emit(OP_PLACE_AT_EVENT, 0);
+  }
+  emit(OP_END, 0);
+
+  emit_reinforcements();
+
+  // Objectives:
+  if (type == RETALIATE || type == OBLITERATE) {
+    begin_event(SCRIPT_KILL);  // Complete once every enemy is dead.
+    emit(OP_GET, VALUE_KILLS);
+    emit(OP_GET, VALUE_TOTAL_NPCS);
+    emit(OP_LESS, 0);
+    emit(OP_NOT, 0);
+    skip = emit(OP_JUMP_IF_NOT, 0);
+    emit(OP_COMPLETE, 0);
+    patch_jump(skip);
+    emit(OP_END, 0);
+  } else if (type == ASSASSINATE) {
+    begin_event(SCRIPT_KILL);  // Complete once the officer is dead.
+    emit(OP_GET, VALUE_EVENT_ARG);
+    emit(OP_PUSH, ALIEN_OFFICER);
+    emit(OP_EQUAL, 0);
+    skip = emit(OP_JUMP_IF_NOT, 0);
+    emit(OP_COMPLETE, 0);
+    patch_jump(skip);
+    emit(OP_END, 0);
+  } else {
+    begin_event(SCRIPT_PICKUP);  // Complete once the target is reached.
+    emit(OP_COMPLETE, 0);
+    emit(OP_END, 0);
+  }
+}
+
+/*******************************************************************************
+   Function: main
+
+Description: Assembles and writes the script for every mission type.
+
+     Inputs: argc - No. of command-line arguments.
+             argv - Command-line arguments.
+
+    Outputs: Zero on success, one on failure.
+*******************************************************************************/
+int main(int argc, char **argv) {
+  int8_t type;
+  char path[MAX_PATH_LENGTH];
+  FILE *file;
+
+  if (argc != 2) {
+    fprintf(stderr, "Usage: %s <output directory>\n", argv[0]);
+
+    return 1;
+  }
+  for (type = 0; type < NUM_MISSION_TYPES; ++type) {
+    assemble_mission_script(type);
+    snprintf(path, MAX_PATH_LENGTH, "%s/mission_%d.bin", argv[1], type);
+    file = fopen(path, "wb");
+    if (s_script_overflow ||
+        file == NULL      ||
+        fwrite(s_script, 1, s_script_size, file) != s_script_size) {
+      fprintf(stderr, "Failed to write \"%s\".\n", path);
+
+      return 1;
+    }
+    fclose(file);
+  }
+
+  return 0;
+}
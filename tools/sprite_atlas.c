@@ -0,0 +1,312 @@
+/*******************************************************************************
+   Filename: sprite_atlas.c
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Build-time generator for SpaceMerc's sprite atlas. Runs the game's
+             own "draw_sprite" code against the host SDK stand-in and writes
+             one PNG strip per sprite type and visual depth, holding every
+             animation frame stacked top to bottom. Color strips are
+             palettized with a transparent entry; black-and-white strips are
+             1-bit, with a matching stack of opacity masks beneath the frames.
+
+      Usage: sprite_atlas <output directory> <platform name>
+*******************************************************************************/
+
+#include <zlib.h>
+
+#include "pebble.h"
+#include "host_shim.h"
+
+#define main space_merc_main
+#include "space_merc.c"
+#undef main
+
+#define MAX_PATH_LENGTH                  256
+#ifdef PBL_COLOR
+#define PNG_BIT_DEPTH                    8
+#define PNG_COLOR_TYPE                   3  // Palettized.
+#define TRANSPARENT_INDEX                0
+#else
+#define PNG_BIT_DEPTH                    1
+#define PNG_COLOR_TYPE                   0  // Grayscale.
+#endif
+
+/*******************************************************************************
+   Function: write_png_chunk
+
+Description: Writes a single PNG chunk, including its length and CRC.
+
+     Inputs: file - The output file.
+             type - Four-character chunk type.
+             data - Chunk data.
+             size - No. of bytes of chunk data.
+
+    Outputs: None.
+*******************************************************************************/
+static void write_png_chunk(FILE *file,
+                            const char *type,
+                            const uint8_t *data,
+                            const uint32_t size) {
+  const uint8_t size_bytes[4] = {size >> 24, size >> 16, size >> 8, size};
+  uint32_t crc = crc32(0, (const Bytef *) type, 4);
+  uint8_t crc_bytes[4];
+
+  crc = crc32(crc, data, size);
+  crc_bytes[0] = crc >> 24;
+  crc_bytes[1] = crc >> 16;
+  crc_bytes[2] = crc >> 8;
+  crc_bytes[3] = crc;
+  fwrite(size_bytes, 1, 4, file);
+  fwrite(type, 1, 4, file);
+  fwrite(data, 1, size, file);
+  fwrite(crc_bytes, 1, 4, file);
+}
+
+/*******************************************************************************
+   Function: write_png
+
+Description: Writes an unfiltered PNG image. On color platforms, "pixels" holds
+             one palette index per pixel; on black-and-white platforms, one
+             byte per pixel that is either 0 (black) or 1 (white).
+
+     Inputs: path       - Output file path.
+             pixels     - Pixel values, row by row.
+             width      - Image width.
+             height     - Image height.
+             palette    - RGBA palette entries (color platforms only).
+             num_colors - No. of palette entries (color platforms only).
+
+    Outputs: "True" if the file was written successfully.
+*******************************************************************************/
+static bool write_png(const char *path,
+                      const uint8_t *pixels,
+                      const int16_t width,
+                      const int16_t height,
+                      const uint8_t palette[][4],
+                      const int16_t num_colors) {
+  const int32_t row_size = 1 + (width * PNG_BIT_DEPTH + 7) / 8;
+  uLongf compressed_size = compressBound(row_size * height);
+  uint8_t *raw = calloc(row_size, height),
+          *compressed = malloc(compressed_size),
+          header[13] = {0, 0, width >> 8, width, 0, 0, height >> 8, height,
+                        PNG_BIT_DEPTH, PNG_COLOR_TYPE, 0, 0, 0};
+  int16_t x, y;
+  FILE *file = fopen(path, "wb");
+  bool success = false;
+#ifdef PBL_COLOR
+  uint8_t plte[256 * 3], trns[256];
+  int16_t i;
+#endif
+
+  if (file == NULL || raw == NULL || compressed == NULL) {
+    goto done;
+  }
+  for (y = 0; y < height; ++y) {
+    for (x = 0; x < width; ++x) {
+#ifdef PBL_COLOR
+      raw[y * row_size + 1 + x] = pixels[y * width + x];
+#else
+      raw[y * row_size + 1 + x / 8] |= pixels[y * width + x] << (7 - x % 8);
+#endif
+    }
+  }
+  if (compress2(compressed,
+                &compressed_size,
+                raw,
+                row_size * height,
+                Z_BEST_COMPRESSION) != Z_OK) {
+    goto done;
+  }
+  fwrite("\x89PNG\r\n\x1a\n", 1, 8, file);
+  write_png_chunk(file, "IHDR", header, sizeof(header));
+#ifdef PBL_COLOR
+  for (i = 0; i < num_colors; ++i) {
+    memcpy(plte + i * 3, palette[i], 3);
+    trns[i] = palette[i][3];
+  }
+  write_png_chunk(file, "PLTE", plte, num_colors * 3);
+  write_png_chunk(file, "tRNS", trns, num_colors);
+#endif
+  write_png_chunk(file, "IDAT", compressed, compressed_size);
+  write_png_chunk(file, "IEND", NULL, 0);
+  success = !ferror(file);
+
+done:
+  if (file != NULL) {
+    fclose(file);
+  }
+  free(raw);
+  free(compressed);
+
+  return success;
+}
+
+/*******************************************************************************
+   Function: write_sprite_strip
+
+Description: Rasterizes every animation frame of a given sprite type at a given
+             visual depth and writes them out as a single PNG strip. Each
+             frame is drawn straight ahead twice, once over black and once
+             over white: pixels that match in both passes belong to the
+             sprite, the rest are transparent. (A sprite's appearance depends
+             only on its depth; its left-right position merely shifts it.)
+
+     Inputs: ctx          - Pointer to the host graphics context.
+             sprite_index - Index of the sprite type.
+             depth        - Front-back visual depth in "g_back_wall_coords".
+             path         - Output file path.
+
+    Outputs: "True" if the strip was written successfully.
+*******************************************************************************/
+static bool write_sprite_strip(GContext *ctx,
+                               const int8_t sprite_index,
+                               const int8_t depth,
+                               const char *path) {
+  const int8_t num_frames = g_num_sprite_frames[sprite_index],
+               content_type = sprite_index < NUM_NPC_TYPES ?
+                                sprite_index :
+                                HUMAN + sprite_index - NUM_NPC_TYPES;
+  GPoint floor_center_point = get_floor_center_point(depth, STRAIGHT_AHEAD);
+  GRect bounds;
+  GBitmap *frame_buffer;
+  uint8_t *pixels, *frame_buffer_row, *pixel, value;
+  int8_t frame, pass;
+  int16_t x, y;
+  bool success;
+#ifdef PBL_COLOR
+  uint8_t palette[256][4] = {{0, 0, 0, 0}};  // Entry 0 is transparent.
+  int16_t num_colors = 1, color_indices[256];
+  GColor color;
+#else
+  uint8_t *mask;
+#endif
+
+  floor_center_point.y += STATUS_BAR_HEIGHT;
+  bounds = get_sprite_bounds(floor_center_point,
+                             get_drawing_unit(depth, STRAIGHT_AHEAD));
+#ifdef PBL_COLOR
+  pixels = calloc(bounds.size.w, bounds.size.h * num_frames);
+  memset(color_indices, -1, sizeof(color_indices));
+#else
+  pixels = calloc(bounds.size.w, bounds.size.h * num_frames * 2);
+#endif
+  if (pixels == NULL) {
+    return false;
+  }
+  for (frame = 0; frame < num_frames; ++frame) {
+    for (pass = 0; pass < 2; ++pass) {
+      graphics_context_set_fill_color(ctx, pass ? GColorWhite : GColorBlack);
+      graphics_fill_rect(ctx, bounds, NO_CORNER_RADIUS, GCornerNone);
+      draw_sprite(ctx, content_type, depth, STRAIGHT_AHEAD, frame);
+      frame_buffer = graphics_capture_frame_buffer(ctx);
+      for (y = 0; y < bounds.size.h; ++y) {
+        frame_buffer_row = gbitmap_get_data(frame_buffer) +
+          (bounds.origin.y + y) * gbitmap_get_bytes_per_row(frame_buffer);
+        for (x = 0; x < bounds.size.w; ++x) {
+          pixel = pixels + (frame * bounds.size.h + y) * bounds.size.w + x;
+#ifdef PBL_COLOR
+          value = frame_buffer_row[bounds.origin.x + x];
+          if (pass == 0) {
+            *pixel = value;
+          } else if (*pixel != value) {
+            *pixel = GColorClear.argb;
+          }
+#else
+          mask = pixel + num_frames * bounds.size.h * bounds.size.w;
+          value = (frame_buffer_row[(bounds.origin.x + x) / 8] >>
+                    ((bounds.origin.x + x) % 8)) & 1;
+          if (pass == 0) {
+            *pixel = value;
+          } else {
+            *mask = *pixel == value;  // Opaque.
+            *pixel &= *mask;
+          }
+#endif
+        }
+      }
+      graphics_release_frame_buffer(ctx, frame_buffer);
+    }
+  }
+
+#ifdef PBL_COLOR
+  // Convert each pixel's color to a palette index:
+  for (pixel = pixels;
+       pixel < pixels + bounds.size.w * bounds.size.h * num_frames;
+       ++pixel) {
+    color = (GColor) {.argb = *pixel};
+    if (color.a == 0) {
+      *pixel = TRANSPARENT_INDEX;
+      continue;
+    }
+    if (color_indices[color.argb] < 0) {
+      palette[num_colors][0] = color.r * 85;
+      palette[num_colors][1] = color.g * 85;
+      palette[num_colors][2] = color.b * 85;
+      palette[num_colors][3] = 255;
+      color_indices[color.argb] = num_colors++;
+    }
+    *pixel = color_indices[color.argb];
+  }
+  success = write_png(path,
+                      pixels,
+                      bounds.size.w,
+                      bounds.size.h * num_frames,
+                      palette,
+                      num_colors);
+#else
+  success = write_png(path,
+                      pixels,
+                      bounds.size.w,
+                      bounds.size.h * num_frames * 2,
+                      NULL,
+                      0);
+#endif
+  free(pixels);
+
+  return success;
+}
+
+/*******************************************************************************
+   Function: main
+
+Description: Writes a PNG strip for every sprite type at every visual depth,
+             named "strip_NN~<platform>.png" where "NN" is the strip's offset
+             from "RESOURCE_ID_SPRITE_STRIP_0".
+
+     Inputs: argc - No. of command-line arguments.
+             argv - Command-line arguments.
+
+    Outputs: Zero on success, one on failure.
+*******************************************************************************/
+int main(int argc, char **argv) {
+  int8_t sprite_index, depth;
+  char path[MAX_PATH_LENGTH];
+  GContext *ctx;
+
+  if (argc != 3) {
+    fprintf(stderr, "Usage: %s <output directory> <platform name>\n", argv[0]);
+
+    return 1;
+  }
+  host_reset();
+  init_wall_coords();
+  ctx = host_graphics_context();
+  for (sprite_index = 0; sprite_index < NUM_SPRITE_TYPES; ++sprite_index) {
+    for (depth = 0; depth < MAX_VISIBILITY_DEPTH - 1; ++depth) {
+      snprintf(path,
+               MAX_PATH_LENGTH,
+               "%s/strip_%02d~%s.png",
+               argv[1],
+               sprite_index * (MAX_VISIBILITY_DEPTH - 1) + depth,
+               argv[2]);
+      if (!write_sprite_strip(ctx, sprite_index, depth, path)) {
+        fprintf(stderr, "Failed to write \"%s\".\n", path);
+
+        return 1;
+      }
+    }
+  }
+
+  return 0;
+}
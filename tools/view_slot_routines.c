@@ -0,0 +1,503 @@
+/*******************************************************************************
+   Filename: view_slot_routines.c
+
+     Author: David C. Drake (https://davidcdrake.com)
+
+Description: Build-time generator for SpaceMerc's view slot routines. Lays out
+             every view slot from the game's own "g_back_wall_coords" and
+             writes "view_slot_routines.h": one routine per slot doing what
+             "draw_view_slot" does for it, with the slot's wall, door, corner
+             and floor coordinates folded into constants and every branch on
+             the slot itself resolved here, plus "g_view_slot_routines", the
+             table indexed by slot that "draw_view_slot" dispatches through
+             in builds with "VIEW_SLOT_ROUTINES" defined.
+
+      Usage: view_slot_routines <output file>
+*******************************************************************************/
+
+#include "pebble.h"
+#include "host_shim.h"
+
+#define main space_merc_main
+#include "space_merc.c"
+#undef main
+
+static FILE *s_file;
+
+/*******************************************************************************
+   Function: emit_point
+
+Description: Writes a constant "GPoint", shifted down below the status bar.
+
+     Inputs: indent - Indentation preceding it.
+             x      - Horizontal coordinate.
+             y      - Vertical coordinate within the graphics frame.
+             last   - "True" if it's the last argument of a call.
+
+    Outputs: None.
+*******************************************************************************/
+static void emit_point(const char *indent,
+                       const int16_t x,
+                       const int16_t y,
+                       const bool last) {
+  fprintf(s_file,
+          "%sGPoint(%d, %d)%s\n",
+          indent,
+          x,
+          y + STATUS_BAR_HEIGHT,
+          last ? ");" : ",");
+}
+
+/*******************************************************************************
+   Function: emit_quad
+
+Description: Writes a call to a quad-drawing function with constant corners.
+
+     Inputs: call     - Start of the call, up to its first corner.
+             corners  - Corners as x, y pairs: top left, bottom left, top
+                        right, bottom right.
+             last_arg - Any arguments after the corners (e.g., a color), or
+                        NULL to close the quad with its first corner (as
+                        "draw_shaded_quad" expects).
+
+    Outputs: None.
+*******************************************************************************/
+static void emit_quad(const char *call,
+                      const int16_t corners[8],
+                      const char *last_arg) {
+  const int indent_length = strchr(call, '(') - call + 1;
+  char indent[32];
+  int8_t i;
+
+  snprintf(indent, sizeof(indent), "%*s", indent_length, "");
+  fprintf(s_file, "%s\n", call);
+  for (i = 0; i < 4; ++i) {
+    emit_point(indent, corners[i * 2], corners[i * 2 + 1], false);
+  }
+  if (last_arg == NULL) {
+    emit_point(indent, corners[0], corners[1], true);
+  } else {
+    fprintf(s_file, "%s%s);\n", indent, last_arg);
+  }
+}
+
+/*******************************************************************************
+   Function: emit_line
+
+Description: Writes a call drawing a line between two constant points.
+
+     Inputs: x1 - Horizontal coordinate of the first point.
+             y1 - Vertical coordinate of the first point.
+             x2 - Horizontal coordinate of the second point.
+             y2 - Vertical coordinate of the second point.
+
+    Outputs: None.
+*******************************************************************************/
+static void emit_line(const int16_t x1,
+                      const int16_t y1,
+                      const int16_t x2,
+                      const int16_t y2) {
+  fprintf(s_file, "      graphics_draw_line(ctx,\n");
+  emit_point("                         ", x1, y1, false);
+  emit_point("                         ", x2, y2, true);
+}
+
+/*******************************************************************************
+   Function: emit_wall_start
+
+Description: Writes the start of a wall: the check for a solid cell beside the
+             slot's cell, and the textured (or else shaded) face.
+
+     Inputs: depth     - Front-back visual depth of the slot.
+             position  - Left-right visual position of the slot.
+             face      - BACK_WALL, LEFT_WALL or RIGHT_WALL.
+             direction - Name of the variable holding the direction of the
+                         cell on the wall's far side, or NULL for the back
+                         wall (whose far side is "cell_2").
+             corners   - The face's corners (see "emit_quad").
+
+    Outputs: None.
+*******************************************************************************/
+static void emit_wall_start(const int8_t depth,
+                            const int8_t position,
+                            const int8_t face,
+                            const char *direction,
+                            const int16_t corners[8]) {
+  static const char *const face_names[] = {"BACK_WALL",
+                                           "LEFT_WALL",
+                                           "RIGHT_WALL"};
+
+  if (direction == NULL) {
+    fprintf(s_file, "    if (get_cell_type(cell_2) >= SOLID) {\n");
+  } else {
+    fprintf(s_file,
+            "    if (get_cell_type(get_cell_farther_away(cell,\n"
+            "%44s%s,\n"
+            "%44s1)) >= SOLID) {\n",
+            "",
+            direction,
+            "");
+  }
+  fprintf(s_file,
+          "      if (!draw_wall_face(ctx, %d, %d, %s)) {\n",
+          depth,
+          position,
+          face_names[face]);
+  emit_quad("        draw_shaded_quad(ctx,", corners, NULL);
+  fprintf(s_file,
+          "      }\n"
+          "      graphics_context_set_stroke_color(ctx, GColorBlack);\n");
+}
+
+/*******************************************************************************
+   Function: emit_door_start
+
+Description: Writes the check for an exit door on a wall, falling back on a
+             plain one where no door texture applies.
+
+     Inputs: depth     - Front-back visual depth of the slot.
+             position  - Left-right visual position of the slot.
+             face      - BACK_WALL, LEFT_WALL or RIGHT_WALL.
+             direction - Expression for the direction the wall faces.
+
+    Outputs: None.
+*******************************************************************************/
+static void emit_door_start(const int8_t depth,
+                            const int8_t position,
+                            const char *face,
+                            const char *direction) {
+  fprintf(s_file,
+          "      if (exit_present &&\n"
+          "          %s == g_mission->entrance_direction &&\n"
+          "          !draw_wall_door(ctx, %d, %d, %s)) {\n",
+          direction,
+          depth,
+          position,
+          face);
+}
+
+/*******************************************************************************
+   Function: emit_wall_end
+
+Description: Writes the end of a wall: its columns noted for compositing (see
+             "record_wall_columns") and the flag noting it was drawn.
+
+     Inputs: left  - First screen column of the wall.
+             right - Last screen column of the wall.
+             flag  - Name of the flag to set, or NULL if none is needed.
+
+    Outputs: None.
+*******************************************************************************/
+static void emit_wall_end(const int16_t left,
+                          const int16_t right,
+                          const char *flag) {
+  fprintf(s_file, "      record_wall_columns(%d, %d);\n", left, right);
+  if (flag != NULL) {
+    fprintf(s_file, "      %s = true;\n", flag);
+  }
+  fprintf(s_file, "    }\n");
+}
+
+/*******************************************************************************
+   Function: emit_corner
+
+Description: Writes the vertical line at a corner of the back wall, drawn where
+             a wall meets an opening (see "draw_cell_walls").
+
+     Inputs: x          - Screen column of the corner.
+             top        - Top of the back wall.
+             bottom     - Bottom of the back wall.
+             side_wall  - Name of the side wall's flag, or NULL if there's no
+                          side wall at this slot.
+             direction  - Expression for the direction of the side.
+             downward   - "True" to draw the line from the top down.
+
+    Outputs: None.
+*******************************************************************************/
+static void emit_corner(const int16_t x,
+                        const int16_t top,
+                        const int16_t bottom,
+                        const char *side_wall,
+                        const char *direction,
+                        const bool downward) {
+  const char *opening_format =
+    "get_cell_type(get_cell_farther_away(cell_2, %s, 1)) <\n"
+    "           SOLID";
+
+  if (side_wall == NULL) {
+    fprintf(s_file, "    if (back_wall_drawn &&\n        ");
+    fprintf(s_file, opening_format, direction);
+  } else {
+    fprintf(s_file,
+            "    if ((back_wall_drawn && %s) ||\n"
+            "        ((back_wall_drawn || %s) &&\n         ",
+            side_wall,
+            side_wall);
+    fprintf(s_file, opening_format, direction);
+    fprintf(s_file, ")");
+  }
+  fprintf(s_file, ") {\n");
+  emit_line(x, downward ? top : bottom, x, downward ? bottom : top);
+  fprintf(s_file, "    }\n");
+}
+
+/*******************************************************************************
+   Function: emit_walls
+
+Description: Writes the walls part of a slot's routine, following
+             "draw_cell_walls" with the slot fixed.
+
+     Inputs: depth    - Front-back visual depth of the slot.
+             position - Left-right visual position of the slot.
+
+    Outputs: None.
+*******************************************************************************/
+static void emit_walls(const int8_t depth, const int8_t position) {
+  const int16_t back_left = g_back_wall_coords[depth][position][TOP_LEFT].x,
+                back_right =
+                  g_back_wall_coords[depth][position][BOTTOM_RIGHT].x,
+                top = g_back_wall_coords[depth][position][TOP_LEFT].y,
+                bottom = g_back_wall_coords[depth][position][BOTTOM_RIGHT].y,
+                exit_offset_y = (back_right - back_left) / 4;
+  const bool left_wall = position <= STRAIGHT_AHEAD,
+             right_wall = position >= STRAIGHT_AHEAD;
+  int16_t left, right, y_offset, exit_offset_x, corners[8];
+
+  if (bottom - top < MIN_WALL_HEIGHT) {
+    return;
+  }
+  fprintf(s_file,
+          "  if (g_scene_pass != SPRITE_LIST_PASS) {\n"
+          "    bool back_wall_drawn = false%s%s;\n\n",
+          left_wall ? ",\n         left_wall_drawn = false" : "",
+          right_wall ? ",\n         right_wall_drawn = false" : "");
+
+  // Back wall:
+  left = back_left;
+  right = back_right;
+  corners[0] = corners[2] = left;
+  corners[4] = corners[6] = right;
+  corners[1] = corners[5] = top;
+  corners[3] = corners[7] = bottom;
+  fprintf(s_file, "    // Back wall:\n");
+  emit_wall_start(depth, position, BACK_WALL, NULL, corners);
+  emit_line(left, top, right, top);
+  emit_line(left, bottom, right, bottom);
+  if (top == g_back_wall_coords[1][0][TOP_LEFT].y) {
+    emit_line(left, bottom + 1, right, bottom + 1);  // See "draw_cell_walls".
+  }
+  emit_door_start(depth, position, "BACK_WALL", "g_player->direction");
+  exit_offset_x = (right - left) / 3;
+  fprintf(s_file,
+          "        graphics_context_set_fill_color(ctx, GColorBlack);\n"
+          "        graphics_fill_rect(ctx,\n"
+          "                           GRect(%d, %d, %d, %d),\n"
+          "                           NO_CORNER_RADIUS,\n"
+          "                           GCornerNone);\n"
+          "      }\n",
+          left + exit_offset_x,
+          top + exit_offset_y + STATUS_BAR_HEIGHT,
+          exit_offset_x,
+          bottom - top - exit_offset_y);
+  emit_wall_end(left, right, "back_wall_drawn");
+
+  // Left wall:
+  right = back_left;
+  if (depth == 0) {
+    left = 0;
+    y_offset = top;
+  } else {
+    left = g_back_wall_coords[depth - 1][position][TOP_LEFT].x;
+    y_offset = top - g_back_wall_coords[depth - 1][position][TOP_LEFT].y;
+  }
+  if (left_wall) {
+    corners[0] = corners[2] = left;
+    corners[4] = corners[6] = right;
+    corners[1] = top - y_offset;
+    corners[3] = bottom + y_offset;
+    corners[5] = top;
+    corners[7] = bottom;
+    fprintf(s_file, "\n    // Left wall:\n");
+    emit_wall_start(depth, position, LEFT_WALL, "left_direction", corners);
+    emit_line(left, top - y_offset, right, top);
+    emit_line(left, bottom + y_offset, right, bottom);
+    emit_door_start(depth, position, "LEFT_WALL", "left_direction");
+    exit_offset_x = (right - left) / 3;
+    corners[0] = corners[2] = depth == 0 ? 0 : left + exit_offset_x;
+    corners[4] = corners[6] = right - exit_offset_x;
+    corners[1] = top - (depth == 0 ? y_offset - 4 : y_offset / 3) +
+                 exit_offset_y;
+    corners[3] = bottom + (depth == 0 ? y_offset : y_offset / 3);
+    corners[5] = top + exit_offset_y;
+    corners[7] = bottom + 3;
+    emit_quad("        fill_quad(ctx,", corners, "GColorBlack");
+    fprintf(s_file, "      }\n");
+    emit_wall_end(left, right, "left_wall_drawn");
+  }
+
+  // Right wall:
+  left = back_right;
+  right = depth == 0 ? GRAPHICS_FRAME_WIDTH - 1 :
+                       g_back_wall_coords[depth - 1][position][BOTTOM_RIGHT].x;
+  if (right_wall) {
+    corners[0] = corners[2] = left;
+    corners[4] = corners[6] = right;
+    corners[1] = top;
+    corners[3] = bottom;
+    corners[5] = top - y_offset;
+    corners[7] = bottom + y_offset;
+    fprintf(s_file, "\n    // Right wall:\n");
+    emit_wall_start(depth, position, RIGHT_WALL, "right_direction", corners);
+    emit_line(left, top, right, top - y_offset);
+    emit_line(left, bottom, right, bottom + y_offset);
+    emit_door_start(depth, position, "RIGHT_WALL", "right_direction");
+    exit_offset_x = (right - left) / 3;
+    corners[0] = corners[2] = left + exit_offset_x;
+    corners[4] = corners[6] = depth == 0 ? GRAPHICS_FRAME_WIDTH :
+                                           right - exit_offset_x;
+    corners[1] = top + exit_offset_y;
+    corners[3] = bottom + 4;
+    corners[5] = top - (depth == 0 ? y_offset - 5 : y_offset / 3) +
+                 exit_offset_y;
+    corners[7] = bottom + (depth == 0 ? y_offset : y_offset / 3);
+    emit_quad("        fill_quad(ctx,", corners, "GColorBlack");
+    fprintf(s_file, "      }\n");
+    emit_wall_end(left, right, "right_wall_drawn");
+  }
+
+  // Corners:
+  fprintf(s_file,
+          "\n    // Vertical lines at corners:\n"
+          "    graphics_context_set_stroke_color(ctx, GColorBlack);\n");
+  emit_corner(back_left,
+              top,
+              bottom,
+              left_wall ? "left_wall_drawn" : NULL,
+              "left_direction",
+              true);
+  emit_corner(back_right,
+              top,
+              bottom,
+              right_wall ? "right_wall_drawn" : NULL,
+              "right_direction",
+              false);
+  fprintf(s_file, "  }\n");
+}
+
+/*******************************************************************************
+   Function: emit_routine
+
+Description: Writes the routine for a given view slot.
+
+     Inputs: depth    - Front-back visual depth of the slot.
+             position - Left-right visual position of the slot.
+
+    Outputs: None.
+*******************************************************************************/
+static void emit_routine(const int8_t depth, const int8_t position) {
+  GPoint floor_center_point = get_floor_center_point(depth, position);
+  const int16_t top = g_back_wall_coords[depth][position][TOP_LEFT].y,
+                bottom = g_back_wall_coords[depth][position][BOTTOM_RIGHT].y;
+
+  fprintf(s_file,
+          "static void draw_view_slot_%d_%d(GContext *ctx, const GPoint cell) "
+            "{\n",
+          depth,
+          position);
+  if (bottom - top >= MIN_WALL_HEIGHT) {
+    fprintf(s_file,
+            "  const int8_t left_direction =\n"
+            "                 get_direction_to_the_left(g_player->direction),\n"
+            "               right_direction =\n"
+            "                 get_direction_to_the_right(g_player->direction);"
+              "\n"
+            "  const GPoint cell_2 =\n"
+            "    get_cell_farther_away(cell, g_player->direction, 1);\n"
+            "  const bool exit_present = "
+              "gpoint_equal(&cell, &g_mission->entrance);\n\n");
+  }
+  fprintf(s_file, "  g_view_slot_order++;\n");
+  emit_walls(depth, position);
+  fprintf(s_file,
+          "  draw_cell_contents(ctx, cell, %d, %d, GPoint(%d, %d), %d);\n"
+          "}\n\n",
+          depth,
+          position,
+          floor_center_point.x,
+          floor_center_point.y + STATUS_BAR_HEIGHT,
+          get_drawing_unit(depth, position));
+}
+
+/*******************************************************************************
+   Function: slot_visible
+
+Description: Determines whether "draw_view_slots" ever draws a given view slot.
+
+     Inputs: depth    - Front-back visual depth of the slot.
+             position - Left-right visual position of the slot.
+
+    Outputs: "True" if the slot is drawn.
+*******************************************************************************/
+static bool slot_visible(const int8_t depth, const int8_t position) {
+  return abs(position - STRAIGHT_AHEAD) <= depth + 1;
+}
+
+/*******************************************************************************
+   Function: main
+
+Description: Lays out the view slots and writes every routine, then the
+             dispatch table.
+
+     Inputs: argc - No. of command-line arguments.
+             argv - Command-line arguments.
+
+    Outputs: Zero on success, one on failure.
+*******************************************************************************/
+int main(int argc, char **argv) {
+  int8_t depth, position;
+
+  if (argc != 2) {
+    fprintf(stderr, "Usage: %s <output file>\n", argv[0]);
+
+    return 1;
+  }
+  init_wall_coords();
+  s_file = fopen(argv[1], "w");
+  if (s_file == NULL) {
+    fprintf(stderr, "Failed to write \"%s\".\n", argv[1]);
+
+    return 1;
+  }
+  fprintf(s_file,
+          "// Generated by \"tools/view_slot_routines.c\". Do not edit.\n\n");
+  for (depth = 0; depth < MAX_VISIBILITY_DEPTH - 1; ++depth) {
+    for (position = 0; position < STRAIGHT_AHEAD * 2 + 1; ++position) {
+      if (slot_visible(depth, position)) {
+        emit_routine(depth, position);
+      }
+    }
+  }
+  fprintf(s_file,
+          "static const view_slot_routine_t\n"
+          "  g_view_slot_routines[MAX_VISIBILITY_DEPTH - 1]"
+            "[STRAIGHT_AHEAD * 2 + 1] = {\n");
+  for (depth = 0; depth < MAX_VISIBILITY_DEPTH - 1; ++depth) {
+    fprintf(s_file, "  {\n");
+    for (position = 0; position < STRAIGHT_AHEAD * 2 + 1; ++position) {
+      if (slot_visible(depth, position)) {
+        fprintf(s_file, "    draw_view_slot_%d_%d,\n", depth, position);
+      } else {
+        fprintf(s_file, "    NULL,\n");
+      }
+    }
+    fprintf(s_file, "  },\n");
+  }
+  fprintf(s_file, "};\n");
+  if (fclose(s_file) != 0) {
+    fprintf(stderr, "Failed to write \"%s\".\n", argv[1]);
+
+    return 1;
+  }
+
+  return 0;
+}